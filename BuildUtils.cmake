@@ -96,3 +96,21 @@ FUNCTION(GTest_add_target target_name)
     gtest_discover_tests(${target_name})
 
 ENDFUNCTION()
+
+
+#
+# Bench_add_target sets the build path and flags for a benchmark executable
+# and places the result in the ${CMAKE_BINARY_DIR}/bench_bin. Benchmarks keep
+# the warning flags but are optimized and built without the sanitizers
+#
+FUNCTION(Bench_add_target target_name)
+    # run the flags macro
+    set_compiler_flags()
+
+    set_target_properties(
+            ${target_name} PROPERTIES
+            RUNTIME_OUTPUT_DIRECTORY ${CMAKE_BINARY_DIR}/bench_bin
+            COMPILE_OPTIONS "${base_exceptions};-O2"
+    )
+
+ENDFUNCTION()
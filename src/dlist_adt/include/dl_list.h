@@ -50,13 +50,25 @@ typedef struct dnode_t
 typedef struct dlist_t dlist_t;
 typedef struct dlist_iter_t dlist_iter_t;
 
+// Source of the dnode_t objects of a dlist, by default calloc and free are used.
+// A NULL free_node leaves the nodes to the pool, so they are never released
+// one by one and dlist_destroy does not visit them
+typedef struct dlist_allocator_t
+{
+    dnode_t * (* alloc_node)(void * pool);
+    void (* free_node)(void * pool, dnode_t * node);
+    void * pool;
+} dlist_allocator_t;
+
 // constructors and descriptors
 dlist_t * dlist_init(dlist_match_t (* compare_func)(void *, void *));
 void dlist_destroy(dlist_t * dlist);
 void dlist_destroy_free(dlist_t * dlist, void (* free_func)(void *));
+bool dlist_set_allocator(dlist_t * dlist, const dlist_allocator_t * allocator);
 
 // inserting methods
 void dlist_append(dlist_t * dlist, void * data);
+dnode_t * dlist_append_node(dlist_t * dlist, void * data);
 void dlist_prepend(dlist_t * dlist, void * data);
 dlist_result_t dlist_insert(dlist_t * dlist, void * data, int32_t index);
 
@@ -65,7 +77,10 @@ void * dlist_pop_tail(dlist_t * dlist);
 void * dlist_pop_head(dlist_t * dlist);
 void * dlist_get_by_value(dlist_t * dlist, void * data);
 void * dlist_get_by_index(dlist_t * dlist, int32_t index);
+dnode_t * dlist_get_head_node(dlist_t * dlist);
+dnode_t * dlist_get_tail_node(dlist_t * dlist);
 void * dlist_remove_value(dlist_t * dlist, void * data);
+void * dlist_remove_node(dlist_t * dlist, dnode_t * node);
 void dlist_reverse(dlist_t * dlist);
 
 // metadata methods
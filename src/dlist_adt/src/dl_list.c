@@ -24,6 +24,7 @@ typedef struct dlist_t
     size_t length;          // number of nodes
     dlist_t * iter_list;    // dlist of iter_t objects
     bool is_iter_mgr;       // bool indicating if the dlist is a special internal dlist
+    const dlist_allocator_t * allocator;    // NULL to use calloc and free
     dlist_match_t (* compare_func)(void *, void *);
 } dlist_t;
 
@@ -53,12 +54,17 @@ static bool is_iter_list(dlist_iter_t * iter);
 
 // Node private functions
 static void dlist_destroy_(dlist_t ** dlist, dlist_settings_t free_nodes, void(*free_func)(void *));
-static dnode_t * init_node(void * data);
+static dnode_t * init_node(dlist_t * dlist, void * data);
+static void free_node(dlist_t * dlist, dnode_t * node);
 static void * remove_node(dlist_t * dlist, dnode_t * node);
 static dlist_result_t add_node(dlist_t * dlist,
                                void * data,
                                dlist_settings_t add_mode,
                                int32_t at_index);
+static dlist_result_t link_node(dlist_t * dlist,
+                                dnode_t * node,
+                                dlist_settings_t add_mode,
+                                int32_t at_index);
 
 
 
@@ -175,6 +181,30 @@ void dlist_append(dlist_t * dlist, void * data)
     add_node(dlist, data, APPEND, 0);
 }
 
+/*!
+ * @brief Insert a node at the tail of the linked list and return it. Unlike
+ * dlist_append a failed allocation is reported instead of aborting, which
+ * matters when the dnodes come from an allocator that can run out. The node
+ * returned is a handle for dlist_remove_node.
+ * @param dlist
+ * @param data
+ * @return The new tail node or NULL if it could not be allocated, the dlist
+ * is then unchanged
+ */
+dnode_t * dlist_append_node(dlist_t * dlist, void * data)
+{
+    assert(dlist);
+    assert(data);
+
+    dnode_t * node = init_node(dlist, data);
+    if (NULL == node)
+    {
+        return NULL;
+    }
+    link_node(dlist, node, APPEND, 0);
+    return node;
+}
+
 /*!
  * @brief Insert a node at the given index. The new node will maintain the index
  * given in the parameter. If the index is not within the invalid range then
@@ -228,6 +258,28 @@ void dlist_destroy_free(dlist_t * dlist, void (* free_func)(void *))
     dlist_destroy_(&dlist, FREE_NODES, free_func);
 }
 
+/*!
+ * @brief Take the dnode_t objects of the dlist from the allocator instead of
+ * calloc and free. This lets the owner of many small lists carve their nodes
+ * from its own pool. The allocator is not copied and must outlive the dlist.
+ * It can only be changed while the dlist is empty so that every node is
+ * returned to the allocator it came from.
+ *
+ * @param dlist Pointer to the dlist object
+ * @param allocator Allocator to use or NULL to go back to calloc and free
+ * @return False if the dlist is not empty
+ */
+bool dlist_set_allocator(dlist_t * dlist, const dlist_allocator_t * allocator)
+{
+    assert(dlist);
+    if (!dlist_is_empty(dlist))
+    {
+        return false;
+    }
+    dlist->allocator = allocator;
+    return true;
+}
+
 /*!
  * @brief Function to pop values from the tail
  * @param dlist
@@ -347,6 +399,51 @@ void * dlist_remove_value(dlist_t * dlist, void * data)
     return remove_node(dlist, node);
 }
 
+/*!
+ * @brief Remove a node that is known to be in the dlist. The node is usually a
+ * handle kept from dlist_get_tail_node after an append, which lets the caller
+ * unlink it later without searching the dlist.
+ *
+ * Exactly the node passed in is removed, even if other nodes hold an equal
+ * value. Active iterables pointing at the node are moved to its next node,
+ * or to its previous node if it is the tail, so the cost is O(1) plus the
+ * number of active iterables. As with dlist_remove_value the index of the
+ * other iterables is left as it is.
+ * @param dlist
+ * @param node Node of the dlist to remove, it is freed
+ * @return Pointer to the data of the node
+ */
+void * dlist_remove_node(dlist_t * dlist, dnode_t * node)
+{
+    assert(dlist);
+    assert(node);
+
+    if ((false == dlist->is_iter_mgr) && !is_iter_list_empty(dlist))
+    {
+        dnode_t * iter_node = dlist->iter_list->head;
+        for (; NULL != iter_node; iter_node = iter_node->next)
+        {
+            dlist_iter_t * iter = (dlist_iter_t *)iter_node->data;
+            if (iter_get_node(iter) != node)
+            {
+                continue;
+            }
+
+            // The next node takes over the index of the removed one
+            if (NULL != node->next)
+            {
+                iterate(iter, NEXT);
+                iter_update_index(iter, -1);
+            }
+            else
+            {
+                iterate(iter, PREV);
+            }
+        }
+    }
+    return remove_node(dlist, node);
+}
+
 /*!
  * Function is used for the iter API since dlist is opaque
  *
@@ -486,6 +583,33 @@ void * dlist_get_by_index(dlist_t * dlist, int32_t index)
     return node->data;
 }
 
+/*!
+ * @brief Return the head node of the dlist. Walking the nodes through their
+ * next pointers is a read only traversal that does not allocate an iterable,
+ * which makes it safe to run from several threads at once. The dlist must not
+ * be modified during the walk.
+ *
+ * @param dlist
+ * @return Head node or NULL if the dlist is empty
+ */
+dnode_t * dlist_get_head_node(dlist_t * dlist)
+{
+    assert(dlist);
+    return dlist->head;
+}
+
+/*!
+ * @brief Return the tail node of the dlist. See dlist_get_head_node
+ *
+ * @param dlist
+ * @return Tail node or NULL if the dlist is empty
+ */
+dnode_t * dlist_get_tail_node(dlist_t * dlist)
+{
+    assert(dlist);
+    return dlist->tail;
+}
+
 /*********************************************************************************************
  *
  *                                 Iter API Section
@@ -650,17 +774,41 @@ static dnode_t * get_by_index(dlist_t * dlist, int32_t index)
  * @param data
  * @return
  */
-static dnode_t * init_node(void * data)
+static dnode_t * init_node(dlist_t * dlist, void * data)
 {
-    dnode_t * node = (dnode_t *)calloc(1, sizeof(dnode_t));
+    dnode_t * node = (NULL == dlist->allocator)
+        ? (dnode_t *)malloc(sizeof(dnode_t))
+        : dlist->allocator->alloc_node(dlist->allocator->pool);
     if (UV_INVALID_ALLOC == verify_alloc(node))
     {
         return NULL;
     }
-    node->data = data;
+    * node = (dnode_t){
+        .data   = data,
+        .next   = NULL,
+        .prev   = NULL
+    };
     return node;
 }
 
+/*!
+ * @brief Return the node to the allocator of the dlist
+ * @param dlist Pointer to the dlist the node belonged to
+ * @param node Node to free
+ */
+static void free_node(dlist_t * dlist, dnode_t * node)
+{
+    if (NULL == dlist->allocator)
+    {
+        free(node);
+        return;
+    }
+    if (NULL != dlist->allocator->free_node)
+    {
+        dlist->allocator->free_node(dlist->allocator->pool, node);
+    }
+}
+
 /*!
  * @brief Private function handles the removal of the identified node
  * @param dlist
@@ -704,7 +852,7 @@ static void * remove_node(dlist_t * dlist, dnode_t * node)
     }
 
     // free the node and return the actual data
-    free(node);
+    free_node(dlist, node);
     return node_data;
 }
 
@@ -725,7 +873,7 @@ static dlist_result_t add_node(dlist_t * dlist,
     assert(dlist);
     assert(data);
 
-    dnode_t * node = init_node(data);
+    dnode_t * node = init_node(dlist, data);
     if (NULL == node)
     {
         // if we get here, then something terrible has happened to memory
@@ -733,8 +881,29 @@ static dlist_result_t add_node(dlist_t * dlist,
         dlist_destroy(dlist);
         abort();
     }
-    node->data = data;
 
+    dlist_result_t result = link_node(dlist, node, add_mode, at_index);
+    if (DLIST_FAIL == result)
+    {
+        free_node(dlist, node);
+    }
+    return result;
+}
+
+/*!
+ * @brief Link an allocated node into the linked list
+ *
+ * @param dlist
+ * @param node
+ * @param add_mode
+ * @param at_index
+ * @return DLIST_FAIL if the index of INSERT_AT is out of range
+ */
+static dlist_result_t link_node(dlist_t * dlist,
+                                dnode_t * node,
+                                dlist_settings_t add_mode,
+                                int32_t at_index)
+{
     // If tail is None, then we know that there is no items in the linked
     // list. So this item will be the very first item appended.
     if (0 == dlist->length)
@@ -907,7 +1076,9 @@ static void dlist_destroy_(dlist_t ** dlist_ref, dlist_settings_t free_nodes, vo
     }
     dlist_t * dlist = *dlist_ref;
 
-    dnode_t * node = dlist->head;
+    // Nodes owned by the pool of the allocator are reclaimed with the pool
+    bool pool_owned = (NULL != dlist->allocator) && (NULL == dlist->allocator->free_node);
+    dnode_t * node = (pool_owned && (NO_FREE_NODES == free_nodes)) ? NULL : dlist->head;
     dnode_t * next_node;
     while (NULL != node)
     {
@@ -916,7 +1087,7 @@ static void dlist_destroy_(dlist_t ** dlist_ref, dlist_settings_t free_nodes, vo
         {
             free_func(node->data);
         }
-        free(node);
+        free_node(dlist, node);
         node = next_node;
     }
 
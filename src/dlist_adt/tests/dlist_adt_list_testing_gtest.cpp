@@ -34,6 +34,16 @@ dlist_match_t compare_payloads(void * data1, void * data2)
     }
     return DLIST_MISS_MATCH;
 }
+
+// function for comparing int nodes by address
+dlist_match_t compare_int(void * data1, void * data2)
+{
+    if (data1 == data2)
+    {
+        return DLIST_MATCH;
+    }
+    return DLIST_MISS_MATCH;
+}
 /*
  * //end of Helper Functions for testing
  */
@@ -461,3 +471,194 @@ TEST_F(DListTestFixture, TestNumberOfIters)
     dlist_destroy_iter(iter_loca);
     EXPECT_EQ(dlist_get_active_iters(dlist), 1);
 }
+
+// Test ability to walk the nodes without creating an iterable
+TEST_F(DListTestFixture, TestNodeWalk)
+{
+    size_t active_iters = dlist_get_active_iters(dlist);
+
+    dnode_t * node = dlist_get_head_node(dlist);
+    EXPECT_EQ(node->data, payload_first);
+    int count = 0;
+    while (NULL != node)
+    {
+        EXPECT_STREQ((char *)node->data, test_vector.at((size_t)count).c_str());
+        node = node->next;
+        count++;
+    }
+    EXPECT_EQ(count, length);
+    EXPECT_EQ(dlist_get_tail_node(dlist)->data, payload_last);
+    EXPECT_EQ(dlist_get_active_iters(dlist), active_iters);
+}
+
+// Test removing nodes through their handles
+TEST_F(DListTestFixture, TestRemoveNode)
+{
+    // With an active iterable the removal keeps the iterable valid
+    dnode_t * head = dlist_get_head_node(dlist);
+    void * head_data = dlist_remove_node(dlist, head);
+    EXPECT_EQ(head_data, payload_first);
+    EXPECT_EQ(dlist_get_length(dlist), length - 1);
+    EXPECT_EQ(dlist_get_head_node(dlist)->prev, nullptr);
+    free(head_data);
+
+    // Without iterables the node is unlinked directly
+    dlist_t * numbers = dlist_init(compare_int);
+    int values[] = {1, 2, 3, 4};
+    std::vector<dnode_t *> handles;
+    for (int & value : values)
+    {
+        dlist_append(numbers, &value);
+        handles.push_back(dlist_get_tail_node(numbers));
+    }
+
+    EXPECT_EQ(dlist_remove_node(numbers, handles.at(1)), &values[1]);
+    EXPECT_EQ(dlist_remove_node(numbers, handles.at(3)), &values[3]);
+    EXPECT_EQ(dlist_get_length(numbers), 2);
+    EXPECT_EQ(dlist_get_head_node(numbers)->data, &values[0]);
+    EXPECT_EQ(dlist_get_head_node(numbers)->next->data, &values[2]);
+    EXPECT_EQ(dlist_get_tail_node(numbers)->data, &values[2]);
+    EXPECT_EQ(dlist_get_tail_node(numbers)->next, nullptr);
+
+    EXPECT_EQ(dlist_remove_node(numbers, handles.at(0)), &values[0]);
+    EXPECT_EQ(dlist_remove_node(numbers, handles.at(2)), &values[2]);
+    EXPECT_TRUE(dlist_is_empty(numbers));
+    EXPECT_EQ(dlist_get_head_node(numbers), nullptr);
+    EXPECT_EQ(dlist_get_tail_node(numbers), nullptr);
+    dlist_destroy(numbers);
+}
+
+static dlist_match_t compare_int_value(void * data1, void * data2)
+{
+    return (*(int *)data1 == *(int *)data2) ? DLIST_MATCH : DLIST_MISS_MATCH;
+}
+
+// Test that the handle itself is removed, not the first equal value, and
+// that the iterables pointing at it move on
+TEST(DListRemoveNode, TestEqualValuesWithIterable)
+{
+    dlist_t * numbers = dlist_init(compare_int_value);
+    int values[] = {5, 7, 5, 9};
+    std::vector<dnode_t *> handles;
+    for (int & value : values)
+    {
+        dlist_append(numbers, &value);
+        handles.push_back(dlist_get_tail_node(numbers));
+    }
+
+    dlist_iter_t * iter = dlist_get_iterable(numbers, ITER_HEAD);
+    dlist_get_iter_next(iter);
+    dlist_get_iter_next(iter);
+    ASSERT_EQ(iter_get_value(iter), &values[2]);
+
+    EXPECT_EQ(dlist_remove_node(numbers, handles.at(2)), &values[2]);
+    EXPECT_EQ(dlist_get_length(numbers), 3);
+    EXPECT_EQ(dlist_get_head_node(numbers)->data, &values[0]);
+    EXPECT_EQ(dlist_get_head_node(numbers)->next->next, handles.at(3));
+    EXPECT_EQ(iter_get_value(iter), &values[3]);
+    EXPECT_EQ(dlist_get_iter_index(iter), 2);
+
+    // Removing the tail moves its iterables back
+    dlist_iter_t * tail_iter = dlist_get_iterable(numbers, ITER_TAIL);
+    EXPECT_EQ(dlist_remove_node(numbers, handles.at(3)), &values[3]);
+    EXPECT_EQ(iter_get_value(iter), &values[1]);
+    EXPECT_EQ(dlist_get_iter_index(iter), 1);
+    EXPECT_EQ(iter_get_value(tail_iter), &values[1]);
+    EXPECT_EQ(dlist_get_iter_index(tail_iter), 1);
+    EXPECT_EQ(dlist_get_head_node(numbers), handles.at(0));
+
+    dlist_destroy_iter(iter);
+    dlist_destroy_iter(tail_iter);
+    dlist_destroy(numbers);
+}
+
+// Allocator handing out the dnodes of a fixed array and counting the frees
+typedef struct
+{
+    dnode_t nodes[8];
+    size_t used;
+    size_t freed;
+} node_pool_t;
+
+static dnode_t * pool_alloc_node(void * pool)
+{
+    node_pool_t * nodes = (node_pool_t *)pool;
+    return (nodes->used < 8) ? &nodes->nodes[nodes->used++] : nullptr;
+}
+
+static void pool_free_node(void * pool, dnode_t * node)
+{
+    (void)node;
+    ((node_pool_t *)pool)->freed++;
+}
+
+TEST(DListAllocator, TestAllocator)
+{
+    node_pool_t pool = {};
+    dlist_allocator_t allocator = {pool_alloc_node, pool_free_node, &pool};
+    dlist_t * numbers = dlist_init(compare_int);
+    ASSERT_TRUE(dlist_set_allocator(numbers, &allocator));
+
+    int values[] = {1, 2, 3, 4};
+    for (int & value : values)
+    {
+        dlist_append(numbers, &value);
+    }
+    EXPECT_EQ(pool.used, 4);
+    EXPECT_EQ(dlist_get_head_node(numbers), &pool.nodes[0]);
+    EXPECT_EQ(dlist_get_tail_node(numbers), &pool.nodes[3]);
+
+    // The allocator can only change while the dlist is empty
+    EXPECT_FALSE(dlist_set_allocator(numbers, nullptr));
+
+    EXPECT_EQ(dlist_remove_node(numbers, &pool.nodes[1]), &values[1]);
+    EXPECT_EQ(dlist_pop_head(numbers), &values[0]);
+    EXPECT_EQ(pool.freed, 2);
+    dlist_destroy(numbers);
+    EXPECT_EQ(pool.freed, 4);
+}
+
+// Without free_node the nodes are left to the pool, even on destroy
+TEST(DListAllocator, TestPoolOwnedNodes)
+{
+    node_pool_t pool = {};
+    dlist_allocator_t allocator = {pool_alloc_node, nullptr, &pool};
+    dlist_t * numbers = dlist_init(compare_int);
+    ASSERT_TRUE(dlist_set_allocator(numbers, &allocator));
+
+    int values[] = {1, 2, 3};
+    for (int & value : values)
+    {
+        dlist_append(numbers, &value);
+    }
+    EXPECT_EQ(dlist_pop_tail(numbers), &values[2]);
+    EXPECT_EQ(dlist_get_length(numbers), 2);
+    dlist_destroy(numbers);
+    EXPECT_EQ(pool.used, 3);
+    EXPECT_EQ(pool.freed, 0);
+}
+
+// Test that dlist_append_node reports an allocator that ran out instead of
+// aborting, and leaves the dlist as it was
+TEST(DListAllocator, TestAppendNodeFailure)
+{
+    node_pool_t pool = {};
+    dlist_allocator_t allocator = {pool_alloc_node, pool_free_node, &pool};
+    dlist_t * numbers = dlist_init(compare_int);
+    ASSERT_TRUE(dlist_set_allocator(numbers, &allocator));
+
+    int values[9] = {0};
+    for (int index = 0; index < 8; index++)
+    {
+        dnode_t * node = dlist_append_node(numbers, &values[index]);
+        ASSERT_EQ(node, &pool.nodes[index]);
+        EXPECT_EQ(dlist_get_tail_node(numbers), node);
+    }
+
+    EXPECT_EQ(dlist_append_node(numbers, &values[8]), nullptr);
+    EXPECT_EQ(dlist_get_length(numbers), 8);
+    EXPECT_EQ(dlist_get_tail_node(numbers), &pool.nodes[7]);
+    EXPECT_EQ(dlist_get_tail_node(numbers)->next, nullptr);
+    dlist_destroy(numbers);
+    EXPECT_EQ(pool.freed, 8);
+}
@@ -0,0 +1,89 @@
+#ifndef DATA_STRUCTURES_C_SRC_GRAPH_DLIST_INCLUDE_GRAPH_CSR_H_
+#define DATA_STRUCTURES_C_SRC_GRAPH_DLIST_INCLUDE_GRAPH_CSR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <graph_dlist.h>
+
+/*
+ * Compressed sparse row snapshot of a graph_t. The edges of every node are
+ * stored contiguously in flat arrays which keeps traversals cache friendly.
+ * The snapshot is read only and shares the gnode_t objects (and their data)
+ * with the graph it was frozen from, so the graph must outlive the snapshot
+ * and must not be modified while the snapshot is in use.
+ *
+ * A snapshot can be written to a binary file and mapped back into memory in
+ * another process. A mapped snapshot owns its nodes and needs no graph_t.
+ */
+typedef struct graph_csr_t graph_csr_t;
+typedef struct graph_rank_t graph_rank_t;
+
+// Source and target pair of a batch of path queries
+typedef struct graph_query_t
+{
+    gnode_t * source_node;
+    gnode_t * target_node;
+} graph_query_t;
+
+graph_csr_t * graph_csr_freeze(graph_t * graph);
+void graph_csr_destroy(graph_csr_t * csr);
+
+// Binary file functions
+bool graph_csr_write(graph_csr_t * csr,
+                     const char * file_path,
+                     size_t value_size,
+                     void (* write_value)(void * data, void * record));
+graph_csr_t * graph_csr_map(const char * file_path,
+                            dlist_match_t (* compare_callback)(void *, void *));
+
+size_t graph_csr_node_count(graph_csr_t * csr);
+size_t graph_csr_total_edges(graph_csr_t * csr);
+gnode_t * graph_csr_get_node(graph_csr_t * csr, size_t id);
+size_t graph_csr_get_node_id(graph_csr_t * csr, gnode_t * node);
+
+// Queries
+size_t graph_csr_edge_count(graph_csr_t * csr, size_t id);
+size_t graph_csr_get_neighbors(graph_csr_t * csr,
+                               size_t id,
+                               const uint32_t ** targets,
+                               const uint32_t ** weights);
+bool graph_csr_node_a_neighbor(graph_csr_t * csr,
+                               size_t source_id,
+                               size_t target_id);
+bool graph_csr_get_edge_weight(graph_csr_t * csr,
+                               size_t source_id,
+                               size_t target_id,
+                               uint32_t * weight);
+
+// Path functions
+path_t * graph_csr_get_path(graph_csr_t * csr,
+                            gnode_t * source_node,
+                            gnode_t * target_node);
+graph_spt_t * graph_csr_shortest_path_tree(graph_csr_t * csr,
+                                           gnode_t * source_node);
+size_t graph_csr_get_paths(graph_csr_t * csr,
+                           const graph_query_t * queries,
+                           size_t query_count,
+                           path_t ** paths,
+                           size_t thread_count);
+
+// Traversal functions
+graph_bfs_t * graph_csr_bfs(graph_csr_t * csr, gnode_t * source_node, size_t thread_count);
+graph_components_t * graph_csr_connected_components(graph_csr_t * csr, size_t thread_count);
+
+// Centrality functions
+graph_rank_t * graph_csr_pagerank(graph_csr_t * csr,
+                                  double damping,
+                                  double tolerance,
+                                  size_t max_iterations,
+                                  size_t thread_count);
+void graph_rank_destroy(graph_rank_t * rank);
+double graph_rank_get_score(graph_rank_t * rank, gnode_t * node);
+size_t graph_rank_iterations(graph_rank_t * rank);
+bool graph_rank_converged(graph_rank_t * rank);
+
+#ifdef __cplusplus
+}
+#endif // end __cplusplus
+#endif //DATA_STRUCTURES_C_SRC_GRAPH_DLIST_INCLUDE_GRAPH_CSR_H_
@@ -5,6 +5,13 @@
 extern "C" {
 #endif
 #include <dl_list.h>
+#include <stdint.h>
+
+// Id of a gnode_t that is not part of a graph
+#define GRAPH_NO_ID SIZE_MAX
+
+// Hops of a node that a breadth first search did not reach
+#define GRAPH_UNREACHABLE SIZE_MAX
 
 typedef enum
 {
@@ -13,6 +20,7 @@ typedef enum
     GRAPH_FAIL_NODE_ALREADY_EXISTS,
     GRAPH_EDGE_ALREADY_EXISTS,
     GRAPH_EDGE_NOT_FOUND,
+    GRAPH_ALLOC_FAILED,
 } graph_opt_t;
 
 typedef enum
@@ -29,6 +37,10 @@ typedef enum
 
 typedef struct graph_t graph_t;
 typedef struct gnode_t gnode_t;
+typedef struct graph_spt_t graph_spt_t;
+typedef struct graph_bfs_t graph_bfs_t;
+typedef struct graph_components_t graph_components_t;
+typedef struct graph_ch_t graph_ch_t;
 
 typedef struct
 {
@@ -37,15 +49,41 @@ typedef struct
     gnode_t * to_node;
 } edge_t;
 
+// One edge of the list passed to graph_build_from_edges
+typedef struct graph_edge_input_t
+{
+    void * source_value;
+    void * target_value;
+    uint32_t weight;
+} graph_edge_input_t;
+
 typedef struct path_t
 {
     uint64_t path_weight;
     dlist_t * path;
 } path_t;
 
+// Spanning forest, the edges point at the edge_t objects of the graph
+typedef struct graph_mst_t
+{
+    uint64_t total_weight;
+    size_t edge_count;
+    edge_t ** edges;
+} graph_mst_t;
+
+// Lower bound of the weight of the path from node to target_node
+typedef uint64_t (* graph_heuristic_t)(gnode_t * node,
+                                       gnode_t * target_node,
+                                       void * ctx);
+
 graph_t * graph_init(graph_mode_t graph_mode,
                      dlist_match_t (* compare_callback)(void *, void *),
                      uint64_t (* hash_callback)(void *));
+graph_t * graph_build_from_edges(graph_mode_t graph_mode,
+                                 const graph_edge_input_t * edges,
+                                 size_t edge_count,
+                                 dlist_match_t (* compare_callback)(void *, void *),
+                                 uint64_t (* hash_callback)(void *));
 void graph_destroy_node(gnode_t * node, void (*free_func)(void *));
 void graph_destroy(graph_t * graph, void (* free_func)(void * data));
 
@@ -72,6 +110,7 @@ void graph_destroy_neighbors_list(dlist_iter_t * neighbors);
 
 
 void * graph_get_node_value(gnode_t * node);
+size_t graph_get_node_id(gnode_t * node);
 
 // Queries
 bool graph_value_in_graph(graph_t * graph, void * data);
@@ -86,8 +125,52 @@ size_t graph_node_count(graph_t * graph);
 
 // Path functions
 path_t * graph_get_path(graph_t * graph, gnode_t * source_node, gnode_t * target_node);
+path_t * graph_get_path_bidirectional(graph_t * graph,
+                                      gnode_t * source_node,
+                                      gnode_t * target_node);
+path_t * graph_get_path_astar(graph_t * graph,
+                              gnode_t * source_node,
+                              gnode_t * target_node,
+                              graph_heuristic_t heuristic,
+                              void * ctx);
 void graph_free_path(path_t * path);
 
+// Contraction hierarchy functions
+graph_ch_t * graph_ch_build(graph_t * graph);
+void graph_ch_destroy(graph_ch_t * ch);
+size_t graph_ch_shortcut_count(graph_ch_t * ch);
+path_t * graph_ch_get_path(graph_ch_t * ch, gnode_t * source_node, gnode_t * target_node);
+
+// Shortest path tree functions
+graph_spt_t * graph_shortest_path_tree(graph_t * graph, gnode_t * source_node);
+void graph_spt_destroy(graph_spt_t * spt);
+gnode_t * graph_spt_get_source(graph_spt_t * spt);
+bool graph_spt_reachable(graph_spt_t * spt, gnode_t * target_node);
+uint64_t graph_spt_get_distance(graph_spt_t * spt, gnode_t * target_node);
+gnode_t * graph_spt_get_prev(graph_spt_t * spt, gnode_t * node);
+path_t * graph_spt_get_path(graph_spt_t * spt, gnode_t * target_node);
+
+// Traversal functions
+graph_bfs_t * graph_bfs(graph_t * graph, gnode_t * source_node, size_t thread_count);
+void graph_bfs_destroy(graph_bfs_t * bfs);
+size_t graph_bfs_get_hops(graph_bfs_t * bfs, gnode_t * node);
+gnode_t * graph_bfs_get_parent(graph_bfs_t * bfs, gnode_t * node);
+size_t graph_bfs_reached_count(graph_bfs_t * bfs);
+
+// Component functions
+graph_components_t * graph_connected_components(graph_t * graph, size_t thread_count);
+void graph_components_destroy(graph_components_t * components);
+size_t graph_components_count(graph_components_t * components);
+size_t graph_components_get_label(graph_components_t * components, gnode_t * node);
+size_t graph_components_get_size(graph_components_t * components, size_t label);
+graph_components_t * graph_strongly_connected_components(graph_t * graph);
+dlist_t * graph_topological_sort(graph_t * graph);
+
+// Spanning tree functions
+graph_mst_t * graph_mst_kruskal(graph_t * graph, size_t thread_count);
+graph_mst_t * graph_mst_prim(graph_t * graph);
+void graph_free_mst(graph_mst_t * mst);
+
 #ifdef __cplusplus
 }
 #endif // end __cplusplus
@@ -0,0 +1,142 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include <graph_csr.h>
+#include <thread_pool.h>
+#include <utils.h>
+
+#include "graph_internal.h"
+
+typedef struct batch_context_t
+{
+    graph_csr_t * csr;
+    graph_view_t view;
+    const graph_query_t * queries;
+    path_t ** paths;
+    graph_search_t ** searches;     // Scratch of every thread, made on first use
+} batch_context_t;
+
+static void path_task(void * context, size_t task_index, size_t thread_index);
+
+/*!
+ * @brief Find the shortest path of many source and target pairs on the
+ * snapshot. The queries are spread across a pool of threads and every thread
+ * reuses one search state for all the queries it runs, so a query only costs
+ * the part of the graph it explores.
+ *
+ * The snapshot is only read, any number of batches may run on it at the same
+ * time.
+ *
+ * @param csr Pointer to the snapshot object
+ * @param queries Array of source and target pairs
+ * @param query_count Number of queries
+ * @param paths Array of query_count items. Item i is set to the path of query
+ * i or to NULL if there is no path. Every path is freed with graph_free_path
+ * @param thread_count Number of threads to use, 0 for one per online cpu
+ * @return Number of queries for which a path was found
+ */
+size_t graph_csr_get_paths(graph_csr_t * csr,
+                           const graph_query_t * queries,
+                           size_t query_count,
+                           path_t ** paths,
+                           size_t thread_count)
+{
+    assert(csr);
+    assert(queries);
+    assert(paths);
+
+    if (0 == thread_count)
+    {
+        thread_count = thread_pool_get_cpu_count();
+    }
+    if (thread_count > query_count)
+    {
+        thread_count = (0 == query_count) ? 1 : query_count;
+    }
+
+    batch_context_t context = {
+        .csr        = csr,
+        .queries    = queries,
+        .paths      = paths,
+        .searches   = (graph_search_t **)calloc(thread_count, sizeof(graph_search_t *))
+    };
+    if (UV_INVALID_ALLOC == verify_alloc(context.searches))
+    {
+        for (size_t index = 0; index < query_count; index++)
+        {
+            paths[index] = NULL;
+        }
+        return 0;
+    }
+    graph_view_of_csr(csr, &context.view);
+
+    // Without a pool every query runs on the calling thread
+    thread_pool_t * pool = thread_pool_init(thread_count);
+    if (NULL == pool)
+    {
+        for (size_t index = 0; index < query_count; index++)
+        {
+            path_task(&context, index, 0);
+        }
+    }
+    else
+    {
+        thread_pool_run(pool, query_count, path_task, &context);
+        thread_pool_destroy(pool);
+    }
+
+    for (size_t index = 0; index < thread_count; index++)
+    {
+        if (NULL != context.searches[index])
+        {
+            graph_search_destroy(context.searches[index]);
+        }
+    }
+    free(context.searches);
+
+    size_t found = 0;
+    for (size_t index = 0; index < query_count; index++)
+    {
+        if (NULL != paths[index])
+        {
+            found++;
+        }
+    }
+    return found;
+}
+
+/*!
+ * @brief Task that answers one query with the search state of its thread
+ */
+static void path_task(void * context, size_t task_index, size_t thread_index)
+{
+    batch_context_t * batch = (batch_context_t *)context;
+    const graph_query_t * query = &batch->queries[task_index];
+    batch->paths[task_index] = NULL;
+
+    size_t source = graph_csr_get_node_id(batch->csr, query->source_node);
+    size_t target = graph_csr_get_node_id(batch->csr, query->target_node);
+    if ((GRAPH_NO_ID == source) || (GRAPH_NO_ID == target))
+    {
+        return;
+    }
+
+    graph_search_t * search = batch->searches[thread_index];
+    if (NULL == search)
+    {
+        search = graph_search_init(batch->view.node_count);
+        if (NULL == search)
+        {
+            return;
+        }
+        batch->searches[thread_index] = search;
+    }
+
+    if (graph_search_run(search, &batch->view, source, target))
+    {
+        batch->paths[task_index] = graph_view_build_path(&batch->view,
+                                                         search->prev,
+                                                         target,
+                                                         search->distances[target]);
+    }
+}
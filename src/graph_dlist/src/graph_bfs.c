@@ -0,0 +1,420 @@
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <graph_dlist.h>
+#include <thread_pool.h>
+#include <utils.h>
+
+#include "graph_internal.h"
+
+typedef enum
+{
+    BFS_TOP_DOWN_CHUNK = 256,       // Frontier nodes per task
+    BFS_BOTTOM_UP_CHUNK = 4096,     // Node ids per task
+    BFS_LOCAL_SIZE = 256,           // Nodes found by a task before a flush
+    BFS_ALPHA = 14,                 // Switch to bottom up above edges / alpha
+    BFS_BETA = 24,                  // Switch back to top down below nodes / beta
+} graph_bfs_settings_t;
+
+typedef struct graph_bfs_t
+{
+    graph_view_t view;              // Owns a copy of the nodes of the view
+    size_t source;
+    size_t * hops;                  // GRAPH_UNREACHABLE for unreached nodes
+    size_t * parents;               // Parent id in the BFS tree or GRAPH_NO_ID
+    size_t reached_count;
+} graph_bfs_t;
+
+// State shared by the tasks of one level
+typedef struct bfs_state_t
+{
+    const graph_view_t * view;
+    const graph_view_t * reverse;   // NULL if the edges can not be walked back
+    size_t * hops;
+    size_t * parents;
+    _Atomic uint64_t * visited;     // Bitmap of the nodes already reached
+    uint64_t * in_frontier;         // Bitmap of the frontier of a bottom up step
+    size_t * frontier;
+    size_t frontier_count;
+    size_t * next;
+    atomic_size_t next_count;
+    size_t level;                   // Hops of the nodes found by the step
+} bfs_state_t;
+
+// Nodes found by a task, copied to the next frontier in one reservation
+typedef struct bfs_buffer_t
+{
+    size_t ids[BFS_LOCAL_SIZE];
+    size_t count;
+} bfs_buffer_t;
+
+static void top_down_task(void * context, size_t task_index, size_t thread_index);
+static void bottom_up_task(void * context, size_t task_index, size_t thread_index);
+static void run_step(bfs_state_t * state,
+                     thread_pool_t * pool,
+                     size_t task_count,
+                     void (* task)(void *, size_t, size_t));
+static bool claim_node(bfs_state_t * state, size_t id);
+static void discover_node(bfs_state_t * state,
+                          bfs_buffer_t * buffer,
+                          size_t id,
+                          size_t parent);
+static void flush_buffer(bfs_state_t * state, bfs_buffer_t * buffer);
+static size_t get_bfs_node_id(graph_bfs_t * bfs, gnode_t * node);
+
+/*!
+ * @brief Perform a level synchronous breadth first search from the source.
+ *
+ * Every level is either expanded top down, where the frontier walks its edges
+ * and claims the nodes it reaches in an atomic bitmap, or bottom up, where
+ * every unreached node walks its edges backwards until it finds a parent in
+ * the frontier. Bottom up steps are much cheaper once the frontier holds a
+ * large part of the edges, so the search switches to them when the frontier
+ * has more than 1 / BFS_ALPHA of the unexplored edges and back once it
+ * shrinks under 1 / BFS_BETA of the nodes. The work of every level is split
+ * in tasks across a thread pool.
+ *
+ * @param view View of the graph
+ * @param reverse View with every edge reversed or NULL to only search top down
+ * @param source Id of the source node
+ * @param thread_count Number of threads to use, 0 for one per online cpu
+ * @return Result of the search or NULL if an allocation failed
+ */
+graph_bfs_t * graph_view_bfs(const graph_view_t * view,
+                             const graph_view_t * reverse,
+                             size_t source,
+                             size_t thread_count)
+{
+    assert(source < view->node_count);
+
+    size_t node_count = view->node_count;
+    size_t word_count = (node_count / 64) + 1;
+    graph_bfs_t * bfs = (graph_bfs_t *)calloc(1, sizeof(graph_bfs_t));
+    gnode_t ** nodes = (gnode_t **)malloc(sizeof(gnode_t *) * (node_count + 1));
+    bfs_state_t state = {
+        .view           = view,
+        .reverse        = reverse,
+        .hops           = (size_t *)malloc(sizeof(size_t) * (node_count + 1)),
+        .parents        = (size_t *)malloc(sizeof(size_t) * (node_count + 1)),
+        .visited        = (_Atomic uint64_t *)calloc(word_count, sizeof(uint64_t)),
+        .in_frontier    = (uint64_t *)calloc(word_count, sizeof(uint64_t)),
+        .frontier       = (size_t *)malloc(sizeof(size_t) * (node_count + 1)),
+        .next           = (size_t *)malloc(sizeof(size_t) * (node_count + 1))
+    };
+    if ((NULL == bfs) || (NULL == nodes) || (NULL == state.hops)
+        || (NULL == state.parents) || (NULL == state.visited)
+        || (NULL == state.in_frontier) || (NULL == state.frontier)
+        || (NULL == state.next))
+    {
+        debug_print_err("%s\n", "Unable to allocate the BFS state");
+        free(bfs);
+        free(nodes);
+        free(state.hops);
+        free(state.parents);
+        free((void *)state.visited);
+        free(state.in_frontier);
+        free(state.frontier);
+        free(state.next);
+        return NULL;
+    }
+
+    for (size_t id = 0; id < node_count; id++)
+    {
+        nodes[id] = view->nodes[id];
+        state.hops[id] = GRAPH_UNREACHABLE;
+        state.parents[id] = GRAPH_NO_ID;
+    }
+
+    if (0 == thread_count)
+    {
+        thread_count = thread_pool_get_cpu_count();
+    }
+    thread_pool_t * pool = (thread_count > 1) ? thread_pool_init(thread_count) : NULL;
+
+    claim_node(&state, source);
+    state.hops[source] = 0;
+    state.frontier[0] = source;
+    state.frontier_count = 1;
+
+    size_t reached_count = 1;
+    size_t unexplored_edges = view->edge_count;
+    bool bottom_up = false;
+    while (0 != state.frontier_count)
+    {
+        size_t frontier_edges = 0;
+        for (size_t index = 0; index < state.frontier_count; index++)
+        {
+            frontier_edges += graph_view_degree(view, state.frontier[index]);
+        }
+        unexplored_edges -= (frontier_edges < unexplored_edges) ? frontier_edges : unexplored_edges;
+
+        if (NULL != reverse)
+        {
+            bottom_up = bottom_up
+                ? (state.frontier_count >= node_count / BFS_BETA)
+                : (frontier_edges > unexplored_edges / BFS_ALPHA);
+        }
+
+        state.level++;
+        atomic_store(&state.next_count, 0);
+        if (bottom_up)
+        {
+            for (size_t index = 0; index < state.frontier_count; index++)
+            {
+                size_t id = state.frontier[index];
+                state.in_frontier[id / 64] |= (uint64_t)1 << (id % 64);
+            }
+            run_step(&state, pool,
+                     (node_count + BFS_BOTTOM_UP_CHUNK - 1) / BFS_BOTTOM_UP_CHUNK,
+                     bottom_up_task);
+            for (size_t index = 0; index < state.frontier_count; index++)
+            {
+                state.in_frontier[state.frontier[index] / 64] = 0;
+            }
+        }
+        else
+        {
+            run_step(&state, pool,
+                     (state.frontier_count + BFS_TOP_DOWN_CHUNK - 1) / BFS_TOP_DOWN_CHUNK,
+                     top_down_task);
+        }
+
+        size_t * swap = state.frontier;
+        state.frontier = state.next;
+        state.next = swap;
+        state.frontier_count = atomic_load(&state.next_count);
+        reached_count += state.frontier_count;
+    }
+
+    if (NULL != pool)
+    {
+        thread_pool_destroy(pool);
+    }
+    free((void *)state.visited);
+    free(state.in_frontier);
+    free(state.frontier);
+    free(state.next);
+
+    * bfs = (graph_bfs_t){
+        .view           = {
+            .node_count         = node_count,
+            .nodes              = nodes,
+            .compare_callback   = view->compare_callback
+        },
+        .source         = source,
+        .hops           = state.hops,
+        .parents        = state.parents,
+        .reached_count  = reached_count
+    };
+    return bfs;
+}
+
+/*!
+ * @brief Destroy the result of a breadth first search
+ * @param bfs Pointer to the search result
+ */
+void graph_bfs_destroy(graph_bfs_t * bfs)
+{
+    free(bfs->view.nodes);
+    free(bfs->hops);
+    free(bfs->parents);
+    free(bfs);
+}
+
+/*!
+ * @brief Fetch the number of edges on the shortest unweighted path from the
+ * source to the node
+ * @param bfs Pointer to the search result
+ * @param node Pointer to the node object
+ * @return Number of hops or GRAPH_UNREACHABLE if the node was not reached
+ */
+size_t graph_bfs_get_hops(graph_bfs_t * bfs, gnode_t * node)
+{
+    size_t id = get_bfs_node_id(bfs, node);
+    if (GRAPH_NO_ID == id)
+    {
+        return GRAPH_UNREACHABLE;
+    }
+    return bfs->hops[id];
+}
+
+/*!
+ * @brief Fetch the parent of the node in the BFS tree. With more than one
+ * thread any node of the previous level with an edge to the node may be the
+ * parent.
+ * @param bfs Pointer to the search result
+ * @param node Pointer to the node object
+ * @return Pointer to the parent gnode or NULL for the source and for nodes
+ * that were not reached
+ */
+gnode_t * graph_bfs_get_parent(graph_bfs_t * bfs, gnode_t * node)
+{
+    size_t id = get_bfs_node_id(bfs, node);
+    if ((GRAPH_NO_ID == id) || (GRAPH_NO_ID == bfs->parents[id]))
+    {
+        return NULL;
+    }
+    return bfs->view.nodes[bfs->parents[id]];
+}
+
+/*!
+ * @brief Return the number of nodes reached by the search, the source included
+ * @param bfs Pointer to the search result
+ * @return Number of nodes reached
+ */
+size_t graph_bfs_reached_count(graph_bfs_t * bfs)
+{
+    return bfs->reached_count;
+}
+
+/*!
+ * @brief Expand a chunk of the frontier through the edges of its nodes
+ */
+static void top_down_task(void * context, size_t task_index, size_t thread_index)
+{
+    (void)thread_index;
+    bfs_state_t * state = (bfs_state_t *)context;
+    bfs_buffer_t buffer;
+    buffer.count = 0;
+
+    size_t start = task_index * BFS_TOP_DOWN_CHUNK;
+    size_t end = start + BFS_TOP_DOWN_CHUNK;
+    if (end > state->frontier_count)
+    {
+        end = state->frontier_count;
+    }
+
+    for (size_t index = start; index < end; index++)
+    {
+        size_t id = state->frontier[index];
+        graph_cursor_t cursor;
+        size_t neighbor;
+        uint32_t weight;
+        graph_view_first(state->view, id, &cursor);
+        while (graph_view_next(state->view, &cursor, &neighbor, &weight))
+        {
+            if (claim_node(state, neighbor))
+            {
+                discover_node(state, &buffer, neighbor, id);
+            }
+        }
+    }
+    flush_buffer(state, &buffer);
+}
+
+/*!
+ * @brief Look for a parent in the frontier for every unreached node of a
+ * chunk of ids. A node is only handled by the task owning its id so it can
+ * stop at the first parent found.
+ */
+static void bottom_up_task(void * context, size_t task_index, size_t thread_index)
+{
+    (void)thread_index;
+    bfs_state_t * state = (bfs_state_t *)context;
+    bfs_buffer_t buffer;
+    buffer.count = 0;
+
+    size_t start = task_index * BFS_BOTTOM_UP_CHUNK;
+    size_t end = start + BFS_BOTTOM_UP_CHUNK;
+    if (end > state->view->node_count)
+    {
+        end = state->view->node_count;
+    }
+
+    for (size_t id = start; id < end; id++)
+    {
+        uint64_t bit = (uint64_t)1 << (id % 64);
+        if (0 != (atomic_load_explicit(&state->visited[id / 64], memory_order_relaxed) & bit))
+        {
+            continue;
+        }
+
+        graph_cursor_t cursor;
+        size_t neighbor;
+        uint32_t weight;
+        graph_view_first(state->reverse, id, &cursor);
+        while (graph_view_next(state->reverse, &cursor, &neighbor, &weight))
+        {
+            if (0 != (state->in_frontier[neighbor / 64] & ((uint64_t)1 << (neighbor % 64))))
+            {
+                atomic_fetch_or(&state->visited[id / 64], bit);
+                discover_node(state, &buffer, id, neighbor);
+                break;
+            }
+        }
+    }
+    flush_buffer(state, &buffer);
+}
+
+/*!
+ * @brief Run the tasks of a step on the pool or on the calling thread
+ */
+static void run_step(bfs_state_t * state,
+                     thread_pool_t * pool,
+                     size_t task_count,
+                     void (* task)(void *, size_t, size_t))
+{
+    if (NULL != pool)
+    {
+        thread_pool_run(pool, task_count, task, state);
+        return;
+    }
+    for (size_t index = 0; index < task_count; index++)
+    {
+        task(state, index, 0);
+    }
+}
+
+/*!
+ * @brief Mark the node as reached. The bitmap is read first so that nodes
+ * reached long ago do not cost an atomic write.
+ * @return True if the calling thread is the one that reached the node
+ */
+static bool claim_node(bfs_state_t * state, size_t id)
+{
+    _Atomic uint64_t * word = &state->visited[id / 64];
+    uint64_t bit = (uint64_t)1 << (id % 64);
+    if (0 != (atomic_load_explicit(word, memory_order_relaxed) & bit))
+    {
+        return false;
+    }
+    return (0 == (atomic_fetch_or(word, bit) & bit));
+}
+
+/*!
+ * @brief Record the node as part of the next level
+ */
+static void discover_node(bfs_state_t * state,
+                          bfs_buffer_t * buffer,
+                          size_t id,
+                          size_t parent)
+{
+    state->hops[id] = state->level;
+    state->parents[id] = parent;
+    buffer->ids[buffer->count++] = id;
+    if (BFS_LOCAL_SIZE == buffer->count)
+    {
+        flush_buffer(state, buffer);
+    }
+}
+
+/*!
+ * @brief Reserve room in the next frontier and copy the buffered nodes to it
+ */
+static void flush_buffer(bfs_state_t * state, bfs_buffer_t * buffer)
+{
+    if (0 == buffer->count)
+    {
+        return;
+    }
+    size_t start = atomic_fetch_add(&state->next_count, buffer->count);
+    memcpy(state->next + start, buffer->ids, sizeof(size_t) * buffer->count);
+    buffer->count = 0;
+}
+
+static size_t get_bfs_node_id(graph_bfs_t * bfs, gnode_t * node)
+{
+    return graph_view_get_node_id(&bfs->view, node);
+}
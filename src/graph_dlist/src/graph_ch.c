@@ -0,0 +1,903 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <graph_dlist.h>
+#include <utils.h>
+
+#include "graph_internal.h"
+
+typedef enum
+{
+    CH_WITNESS_LIMIT = 256,         // Nodes settled by a witness search
+    CH_SIMULATE_LIMIT = 32,         // Same while only estimating a priority
+    CH_INITIAL_ARCS = 4,            // First capacity of an arc list
+} graph_ch_settings_t;
+
+// Arc of the hierarchy, either an edge of the graph or a shortcut
+typedef struct ch_arc_t
+{
+    size_t node;                    // Other end of the arc
+    uint64_t weight;
+    size_t middle;                  // Node skipped by a shortcut or GRAPH_NO_ID
+} ch_arc_t;
+
+// Growable list of the arcs leaving or entering a node while contracting
+typedef struct ch_arc_list_t
+{
+    ch_arc_t * arcs;
+    size_t count;
+    size_t capacity;
+} ch_arc_list_t;
+
+typedef struct graph_ch_t
+{
+    graph_view_t view;              // Owns a copy of the nodes of the view
+    size_t * ranks;                 // Position of every id in the contraction order
+    uint64_t * up_offsets;          // Arcs of id i to higher ranks are
+    ch_arc_t * up_arcs;             // up_arcs[up_offsets[i], up_offsets[i + 1])
+    uint64_t * down_offsets;        // Arcs into id i from higher ranks, node is
+    ch_arc_t * down_arcs;           // the tail of the arc
+    size_t shortcut_count;
+    graph_search_t * forward;       // Reused by every query
+    graph_search_t * backward;
+} graph_ch_t;
+
+// State of the preprocessing
+typedef struct ch_builder_t
+{
+    size_t node_count;
+    ch_arc_list_t * out_arcs;
+    ch_arc_list_t * in_arcs;
+    size_t * contracted_neighbors;  // Priority term that spreads the order
+    size_t * levels;                // Depth of the node in the hierarchy
+    size_t * updated;               // Last contracted neighbor of every id
+    uint64_t * keys;                // Key of every id in the queue
+    size_t * ranks;
+    graph_search_t * witness;
+    heap_indexed_t * queue;
+} ch_builder_t;
+
+// Pair of ids whose arc is left to unpack
+typedef struct ch_unpack_t
+{
+    size_t tail;
+    size_t head;
+} ch_unpack_t;
+
+static bool init_builder(ch_builder_t * builder, const graph_view_t * view);
+static void destroy_builder(ch_builder_t * builder);
+static bool contract_node(ch_builder_t * builder,
+                          size_t id,
+                          bool simulate,
+                          size_t * shortcut_count);
+static uint64_t get_priority(ch_builder_t * builder, size_t id);
+static void witness_search(ch_builder_t * builder,
+                           size_t source,
+                           size_t skipped,
+                           uint64_t limit,
+                           size_t settle_limit);
+static bool add_arc(ch_builder_t * builder,
+                    size_t tail,
+                    size_t head,
+                    uint64_t weight,
+                    size_t middle);
+static bool push_arc(ch_arc_list_t * list, size_t node, uint64_t weight, size_t middle);
+static void remove_arc(ch_arc_list_t * list, size_t node);
+static bool build_search_graph(graph_ch_t * ch, ch_builder_t * builder);
+static void expand_side(graph_search_t * search,
+                        graph_search_t * other,
+                        const uint64_t * offsets,
+                        const ch_arc_t * arcs,
+                        const uint64_t * stall_offsets,
+                        const ch_arc_t * stall_arcs,
+                        uint64_t * best,
+                        size_t * meet);
+static const ch_arc_t * find_arc(graph_ch_t * ch, size_t tail, size_t head);
+static path_t * unpack_path(graph_ch_t * ch, size_t source, size_t target, size_t meet, uint64_t weight);
+
+/*!
+ * @brief Build a contraction hierarchy of the graph for fast point to point
+ * shortest path queries.
+ *
+ * The nodes are contracted one at a time in the order of an indexed heap keyed
+ * by their edge difference, the number of shortcuts their contraction adds
+ * minus the number of arcs it removes, plus their contracted neighbors and
+ * their depth in the hierarchy. Keys are refreshed lazily when a node reaches
+ * the top of the heap and lowered for the neighbors of every contracted node.
+ * Contracting a node adds a shortcut between two of its neighbors unless a
+ * witness search, bounded to CH_WITNESS_LIMIT settled nodes, finds a path that
+ * is as short without it. Estimating a key runs the same searches with the
+ * tighter CH_SIMULATE_LIMIT.
+ *
+ * The hierarchy shares the gnode_t objects with the graph, so the graph must
+ * outlive it and must not be modified while it is in use.
+ *
+ * @param graph Pointer to the graph structure
+ * @return Contraction hierarchy or NULL if an allocation failed. It is freed
+ * with graph_ch_destroy
+ */
+graph_ch_t * graph_ch_build(graph_t * graph)
+{
+    assert(graph);
+    graph_view_t view;
+    graph_view_of_graph(graph, &view);
+    size_t node_count = view.node_count;
+
+    graph_ch_t * ch = (graph_ch_t *)calloc(1, sizeof(graph_ch_t));
+    if (UV_INVALID_ALLOC == verify_alloc(ch))
+    {
+        return NULL;
+    }
+
+    ch_builder_t builder;
+    ch->view = (graph_view_t){
+        .node_count         = node_count,
+        .nodes              = (gnode_t **)malloc(sizeof(gnode_t *) * (node_count + 1)),
+        .compare_callback   = view.compare_callback
+    };
+    ch->forward = graph_search_init(node_count);
+    ch->backward = graph_search_init(node_count);
+    if ((NULL == ch->view.nodes) || (NULL == ch->forward) || (NULL == ch->backward))
+    {
+        debug_print_err("%s\n", "Unable to allocate the contraction hierarchy");
+        graph_ch_destroy(ch);
+        return NULL;
+    }
+    for (size_t id = 0; id < node_count; id++)
+    {
+        ch->view.nodes[id] = view.nodes[id];
+    }
+
+    if (!init_builder(&builder, &view))
+    {
+        graph_ch_destroy(ch);
+        return NULL;
+    }
+
+    size_t rank = 0;
+    bool success = true;
+    while (success && !heap_indexed_is_empty(builder.queue))
+    {
+        size_t id = heap_indexed_pop(builder.queue, NULL);
+
+        // The key may be stale, put the node back if it no longer is the
+        // smallest one
+        builder.keys[id] = get_priority(&builder, id);
+        uint64_t top_key;
+        if (!heap_indexed_is_empty(builder.queue))
+        {
+            heap_indexed_peek(builder.queue, &top_key);
+            if (builder.keys[id] > top_key)
+            {
+                heap_indexed_push(builder.queue, id, builder.keys[id]);
+                continue;
+            }
+        }
+
+        size_t shortcut_count = 0;
+        success = contract_node(&builder, id, false, &shortcut_count);
+        ch->shortcut_count += shortcut_count;
+        builder.ranks[id] = rank++;
+
+        // Every neighbor left is ranked higher, so the arcs of the node are
+        // final and only need to go from the lists of its neighbors
+        ch_arc_list_t * out_arcs = &builder.out_arcs[id];
+        ch_arc_list_t * in_arcs = &builder.in_arcs[id];
+        for (size_t index = 0; index < out_arcs->count; index++)
+        {
+            remove_arc(&builder.in_arcs[out_arcs->arcs[index].node], id);
+        }
+        for (size_t index = 0; index < in_arcs->count; index++)
+        {
+            remove_arc(&builder.out_arcs[in_arcs->arcs[index].node], id);
+        }
+
+        // Lower the keys of the neighbors whose priority dropped, raised keys
+        // are caught by the lazy check
+        ch_arc_list_t * lists[] = {out_arcs, in_arcs};
+        for (size_t side = 0; success && (side < 2); side++)
+        {
+            for (size_t index = 0; index < lists[side]->count; index++)
+            {
+                size_t neighbor = lists[side]->arcs[index].node;
+                if (builder.updated[neighbor] == id)
+                {
+                    continue;
+                }
+                builder.updated[neighbor] = id;
+                builder.contracted_neighbors[neighbor]++;
+                if (builder.levels[neighbor] < builder.levels[id] + 1)
+                {
+                    builder.levels[neighbor] = builder.levels[id] + 1;
+                }
+                uint64_t key = get_priority(&builder, neighbor);
+                if (key < builder.keys[neighbor])
+                {
+                    builder.keys[neighbor] = key;
+                    heap_indexed_decrease_key(builder.queue, neighbor, key);
+                }
+            }
+        }
+    }
+
+    if (!success || !build_search_graph(ch, &builder))
+    {
+        debug_print_err("%s\n", "Unable to contract the graph");
+        destroy_builder(&builder);
+        graph_ch_destroy(ch);
+        return NULL;
+    }
+    ch->ranks = builder.ranks;
+    builder.ranks = NULL;
+    destroy_builder(&builder);
+    return ch;
+}
+
+/*!
+ * @brief Destroy the contraction hierarchy
+ * @param ch Pointer to the contraction hierarchy
+ */
+void graph_ch_destroy(graph_ch_t * ch)
+{
+    if (NULL != ch->forward)
+    {
+        graph_search_destroy(ch->forward);
+    }
+    if (NULL != ch->backward)
+    {
+        graph_search_destroy(ch->backward);
+    }
+    free(ch->view.nodes);
+    free(ch->ranks);
+    free(ch->up_offsets);
+    free(ch->up_arcs);
+    free(ch->down_offsets);
+    free(ch->down_arcs);
+    free(ch);
+}
+
+/*!
+ * @brief Fetch the number of shortcuts the contraction added
+ * @param ch Pointer to the contraction hierarchy
+ * @return Number of shortcuts
+ */
+size_t graph_ch_shortcut_count(graph_ch_t * ch)
+{
+    return ch->shortcut_count;
+}
+
+/*!
+ * @brief Find the shortest path between two nodes in the hierarchy. A forward
+ * search from the source only follows arcs to nodes contracted later and a
+ * backward search from the target does the same against the arcs. The shortest
+ * path is the best node where both searches meet, and its shortcuts are
+ * unpacked into the edges of the graph.
+ *
+ * The search state is kept in the hierarchy to skip its allocation on every
+ * query, so queries on the same hierarchy must not run concurrently.
+ *
+ * @param ch Pointer to the contraction hierarchy
+ * @param source_node Pointer to the source node object
+ * @param target_node Pointer to the target node object
+ * @return NULL if no path was found or a path structure containing the path
+ */
+path_t * graph_ch_get_path(graph_ch_t * ch, gnode_t * source_node, gnode_t * target_node)
+{
+    size_t source = graph_view_get_node_id(&ch->view, source_node);
+    size_t target = graph_view_get_node_id(&ch->view, target_node);
+    if ((GRAPH_NO_ID == source) || (GRAPH_NO_ID == target))
+    {
+        return NULL;
+    }
+
+    graph_search_t * forward = ch->forward;
+    graph_search_t * backward = ch->backward;
+    graph_search_reset(forward);
+    graph_search_reset(backward);
+    forward->distances[source] = 0;
+    forward->touched[forward->touched_count++] = source;
+    heap_indexed_push(forward->heap, source, 0);
+    backward->distances[target] = 0;
+    backward->touched[backward->touched_count++] = target;
+    heap_indexed_push(backward->heap, target, 0);
+
+    uint64_t best = (source == target) ? 0 : UINT64_MAX;
+    size_t meet = (source == target) ? source : GRAPH_NO_ID;
+    for (;;)
+    {
+        // A side is done once its closest node can not improve the best path
+        uint64_t forward_key = UINT64_MAX;
+        uint64_t backward_key = UINT64_MAX;
+        if (!heap_indexed_is_empty(forward->heap))
+        {
+            heap_indexed_peek(forward->heap, &forward_key);
+        }
+        if (!heap_indexed_is_empty(backward->heap))
+        {
+            heap_indexed_peek(backward->heap, &backward_key);
+        }
+        if ((forward_key >= best) && (backward_key >= best))
+        {
+            break;
+        }
+
+        if (forward_key <= backward_key)
+        {
+            expand_side(forward, backward,
+                        ch->up_offsets, ch->up_arcs,
+                        ch->down_offsets, ch->down_arcs,
+                        &best, &meet);
+        }
+        else
+        {
+            expand_side(backward, forward,
+                        ch->down_offsets, ch->down_arcs,
+                        ch->up_offsets, ch->up_arcs,
+                        &best, &meet);
+        }
+    }
+
+    if (GRAPH_NO_ID == meet)
+    {
+        return NULL;
+    }
+    return unpack_path(ch, source, target, meet, best);
+}
+
+/*!
+ * @brief Allocate the state of the preprocessing, copy the edges of the view
+ * into arc lists and queue every node with its initial priority
+ * @param builder Builder to initialize
+ * @param view View of the graph
+ * @return False if an allocation failed, in which case nothing is left
+ * allocated
+ */
+static bool init_builder(ch_builder_t * builder, const graph_view_t * view)
+{
+    size_t node_count = view->node_count;
+    * builder = (ch_builder_t){
+        .node_count             = node_count,
+        .out_arcs               = (ch_arc_list_t *)calloc(node_count + 1, sizeof(ch_arc_list_t)),
+        .in_arcs                = (ch_arc_list_t *)calloc(node_count + 1, sizeof(ch_arc_list_t)),
+        .contracted_neighbors   = (size_t *)calloc(node_count + 1, sizeof(size_t)),
+        .levels                 = (size_t *)calloc(node_count + 1, sizeof(size_t)),
+        .updated                = (size_t *)malloc(sizeof(size_t) * (node_count + 1)),
+        .keys                   = (uint64_t *)malloc(sizeof(uint64_t) * (node_count + 1)),
+        .ranks                  = (size_t *)malloc(sizeof(size_t) * (node_count + 1)),
+        .witness                = graph_search_init(node_count),
+        .queue                  = heap_indexed_init(node_count)
+    };
+    if ((NULL == builder->out_arcs) || (NULL == builder->in_arcs)
+        || (NULL == builder->contracted_neighbors) || (NULL == builder->levels)
+        || (NULL == builder->updated)
+        || (NULL == builder->keys) || (NULL == builder->ranks)
+        || (NULL == builder->witness) || (NULL == builder->queue))
+    {
+        debug_print_err("%s\n", "Unable to allocate the contraction state");
+        destroy_builder(builder);
+        return false;
+    }
+
+    // Self loops never lie on a shortest path and are left out
+    for (size_t id = 0; id < node_count; id++)
+    {
+        graph_cursor_t cursor;
+        size_t neighbor;
+        uint32_t weight;
+        graph_view_first(view, id, &cursor);
+        while (graph_view_next(view, &cursor, &neighbor, &weight))
+        {
+            if ((neighbor != id) && !add_arc(builder, id, neighbor, weight, GRAPH_NO_ID))
+            {
+                destroy_builder(builder);
+                return false;
+            }
+        }
+    }
+
+    for (size_t id = 0; id < node_count; id++)
+    {
+        builder->updated[id] = GRAPH_NO_ID;
+        builder->keys[id] = get_priority(builder, id);
+        heap_indexed_push(builder->queue, id, builder->keys[id]);
+    }
+    return true;
+}
+
+/*!
+ * @brief Free the state of the preprocessing
+ * @param builder Builder to free
+ */
+static void destroy_builder(ch_builder_t * builder)
+{
+    for (size_t id = 0; (NULL != builder->out_arcs) && (id < builder->node_count); id++)
+    {
+        free(builder->out_arcs[id].arcs);
+    }
+    for (size_t id = 0; (NULL != builder->in_arcs) && (id < builder->node_count); id++)
+    {
+        free(builder->in_arcs[id].arcs);
+    }
+    if (NULL != builder->witness)
+    {
+        graph_search_destroy(builder->witness);
+    }
+    if (NULL != builder->queue)
+    {
+        heap_indexed_destroy(builder->queue);
+    }
+    free(builder->out_arcs);
+    free(builder->in_arcs);
+    free(builder->contracted_neighbors);
+    free(builder->levels);
+    free(builder->updated);
+    free(builder->keys);
+    free(builder->ranks);
+}
+
+/*!
+ * @brief Contract the node by adding a shortcut for every pair of remaining
+ * neighbors u -> id -> x whose path has no witness of the same weight
+ * avoiding the node
+ * @param builder State of the preprocessing
+ * @param id Id of the node to contract
+ * @param simulate Only count the shortcuts without adding them
+ * @param shortcut_count Set to the number of shortcuts needed
+ * @return False if an allocation failed
+ */
+static bool contract_node(ch_builder_t * builder,
+                          size_t id,
+                          bool simulate,
+                          size_t * shortcut_count)
+{
+    ch_arc_list_t * in_arcs = &builder->in_arcs[id];
+    ch_arc_list_t * out_arcs = &builder->out_arcs[id];
+    * shortcut_count = 0;
+
+    for (size_t in_index = 0; in_index < in_arcs->count; in_index++)
+    {
+        ch_arc_t in_arc = in_arcs->arcs[in_index];
+        uint64_t max_weight = 0;
+        bool has_targets = false;
+        for (size_t out_index = 0; out_index < out_arcs->count; out_index++)
+        {
+            ch_arc_t * out_arc = &out_arcs->arcs[out_index];
+            if (out_arc->node != in_arc.node)
+            {
+                has_targets = true;
+                max_weight = (out_arc->weight > max_weight) ? out_arc->weight : max_weight;
+            }
+        }
+        if (!has_targets)
+        {
+            continue;
+        }
+
+        witness_search(builder,
+                       in_arc.node,
+                       id,
+                       in_arc.weight + max_weight,
+                       simulate ? CH_SIMULATE_LIMIT : CH_WITNESS_LIMIT);
+        for (size_t out_index = 0; out_index < out_arcs->count; out_index++)
+        {
+            ch_arc_t out_arc = out_arcs->arcs[out_index];
+            uint64_t weight = in_arc.weight + out_arc.weight;
+            if ((out_arc.node == in_arc.node)
+                || (builder->witness->distances[out_arc.node] <= weight))
+            {
+                continue;
+            }
+
+            (* shortcut_count)++;
+            if (!simulate && !add_arc(builder, in_arc.node, out_arc.node, weight, id))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*!
+ * @brief Compute the key of the node in the contraction queue, twice its edge
+ * difference plus its contracted neighbors and its depth. The key is offset by
+ * four times the node count so that it is never negative
+ * @param builder State of the preprocessing
+ * @param id Id of the node
+ * @return Key of the node, smaller keys are contracted first
+ */
+static uint64_t get_priority(ch_builder_t * builder, size_t id)
+{
+    size_t shortcut_count;
+    contract_node(builder, id, true, &shortcut_count);
+
+    size_t removed = builder->out_arcs[id].count + builder->in_arcs[id].count;
+    return (uint64_t)(4 * builder->node_count + 2 * shortcut_count
+                      + builder->contracted_neighbors[id] + builder->levels[id]
+                      - 2 * removed);
+}
+
+/*!
+ * @brief Run a bounded dijkstra from the source over the remaining nodes
+ * without the skipped node. The search stops past the limit or after
+ * settle_limit settled nodes, so a missing witness only costs an extra
+ * shortcut.
+ * @param builder State of the preprocessing, the distances end up in its
+ * witness search state
+ * @param source Id the search starts from
+ * @param skipped Id of the node being contracted
+ * @param limit Weight past which no witness is of use
+ * @param settle_limit Number of nodes settled before giving up
+ */
+static void witness_search(ch_builder_t * builder,
+                           size_t source,
+                           size_t skipped,
+                           uint64_t limit,
+                           size_t settle_limit)
+{
+    graph_search_t * search = builder->witness;
+    graph_search_reset(search);
+    search->distances[source] = 0;
+    search->touched[search->touched_count++] = source;
+    heap_indexed_push(search->heap, source, 0);
+
+    size_t settled_count = 0;
+    while (!heap_indexed_is_empty(search->heap) && (settled_count < settle_limit))
+    {
+        uint64_t distance;
+        size_t id = heap_indexed_pop(search->heap, &distance);
+        if (distance > limit)
+        {
+            break;
+        }
+        search->settled[id] = true;
+        settled_count++;
+
+        ch_arc_list_t * out_arcs = &builder->out_arcs[id];
+        for (size_t index = 0; index < out_arcs->count; index++)
+        {
+            size_t neighbor = out_arcs->arcs[index].node;
+            uint64_t next = distance + out_arcs->arcs[index].weight;
+            if ((neighbor == skipped) || search->settled[neighbor] || (next >= search->distances[neighbor]))
+            {
+                continue;
+            }
+
+            if (UINT64_MAX == search->distances[neighbor])
+            {
+                search->touched[search->touched_count++] = neighbor;
+                heap_indexed_push(search->heap, neighbor, next);
+            }
+            else
+            {
+                heap_indexed_decrease_key(search->heap, neighbor, next);
+            }
+            search->distances[neighbor] = next;
+        }
+    }
+}
+
+/*!
+ * @brief Add the arc to the out list of the tail and the in list of the head.
+ * If the two are already linked the lighter arc is kept
+ * @param builder State of the preprocessing
+ * @param tail Id the arc leaves
+ * @param head Id the arc enters
+ * @param weight Weight of the arc
+ * @param middle Node skipped by a shortcut or GRAPH_NO_ID for an edge
+ * @return False if an allocation failed
+ */
+static bool add_arc(ch_builder_t * builder,
+                    size_t tail,
+                    size_t head,
+                    uint64_t weight,
+                    size_t middle)
+{
+    ch_arc_list_t * out_arcs = &builder->out_arcs[tail];
+    for (size_t index = 0; index < out_arcs->count; index++)
+    {
+        if (out_arcs->arcs[index].node != head)
+        {
+            continue;
+        }
+        if (out_arcs->arcs[index].weight <= weight)
+        {
+            return true;
+        }
+
+        out_arcs->arcs[index].weight = weight;
+        out_arcs->arcs[index].middle = middle;
+        ch_arc_list_t * in_arcs = &builder->in_arcs[head];
+        for (size_t in_index = 0; in_index < in_arcs->count; in_index++)
+        {
+            if (in_arcs->arcs[in_index].node == tail)
+            {
+                in_arcs->arcs[in_index].weight = weight;
+                in_arcs->arcs[in_index].middle = middle;
+                break;
+            }
+        }
+        return true;
+    }
+
+    return push_arc(out_arcs, head, weight, middle)
+        && push_arc(&builder->in_arcs[head], tail, weight, middle);
+}
+
+/*!
+ * @brief Append an arc to the list, doubling its capacity when it is full
+ * @return False if an allocation failed
+ */
+static bool push_arc(ch_arc_list_t * list, size_t node, uint64_t weight, size_t middle)
+{
+    if (list->count == list->capacity)
+    {
+        size_t capacity = (0 == list->capacity) ? CH_INITIAL_ARCS : list->capacity * 2;
+        ch_arc_t * arcs = (ch_arc_t *)realloc(list->arcs, sizeof(ch_arc_t) * capacity);
+        if (NULL == arcs)
+        {
+            return false;
+        }
+        list->arcs = arcs;
+        list->capacity = capacity;
+    }
+
+    list->arcs[list->count++] = (ch_arc_t){
+        .node   = node,
+        .weight = weight,
+        .middle = middle
+    };
+    return true;
+}
+
+/*!
+ * @brief Pack the arcs left after the contraction into the two flat arrays
+ * walked by the queries. The out arcs of a node all lead to higher ranks and
+ * become its up arcs, its in arcs all come from higher ranks and become its
+ * down arcs
+ * @param ch Hierarchy receiving the arrays
+ * @param builder State of the finished contraction
+ * @return False if an allocation failed
+ */
+static bool build_search_graph(graph_ch_t * ch, ch_builder_t * builder)
+{
+    size_t node_count = builder->node_count;
+    ch->up_offsets = (uint64_t *)malloc(sizeof(uint64_t) * (node_count + 1));
+    ch->down_offsets = (uint64_t *)malloc(sizeof(uint64_t) * (node_count + 1));
+    if ((NULL == ch->up_offsets) || (NULL == ch->down_offsets))
+    {
+        return false;
+    }
+
+    ch->up_offsets[0] = 0;
+    ch->down_offsets[0] = 0;
+    for (size_t id = 0; id < node_count; id++)
+    {
+        ch->up_offsets[id + 1] = ch->up_offsets[id] + builder->out_arcs[id].count;
+        ch->down_offsets[id + 1] = ch->down_offsets[id] + builder->in_arcs[id].count;
+    }
+
+    ch->up_arcs = (ch_arc_t *)malloc(sizeof(ch_arc_t) * (ch->up_offsets[node_count] + 1));
+    ch->down_arcs = (ch_arc_t *)malloc(sizeof(ch_arc_t) * (ch->down_offsets[node_count] + 1));
+    if ((NULL == ch->up_arcs) || (NULL == ch->down_arcs))
+    {
+        return false;
+    }
+
+    for (size_t id = 0; id < node_count; id++)
+    {
+        if (0 != builder->out_arcs[id].count)
+        {
+            memcpy(&ch->up_arcs[ch->up_offsets[id]],
+                   builder->out_arcs[id].arcs,
+                   sizeof(ch_arc_t) * builder->out_arcs[id].count);
+        }
+        if (0 != builder->in_arcs[id].count)
+        {
+            memcpy(&ch->down_arcs[ch->down_offsets[id]],
+                   builder->in_arcs[id].arcs,
+                   sizeof(ch_arc_t) * builder->in_arcs[id].count);
+        }
+    }
+    return true;
+}
+
+/*!
+ * @brief Remove the arc leading to the node from the list. The last arc takes
+ * its place
+ * @param list List of arcs
+ * @param node Id at the other end of the arc
+ */
+static void remove_arc(ch_arc_list_t * list, size_t node)
+{
+    for (size_t index = 0; index < list->count; index++)
+    {
+        if (list->arcs[index].node == node)
+        {
+            list->arcs[index] = list->arcs[--list->count];
+            return;
+        }
+    }
+}
+
+/*!
+ * @brief Settle the closest node of one side of the query and relax its arcs.
+ * Every node that both sides reached is a candidate for the meeting point.
+ *
+ * A node is stalled instead of relaxed when a higher ranked node this side
+ * already reached has a shorter arc down to it, since no shortest path can
+ * then go up through the node.
+ *
+ * @param search Search state of the side being expanded
+ * @param other Search state of the opposite side
+ * @param offsets Arc offsets walked by this side
+ * @param arcs Arcs walked by this side
+ * @param stall_offsets Arc offsets walked by the opposite side
+ * @param stall_arcs Arcs walked by the opposite side
+ * @param best Weight of the shortest path met so far
+ * @param meet Id of the node where the shortest path met so far crosses
+ */
+static void expand_side(graph_search_t * search,
+                        graph_search_t * other,
+                        const uint64_t * offsets,
+                        const ch_arc_t * arcs,
+                        const uint64_t * stall_offsets,
+                        const ch_arc_t * stall_arcs,
+                        uint64_t * best,
+                        size_t * meet)
+{
+    uint64_t distance;
+    size_t id = heap_indexed_pop(search->heap, &distance);
+    search->settled[id] = true;
+
+    for (uint64_t index = stall_offsets[id]; index < stall_offsets[id + 1]; index++)
+    {
+        uint64_t reached = search->distances[stall_arcs[index].node];
+        if ((UINT64_MAX != reached) && (reached + stall_arcs[index].weight < distance))
+        {
+            return;
+        }
+    }
+
+    for (uint64_t index = offsets[id]; index < offsets[id + 1]; index++)
+    {
+        size_t neighbor = arcs[index].node;
+        uint64_t next = distance + arcs[index].weight;
+        if (search->settled[neighbor] || (next >= search->distances[neighbor]))
+        {
+            continue;
+        }
+
+        if (UINT64_MAX == search->distances[neighbor])
+        {
+            search->touched[search->touched_count++] = neighbor;
+            heap_indexed_push(search->heap, neighbor, next);
+        }
+        else
+        {
+            heap_indexed_decrease_key(search->heap, neighbor, next);
+        }
+        search->distances[neighbor] = next;
+        search->prev[neighbor] = id;
+
+        if ((UINT64_MAX != other->distances[neighbor])
+            && (next + other->distances[neighbor] < * best))
+        {
+            * best = next + other->distances[neighbor];
+            * meet = neighbor;
+        }
+    }
+}
+
+/*!
+ * @brief Find the arc from the tail to the head in the search graph
+ * @param ch Pointer to the contraction hierarchy
+ * @param tail Id the arc leaves
+ * @param head Id the arc enters
+ * @return Pointer to the arc, whose node is the id at the other end
+ */
+static const ch_arc_t * find_arc(graph_ch_t * ch, size_t tail, size_t head)
+{
+    bool up = ch->ranks[head] > ch->ranks[tail];
+    size_t owner = up ? tail : head;
+    size_t other = up ? head : tail;
+    const uint64_t * offsets = up ? ch->up_offsets : ch->down_offsets;
+    const ch_arc_t * arcs = up ? ch->up_arcs : ch->down_arcs;
+    for (uint64_t index = offsets[owner]; index < offsets[owner + 1]; index++)
+    {
+        if (arcs[index].node == other)
+        {
+            return &arcs[index];
+        }
+    }
+    return NULL;
+}
+
+/*!
+ * @brief Build the path of the query. The arcs from the source up to the
+ * meeting point and down to the target are pushed on a stack and every
+ * shortcut popped from it is replaced by its two halves until only edges of
+ * the graph are left.
+ * @param ch Pointer to the contraction hierarchy
+ * @param source Id of the source node
+ * @param target Id of the target node
+ * @param meet Id of the node where both sides met
+ * @param weight Weight of the path
+ * @return Path structure or NULL if an allocation failed
+ */
+static path_t * unpack_path(graph_ch_t * ch, size_t source, size_t target, size_t meet, uint64_t weight)
+{
+    path_t * path = (path_t *)malloc(sizeof(path_t));
+    dlist_t * path_list = dlist_init(ch->view.compare_callback);
+
+    // Every shortcut pushes one more pair than it pops, the initial pairs are
+    // bounded by the node count
+    size_t capacity = ch->view.node_count + 1;
+    ch_unpack_t * stack = (ch_unpack_t *)malloc(sizeof(ch_unpack_t) * capacity);
+    if ((NULL == path) || (NULL == path_list) || (NULL == stack))
+    {
+        debug_print_err("%s\n", "Unable to allocate the path");
+        free(path);
+        free(stack);
+        if (NULL != path_list)
+        {
+            dlist_destroy(path_list);
+        }
+        return NULL;
+    }
+
+    // The pairs are popped in path order, so the arcs down to the target go
+    // in first and the arcs up from the source last
+    size_t length = 0;
+    for (size_t id = meet; id != target; id = ch->backward->prev[id])
+    {
+        length++;
+    }
+    size_t index = length;
+    for (size_t id = meet; id != target; id = ch->backward->prev[id])
+    {
+        stack[--index] = (ch_unpack_t){id, ch->backward->prev[id]};
+    }
+    for (size_t id = meet; id != source; id = ch->forward->prev[id])
+    {
+        stack[length++] = (ch_unpack_t){ch->forward->prev[id], id};
+    }
+
+    dlist_append(path_list, ch->view.nodes[source]);
+    while (0 != length)
+    {
+        ch_unpack_t pair = stack[--length];
+        const ch_arc_t * arc = find_arc(ch, pair.tail, pair.head);
+        assert(arc);
+        if (GRAPH_NO_ID == arc->middle)
+        {
+            dlist_append(path_list, ch->view.nodes[pair.head]);
+            continue;
+        }
+
+        if (length + 2 > capacity)
+        {
+            capacity *= 2;
+            ch_unpack_t * grown = (ch_unpack_t *)realloc(stack, sizeof(ch_unpack_t) * capacity);
+            if (NULL == grown)
+            {
+                debug_print_err("%s\n", "Unable to allocate the path");
+                free(stack);
+                free(path);
+                dlist_destroy(path_list);
+                return NULL;
+            }
+            stack = grown;
+        }
+        stack[length++] = (ch_unpack_t){arc->middle, pair.head};
+        stack[length++] = (ch_unpack_t){pair.tail, arc->middle};
+    }
+    free(stack);
+
+    * path = (path_t){
+        .path_weight    = weight,
+        .path           = path_list
+    };
+    return path;
+}
@@ -0,0 +1,290 @@
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include <graph_dlist.h>
+#include <thread_pool.h>
+#include <utils.h>
+
+#include "graph_internal.h"
+
+typedef enum
+{
+    COMPONENTS_CHUNK = 1024,        // Node ids per task
+} graph_components_settings_t;
+
+typedef struct graph_components_t
+{
+    graph_view_t view;              // Owns a copy of the nodes of the view
+    size_t * labels;                // Dense label of every node id
+    size_t * sizes;                 // Number of nodes of every label
+    size_t count;
+} graph_components_t;
+
+// State shared by the tasks that union the edges
+typedef struct union_state_t
+{
+    const graph_view_t * view;
+    _Atomic size_t * parents;
+} union_state_t;
+
+static void union_task(void * context, size_t task_index, size_t thread_index);
+static size_t find_root(_Atomic size_t * parents, size_t id);
+static void unite_roots(_Atomic size_t * parents, size_t left, size_t right);
+static size_t get_components_node_id(graph_components_t * components, gnode_t * node);
+
+/*!
+ * @brief Label the connected components of the view. The edges are treated as
+ * undirected, which gives the weakly connected components of a graph whose
+ * edges go one way.
+ *
+ * The edges are united in a lock free union find. A root is only ever linked
+ * under a root with a smaller id with a compare and swap, and finds halve the
+ * path they walk, so the nodes can be split across the threads of a pool
+ * without locks. Linking by id instead of by rank keeps the root of every
+ * component at its smallest id, which makes the labels deterministic.
+ *
+ * @param view View of the graph
+ * @param thread_count Number of threads to use, 0 for one per online cpu
+ * @return Labels of the components or NULL if an allocation failed
+ */
+graph_components_t * graph_view_components(const graph_view_t * view, size_t thread_count)
+{
+    size_t node_count = view->node_count;
+    size_t * labels = (size_t *)malloc(sizeof(size_t) * (node_count + 1));
+    _Atomic size_t * parents = (_Atomic size_t *)malloc(sizeof(size_t) * (node_count + 1));
+    if ((NULL == labels) || (NULL == parents))
+    {
+        debug_print_err("%s\n", "Unable to allocate the components");
+        free(labels);
+        free((void *)parents);
+        return NULL;
+    }
+
+    for (size_t id = 0; id < node_count; id++)
+    {
+        atomic_init(&parents[id], id);
+    }
+
+    if (0 == thread_count)
+    {
+        thread_count = thread_pool_get_cpu_count();
+    }
+    union_state_t state = {
+        .view       = view,
+        .parents    = parents
+    };
+    size_t task_count = (node_count + COMPONENTS_CHUNK - 1) / COMPONENTS_CHUNK;
+    thread_pool_t * pool = (thread_count > 1) ? thread_pool_init(thread_count) : NULL;
+    if (NULL == pool)
+    {
+        for (size_t index = 0; index < task_count; index++)
+        {
+            union_task(&state, index, 0);
+        }
+    }
+    else
+    {
+        thread_pool_run(pool, task_count, union_task, &state);
+        thread_pool_destroy(pool);
+    }
+
+    // The root of a component is its smallest id, so walking the ids in order
+    // labels a root before any other node of its component
+    size_t count = 0;
+    for (size_t id = 0; id < node_count; id++)
+    {
+        size_t root = find_root(parents, id);
+        labels[id] = (root == id) ? count++ : labels[root];
+    }
+    free((void *)parents);
+    return graph_components_from_labels(view, labels, count);
+}
+
+/*!
+ * @brief Create the component result from the label of every node id
+ * @param view View the labels were computed on
+ * @param labels Label of every node id, the result takes ownership of it
+ * @param count Number of labels
+ * @return Component labels or NULL if an allocation failed, in which case the
+ * labels are freed
+ */
+graph_components_t * graph_components_from_labels(const graph_view_t * view,
+                                                  size_t * labels,
+                                                  size_t count)
+{
+    size_t node_count = view->node_count;
+    graph_components_t * components = (graph_components_t *)calloc(1, sizeof(graph_components_t));
+    gnode_t ** nodes = (gnode_t **)malloc(sizeof(gnode_t *) * (node_count + 1));
+    size_t * sizes = (size_t *)calloc(count + 1, sizeof(size_t));
+    if ((NULL == components) || (NULL == nodes) || (NULL == sizes))
+    {
+        debug_print_err("%s\n", "Unable to allocate the components");
+        free(components);
+        free(nodes);
+        free(sizes);
+        free(labels);
+        return NULL;
+    }
+
+    for (size_t id = 0; id < node_count; id++)
+    {
+        nodes[id] = view->nodes[id];
+        sizes[labels[id]]++;
+    }
+
+    * components = (graph_components_t){
+        .view       = {
+            .node_count         = node_count,
+            .nodes              = nodes,
+            .compare_callback   = view->compare_callback
+        },
+        .labels     = labels,
+        .sizes      = sizes,
+        .count      = count
+    };
+    return components;
+}
+
+/*!
+ * @brief Destroy the component labels
+ * @param components Pointer to the component labels
+ */
+void graph_components_destroy(graph_components_t * components)
+{
+    free(components->view.nodes);
+    free(components->labels);
+    free(components->sizes);
+    free(components);
+}
+
+/*!
+ * @brief Return the number of connected components
+ * @param components Pointer to the component labels
+ * @return Number of components
+ */
+size_t graph_components_count(graph_components_t * components)
+{
+    return components->count;
+}
+
+/*!
+ * @brief Fetch the label of the component holding the node. Labels are dense
+ * in the range [0, count) and are numbered in the order of the smallest node
+ * id of every component.
+ * @param components Pointer to the component labels
+ * @param node Pointer to the node object
+ * @return Label of the component or GRAPH_NO_ID if the node was not labeled
+ */
+size_t graph_components_get_label(graph_components_t * components, gnode_t * node)
+{
+    size_t id = get_components_node_id(components, node);
+    if (GRAPH_NO_ID == id)
+    {
+        return GRAPH_NO_ID;
+    }
+    return components->labels[id];
+}
+
+/*!
+ * @brief Return the number of nodes in the component with the label
+ * @param components Pointer to the component labels
+ * @param label Label of the component
+ * @return Number of nodes or 0 if the label is out of range
+ */
+size_t graph_components_get_size(graph_components_t * components, size_t label)
+{
+    if (label >= components->count)
+    {
+        return 0;
+    }
+    return components->sizes[label];
+}
+
+/*!
+ * @brief Unite every node of a chunk of ids with the targets of its edges
+ */
+static void union_task(void * context, size_t task_index, size_t thread_index)
+{
+    (void)thread_index;
+    union_state_t * state = (union_state_t *)context;
+
+    size_t start = task_index * COMPONENTS_CHUNK;
+    size_t end = start + COMPONENTS_CHUNK;
+    if (end > state->view->node_count)
+    {
+        end = state->view->node_count;
+    }
+
+    for (size_t id = start; id < end; id++)
+    {
+        graph_cursor_t cursor;
+        size_t neighbor;
+        uint32_t weight;
+        graph_view_first(state->view, id, &cursor);
+        while (graph_view_next(state->view, &cursor, &neighbor, &weight))
+        {
+            unite_roots(state->parents, id, neighbor);
+        }
+    }
+}
+
+/*!
+ * @brief Find the root of the id. Every node on the way is pointed to its
+ * grand parent, a failed swap only means another thread moved it already.
+ */
+static size_t find_root(_Atomic size_t * parents, size_t id)
+{
+    while (true)
+    {
+        size_t parent = atomic_load_explicit(&parents[id], memory_order_relaxed);
+        if (parent == id)
+        {
+            return id;
+        }
+
+        size_t grand_parent = atomic_load_explicit(&parents[parent], memory_order_relaxed);
+        if (grand_parent == parent)
+        {
+            return parent;
+        }
+        atomic_compare_exchange_weak(&parents[id], &parent, grand_parent);
+        id = grand_parent;
+    }
+}
+
+/*!
+ * @brief Unite the components of the two ids by linking the larger root under
+ * the smaller one. The link only succeeds if the larger id is still a root,
+ * otherwise the roots are looked up again.
+ */
+static void unite_roots(_Atomic size_t * parents, size_t left, size_t right)
+{
+    while (true)
+    {
+        left = find_root(parents, left);
+        right = find_root(parents, right);
+        if (left == right)
+        {
+            return;
+        }
+
+        if (left < right)
+        {
+            size_t swap = left;
+            left = right;
+            right = swap;
+        }
+
+        size_t expected = left;
+        if (atomic_compare_exchange_strong(&parents[left], &expected, right))
+        {
+            return;
+        }
+    }
+}
+
+static size_t get_components_node_id(graph_components_t * components, gnode_t * node)
+{
+    return graph_view_get_node_id(&components->view, node);
+}
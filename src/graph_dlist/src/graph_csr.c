@@ -0,0 +1,450 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include <graph_csr.h>
+#include <utils.h>
+
+#include "graph_internal.h"
+
+// Target and weight of one edge while a row of the snapshot is sorted
+typedef struct csr_edge_t
+{
+    uint32_t target;
+    uint32_t weight;
+} csr_edge_t;
+
+static int compare_csr_edges(const void * left, const void * right);
+static bool sort_rows(graph_csr_t * csr);
+
+/*!
+ * @brief Freeze the graph into a compressed sparse row snapshot. The offsets,
+ * targets and weights of every edge are stored in three flat arrays and the
+ * neighbors of every node are sorted by their id which allows neighbor
+ * queries to use a binary search.
+ *
+ * The ids of the snapshot are the ids of the graph at the time of the freeze.
+ *
+ * @param graph Pointer to the graph object to freeze
+ * @return Pointer to the snapshot or NULL if the graph is too large or an
+ * allocation failed
+ */
+graph_csr_t * graph_csr_freeze(graph_t * graph)
+{
+    assert(graph);
+
+    // Targets are stored as uint32_t to halve the size of the edge arrays
+    if (graph->node_count >= UINT32_MAX)
+    {
+        debug_print_err("%s\n", "Graph has too many nodes for a snapshot");
+        return NULL;
+    }
+
+    graph_csr_t * csr = (graph_csr_t *)calloc(1, sizeof(graph_csr_t));
+    if (UV_INVALID_ALLOC == verify_alloc(csr))
+    {
+        return NULL;
+    }
+
+    size_t node_count = graph->node_count;
+    size_t edge_count = graph->edge_count;
+
+    // Allocate at least one item so that an empty graph still gets valid arrays
+    csr->offsets = (uint64_t *)calloc(node_count + 1, sizeof(uint64_t));
+    csr->targets = (uint32_t *)calloc(edge_count + 1, sizeof(uint32_t));
+    csr->weights = (uint32_t *)calloc(edge_count + 1, sizeof(uint32_t));
+    csr->nodes = (gnode_t **)calloc(node_count + 1, sizeof(gnode_t *));
+    if ((NULL == csr->offsets) || (NULL == csr->targets)
+        || (NULL == csr->weights) || (NULL == csr->nodes))
+    {
+        debug_print_err("%s\n", "Unable to allocate the snapshot arrays");
+        graph_csr_destroy(csr);
+        return NULL;
+    }
+
+    csr->node_count = node_count;
+    csr->edge_count = edge_count;
+    csr->graph_mode = graph->graph_mode;
+    csr->compare_callback = graph->compare_callback;
+
+    uint64_t edge_index = 0;
+    for (size_t id = 0; id < node_count; id++)
+    {
+        gnode_t * node = graph->nodes[id];
+        csr->nodes[id] = node;
+        csr->offsets[id] = edge_index;
+
+        dnode_t * link = dlist_get_head_node(node->edges);
+        while (NULL != link)
+        {
+            edge_t * edge = (edge_t *)link->data;
+            csr->targets[edge_index] = (uint32_t)edge->to_node->id;
+            csr->weights[edge_index] = edge->weight;
+            edge_index++;
+            link = link->next;
+        }
+    }
+    csr->offsets[node_count] = edge_index;
+    assert(edge_index == edge_count);
+
+    if (!sort_rows(csr))
+    {
+        graph_csr_destroy(csr);
+        return NULL;
+    }
+    return csr;
+}
+
+/*!
+ * @brief Destroy the snapshot. The gnode_t objects and their data belong to
+ * the graph and are not freed. A snapshot loaded with graph_csr_map releases
+ * its mapping and its nodes.
+ * @param csr Pointer to the snapshot object
+ */
+void graph_csr_destroy(graph_csr_t * csr)
+{
+    if (NULL != csr->mapping)
+    {
+        graph_csr_unmap(csr);
+        return;
+    }
+    free(csr->offsets);
+    free(csr->targets);
+    free(csr->weights);
+    free(csr->nodes);
+    free(csr);
+}
+
+/*!
+ * @brief Return the number of nodes in the snapshot
+ * @param csr Pointer to the snapshot object
+ * @return Number of nodes in the snapshot
+ */
+size_t graph_csr_node_count(graph_csr_t * csr)
+{
+    return csr->node_count;
+}
+
+/*!
+ * @brief Return the number of edges stored in the snapshot
+ * @param csr Pointer to the snapshot object
+ * @return Number of edges across all the nodes
+ */
+size_t graph_csr_total_edges(graph_csr_t * csr)
+{
+    return csr->edge_count;
+}
+
+/*!
+ * @brief Fetch the gnode of the given id
+ * @param csr Pointer to the snapshot object
+ * @param id Id of the node
+ * @return Pointer to the gnode or NULL if the id is out of range
+ */
+gnode_t * graph_csr_get_node(graph_csr_t * csr, size_t id)
+{
+    if (id >= csr->node_count)
+    {
+        return NULL;
+    }
+    return csr->nodes[id];
+}
+
+/*!
+ * @brief Fetch the id of the node in the snapshot. A node of the frozen graph
+ * is found in O(1), any other node is matched by value.
+ *
+ * @param csr Pointer to the snapshot object
+ * @param node Pointer to the node to search for
+ * @return Id of the node or GRAPH_NO_ID if the node is not in the snapshot
+ */
+size_t graph_csr_get_node_id(graph_csr_t * csr, gnode_t * node)
+{
+    graph_view_t view;
+    graph_view_of_csr(csr, &view);
+    return graph_view_get_node_id(&view, node);
+}
+
+/*!
+ * @brief Fetch the number of neighbors that a node has
+ * @param csr Pointer to the snapshot object
+ * @param id Id of the node
+ * @return Number of neighbors of the node
+ */
+size_t graph_csr_edge_count(graph_csr_t * csr, size_t id)
+{
+    assert(id < csr->node_count);
+    return (size_t)(csr->offsets[id + 1] - csr->offsets[id]);
+}
+
+/*!
+ * @brief Fetch the neighbors of a node without any allocation. The arrays
+ * point into the snapshot and are sorted by target id.
+ *
+ * @param csr Pointer to the snapshot object
+ * @param id Id of the node
+ * @param targets Set to the ids of the neighbors
+ * @param weights Set to the weights of the edges, may be NULL
+ * @return Number of items in the targets and weights arrays
+ */
+size_t graph_csr_get_neighbors(graph_csr_t * csr,
+                               size_t id,
+                               const uint32_t ** targets,
+                               const uint32_t ** weights)
+{
+    assert(id < csr->node_count);
+    assert(targets);
+
+    * targets = csr->targets + csr->offsets[id];
+    if (NULL != weights)
+    {
+        * weights = csr->weights + csr->offsets[id];
+    }
+    return graph_csr_edge_count(csr, id);
+}
+
+/*!
+ * @brief Find the index of the edge from the source to the target with a
+ * binary search on the sorted row of the source
+ * @return Index into targets and weights or UINT64_MAX if there is no edge
+ */
+static uint64_t find_edge(graph_csr_t * csr, size_t source_id, size_t target_id)
+{
+    if ((source_id >= csr->node_count) || (target_id >= csr->node_count))
+    {
+        return UINT64_MAX;
+    }
+
+    uint64_t low = csr->offsets[source_id];
+    uint64_t high = csr->offsets[source_id + 1];
+    while (low < high)
+    {
+        uint64_t middle = low + ((high - low) / 2);
+        if (csr->targets[middle] < target_id)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    if ((low < csr->offsets[source_id + 1]) && (csr->targets[low] == target_id))
+    {
+        return low;
+    }
+    return UINT64_MAX;
+}
+
+/*!
+ * @brief Query if there is an edge from the source to the target
+ * @param csr Pointer to the snapshot object
+ * @param source_id Id of the source node
+ * @param target_id Id of the target node
+ * @return Bool indicating if there is an edge between the two nodes
+ */
+bool graph_csr_node_a_neighbor(graph_csr_t * csr,
+                               size_t source_id,
+                               size_t target_id)
+{
+    return (UINT64_MAX != find_edge(csr, source_id, target_id));
+}
+
+/*!
+ * @brief Fetch the weight of the edge from the source to the target
+ * @param csr Pointer to the snapshot object
+ * @param source_id Id of the source node
+ * @param target_id Id of the target node
+ * @param weight Set to the weight of the edge if it is found
+ * @return Bool indicating if the edge was found
+ */
+bool graph_csr_get_edge_weight(graph_csr_t * csr,
+                               size_t source_id,
+                               size_t target_id,
+                               uint32_t * weight)
+{
+    uint64_t index = find_edge(csr, source_id, target_id);
+    if (UINT64_MAX == index)
+    {
+        return false;
+    }
+    * weight = csr->weights[index];
+    return true;
+}
+
+/*!
+ * @brief Find the shortest path between the two nodes of the snapshot. The
+ * result is the same path_t structure returned by graph_get_path.
+ *
+ * @param csr Pointer to the snapshot object
+ * @param source_node Pointer to the source node object
+ * @param target_node Pointer to the target node object
+ * @return NULL if no path was found or a path structure containing the path
+ */
+path_t * graph_csr_get_path(graph_csr_t * csr,
+                            gnode_t * source_node,
+                            gnode_t * target_node)
+{
+    size_t source = graph_csr_get_node_id(csr, source_node);
+    size_t target = graph_csr_get_node_id(csr, target_node);
+    if ((GRAPH_NO_ID == source) || (GRAPH_NO_ID == target))
+    {
+        return NULL;
+    }
+
+    graph_view_t view;
+    graph_view_of_csr(csr, &view);
+    return graph_view_get_path(&view, source, target);
+}
+
+/*!
+ * @brief Compute the shortest path from the source node to every node of the
+ * snapshot
+ *
+ * @param csr Pointer to the snapshot object
+ * @param source_node Pointer to the source node object
+ * @return Shortest path tree or NULL if the source is not in the snapshot
+ */
+graph_spt_t * graph_csr_shortest_path_tree(graph_csr_t * csr,
+                                           gnode_t * source_node)
+{
+    size_t source = graph_csr_get_node_id(csr, source_node);
+    if (GRAPH_NO_ID == source)
+    {
+        return NULL;
+    }
+
+    graph_view_t view;
+    graph_view_of_csr(csr, &view);
+    return graph_view_shortest_path_tree(&view, source);
+}
+
+/*!
+ * @brief Perform a breadth first search from the source node of the snapshot.
+ * Only GRAPH_DIRECTED snapshots, whose edges all have a mirror, can expand
+ * large levels bottom up. Other snapshots are searched top down.
+ *
+ * @param csr Pointer to the snapshot object
+ * @param source_node Pointer to the source node object
+ * @param thread_count Number of threads to use, 0 for one per online cpu
+ * @return Result of the search or NULL if the source is not in the snapshot
+ */
+graph_bfs_t * graph_csr_bfs(graph_csr_t * csr, gnode_t * source_node, size_t thread_count)
+{
+    size_t source = graph_csr_get_node_id(csr, source_node);
+    if (GRAPH_NO_ID == source)
+    {
+        return NULL;
+    }
+
+    graph_view_t view;
+    graph_view_of_csr(csr, &view);
+    return graph_view_bfs(&view,
+                          (GRAPH_DIRECTED == csr->graph_mode) ? &view : NULL,
+                          source,
+                          thread_count);
+}
+
+/*!
+ * @brief Label the connected components of the snapshot, see
+ * graph_connected_components
+ *
+ * @param csr Pointer to the snapshot object
+ * @param thread_count Number of threads to use, 0 for one per online cpu
+ * @return Component labels or NULL if an allocation failed
+ */
+graph_components_t * graph_csr_connected_components(graph_csr_t * csr, size_t thread_count)
+{
+    graph_view_t view;
+    graph_view_of_csr(csr, &view);
+    return graph_view_components(&view, thread_count);
+}
+
+/*!
+ * @brief Create a view over the snapshot for the shared algorithms
+ * @param csr Pointer to the snapshot object
+ * @param view View to initialize
+ */
+void graph_view_of_csr(graph_csr_t * csr, graph_view_t * view)
+{
+    * view = (graph_view_t){
+        .node_count         = csr->node_count,
+        .edge_count         = csr->edge_count,
+        .nodes              = csr->nodes,
+        .offsets            = csr->offsets,
+        .targets            = csr->targets,
+        .weights            = csr->weights,
+        .reverse            = false,
+        .compare_callback   = csr->compare_callback
+    };
+}
+
+/*!
+ * @brief Sort the neighbors of every node by their id
+ * @param csr Pointer to the snapshot object
+ * @return False if the scratch buffer could not be allocated
+ */
+static bool sort_rows(graph_csr_t * csr)
+{
+    size_t max_degree = 0;
+    for (size_t id = 0; id < csr->node_count; id++)
+    {
+        size_t degree = graph_csr_edge_count(csr, id);
+        if (degree > max_degree)
+        {
+            max_degree = degree;
+        }
+    }
+    if (max_degree < 2)
+    {
+        return true;
+    }
+
+    csr_edge_t * row = (csr_edge_t *)malloc(sizeof(csr_edge_t) * max_degree);
+    if (UV_INVALID_ALLOC == verify_alloc(row))
+    {
+        return false;
+    }
+
+    for (size_t id = 0; id < csr->node_count; id++)
+    {
+        uint64_t start = csr->offsets[id];
+        size_t degree = graph_csr_edge_count(csr, id);
+        if (degree < 2)
+        {
+            continue;
+        }
+
+        for (size_t index = 0; index < degree; index++)
+        {
+            row[index] = (csr_edge_t){
+                .target = csr->targets[start + index],
+                .weight = csr->weights[start + index]
+            };
+        }
+        qsort(row, degree, sizeof(csr_edge_t), compare_csr_edges);
+        for (size_t index = 0; index < degree; index++)
+        {
+            csr->targets[start + index] = row[index].target;
+            csr->weights[start + index] = row[index].weight;
+        }
+    }
+
+    free(row);
+    return true;
+}
+
+static int compare_csr_edges(const void * left, const void * right)
+{
+    const csr_edge_t * edge_left = (const csr_edge_t *)left;
+    const csr_edge_t * edge_right = (const csr_edge_t *)right;
+    if (edge_left->target != edge_right->target)
+    {
+        return (edge_left->target < edge_right->target) ? -1 : 1;
+    }
+    if (edge_left->weight != edge_right->weight)
+    {
+        return (edge_left->weight < edge_right->weight) ? -1 : 1;
+    }
+    return 0;
+}
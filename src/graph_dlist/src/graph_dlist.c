@@ -4,53 +4,80 @@
 
 #include <graph_dlist.h>
 #include <hashtable.h>
-#include <heap.h>
 #include <utils.h>
 
-typedef struct graph_t
-{
-    dlist_t * nodes;
-    graph_mode_t graph_mode;
-    dlist_match_t (* compare_callback)(void *, void *);
-    uint64_t (* hash_callback)(void *);
-} graph_t;
+#include "graph_internal.h"
 
-typedef struct gnode_t
+typedef enum
 {
-    void * data;
-    dlist_t * edges;
-} gnode_t;
-
-
-typedef struct dijkstra_t dijkstra_t;
-typedef struct dijkstra_t
+    GRAPH_BASE_SIZE = 8,            // Initial size of the node array
+    GRAPH_EDGE_INDEX_DEGREE = 32,   // Degree at which a node indexes its edges
+} graph_size_t;
+
+/*
+ * Storage of an edge_t. The public edge is the first member so a pointer to
+ * the edge is also a pointer to its storage. The storage remembers the dnodes
+ * holding the edge and the mirrored edge of GRAPH_DIRECTED mode, which makes
+ * unlinking an edge O(1).
+ */
+typedef struct graph_edge_t
 {
-    gnode_t * self;
-    uint32_t distance;
-    dijkstra_t * prev;
-} dijkstra_t;
+    edge_t edge;
+    dnode_t * out_link;             // dnode in the edges of from_node
+    dnode_t * in_link;              // dnode in the in_edges of to_node or NULL
+    struct graph_edge_t * mirror;   // Edge going the other way or NULL
+} graph_edge_t;
+
+// Edge of a bulk load with its nodes resolved to ids
+typedef struct build_edge_t
+{
+    size_t source;
+    size_t target;
+    uint32_t weight;
+} build_edge_t;
 
-static edge_t * create_edge(gnode_t * from_node,
+static edge_t * create_edge(graph_t * graph,
+                            gnode_t * from_node,
                             gnode_t * to_node,
                             uint32_t weight);
+static bool init_node(gnode_t * node, void * data);
+static gnode_t * create_pooled_node(graph_t * graph, void * data);
+static dnode_t * alloc_link(void * pool);
+static void free_link(void * pool, dnode_t * link);
 static dlist_match_t compare_nodes(void * left, void * right);
 static void free_edge_dnode(void * node);
 static void free_edges(dlist_t * edge);
-static heap_compare_t heap_ptr_cmp(void * left, void * right);
-static dijkstra_t * get_dijkstra_node(gnode_t * self_node);
-static void init_min_heap(heap_t * heap,
-                          graph_t * graph,
-                          gnode_t * source,
-                          htable_t * table);
-static void free_dijkstra_node(void * node);
-/*!
- * @brief Initialize a adjacency list graph structure that uses a double linked
- * list for both the nodes and edges. When time allows, it will be best to
- * substitute the list of nodes for a hast table of nodes for significantly
- * increase lookup times.
+static gnode_t * get_stored_node(graph_t * graph, gnode_t * node);
+static bool ensure_node_space(graph_t * graph);
+static htable_match_t compare_index_nodes(void * left, void * right);
+static edge_t * find_edge(gnode_t * source_node, gnode_t * target_node);
+static edge_t * link_edge(graph_t * graph,
+                          gnode_t * source_node,
+                          gnode_t * target_node,
+                          uint32_t weight);
+static void unlink_edge(graph_t * graph, gnode_t * source_node, edge_t * edge);
+static void pair_edges(edge_t * edge, edge_t * mirror);
+static size_t resolve_node(graph_t * graph, void * value);
+static bool link_bulk_edges(graph_t * graph,
+                            const build_edge_t * edges,
+                            size_t edge_count);
+static void build_edge_index(gnode_t * node);
+static uint64_t hash_edge_target(void * key);
+static htable_match_t compare_edge_targets(void * left, void * right);
+
+/*!
+ * @brief Initialize a adjacency list graph structure. The nodes are kept in a
+ * dense array where each node knows its index (its id) and the edges of each
+ * node are kept in a double linked list.
+ *
+ * The nodes are also indexed in a hashtable so that looking up a node by its
+ * value is O(1). The hash_callback receives a gnode_t and must hash the value
+ * returned by graph_get_node_value, values that match with the
+ * compare_callback must produce the same hash.
  *
  * @param graph_mode GRAPH_DIRECTIONAL_TRUE OR GRAPH_DIRECTIONAL_FALSE
  * @param compare_callback Function pointer for making comparisons between nodes
+ * @param hash_callback Function pointer for hashing a gnode_t by its value
  * @return Pointer to graph object or NULL with a stdout message
  */
 graph_t * graph_init(graph_mode_t graph_mode,
@@ -66,20 +93,45 @@ graph_t * graph_init(graph_mode_t graph_mode,
         return NULL;
     }
 
-    dlist_t * dlist = dlist_init(compare_callback);
-    if (NULL == dlist)
+    gnode_t ** nodes = (gnode_t **)calloc(GRAPH_BASE_SIZE, sizeof(gnode_t *));
+    if (UV_INVALID_ALLOC == verify_alloc(nodes))
     {
-        graph_destroy(graph, NULL);
+        free(graph);
+        return NULL;
+    }
+
+    htable_t * node_index = htable_create(hash_callback,
+                                          compare_index_nodes,
+                                          NULL,
+                                          NULL);
+    if (NULL == node_index)
+    {
+        free(nodes);
+        free(graph);
         return NULL;
     }
 
     * graph = (graph_t){
-        .nodes              = dlist,
+        .nodes              = nodes,
+        .node_count         = 0,
+        .node_size          = GRAPH_BASE_SIZE,
+        .edge_count         = 0,
+        .node_index         = node_index,
         .compare_callback   = compare_callback,
         .hash_callback      = hash_callback,
         .graph_mode         = graph_mode
     };
 
+    // Nodes, edges and the dnodes of the edge lists are carved from pools
+    // owned by the graph and freed with it
+    graph_pool_init(&graph->node_pool, sizeof(gnode_t));
+    graph_pool_init(&graph->edge_pool, sizeof(graph_edge_t));
+    graph_pool_init(&graph->link_pool, sizeof(dnode_t));
+    graph->link_allocator = (dlist_allocator_t){
+        .alloc_node = alloc_link,
+        .free_node  = free_link,
+        .pool       = &graph->link_pool
+    };
     return graph;
 }
 
@@ -97,7 +149,7 @@ static void get_hex_value(void * ptr, char * string, size_t buff_size)
  */
 size_t graph_node_count(graph_t * graph)
 {
-    return dlist_get_length(graph->nodes);
+    return graph->node_count;
 }
 
 
@@ -107,8 +159,6 @@ size_t graph_node_count(graph_t * graph)
  */
 void graph_print(graph_t * graph, char * (node_data_repr(void *)))
 {
-    dlist_iter_t * nodes = dlist_get_iterable(graph->nodes, ITER_HEAD);
-    gnode_t * node = iter_get_value(nodes);
     char buff[5];
 
     puts("<#>:          Node value if available by callback repr");
@@ -116,8 +166,9 @@ void graph_print(graph_t * graph, char * (node_data_repr(void *)))
     puts("-> <#>(#)[5]: Node value if available followed by the last\n"
          "              2 bytes of the pointer followed by the weight of the edge");
 
-    while (NULL != node)
+    for (size_t id = 0; id < graph->node_count; id++)
     {
+        gnode_t * node = graph->nodes[id];
         get_hex_value(node, buff, sizeof(buff));
         if (NULL != node_data_repr)
         {
@@ -156,9 +207,7 @@ void graph_print(graph_t * graph, char * (node_data_repr(void *)))
             dlist_destroy_iter(edges);
         }
         printf("\n");
-        node = dlist_get_iter_next(nodes);
     }
-    dlist_destroy_iter(nodes);
     printf("\n");
 }
 
@@ -186,16 +235,20 @@ void graph_destroy_neighbors_list(dlist_iter_t * neighbors)
  *
  * @param graph Pointer to the graph object
  * @param value Pointer to the value being stored in the graph
- * @return GRAPH_SUCCESS or GRAPH_FAIL_NODE_ALREADY_EXISTS
+ * @return GRAPH_SUCCESS, GRAPH_FAIL_NODE_ALREADY_EXISTS or GRAPH_ALLOC_FAILED
  */
 graph_opt_t graph_add_value(graph_t * graph, void * value)
 {
-    gnode_t * node = graph_create_node(value);
+    gnode_t * node = create_pooled_node(graph, value);
+    if (NULL == node)
+    {
+        return GRAPH_ALLOC_FAILED;
+    }
     graph_opt_t result = graph_add_node(graph, node);
 
-    // If the node already exists in the graph then free the node created
-    // and return the error
-    if (GRAPH_FAIL_NODE_ALREADY_EXISTS == result)
+    // If the node could not be added then free the node created and return
+    // the error
+    if (GRAPH_SUCCESS != result)
     {
         graph_destroy_node(node, NULL);
     }
@@ -208,7 +261,8 @@ graph_opt_t graph_add_value(graph_t * graph, void * value)
  *
  * @param graph Pointer to the graph object
  * @param node Pointer to the node object
- * @return GRAPH_SUCCESS or GRAPH_FAIL_NODE_ALREADY_EXISTS
+ * @return GRAPH_SUCCESS, GRAPH_FAIL_NODE_ALREADY_EXISTS or GRAPH_ALLOC_FAILED
+ * if the node array or the node index could not grow
  */
 graph_opt_t graph_add_node(graph_t * graph, gnode_t * node)
 {
@@ -220,7 +274,29 @@ graph_opt_t graph_add_node(graph_t * graph, gnode_t * node)
         return GRAPH_FAIL_NODE_ALREADY_EXISTS;
     }
 
-    dlist_append(graph->nodes, node);
+    if (!ensure_node_space(graph))
+    {
+        return GRAPH_ALLOC_FAILED;
+    }
+
+    // htable_set returns NULL for new keys, so a failed insert is only
+    // visible through the length of the index
+    size_t indexed = htable_get_length(graph->node_index);
+    node->id = graph->node_count;
+    node->graph = graph;
+    htable_set(graph->node_index, node, node);
+    if (htable_get_length(graph->node_index) == indexed)
+    {
+        node->id = GRAPH_NO_ID;
+        node->graph = NULL;
+        return GRAPH_ALLOC_FAILED;
+    }
+    graph->nodes[graph->node_count] = node;
+    graph->node_count++;
+
+    // A node can only gain edges once it is in a graph, so its edge list is
+    // still empty and can switch to the dnode pool of the graph
+    dlist_set_allocator(node->edges, &graph->link_allocator);
     return GRAPH_SUCCESS;
 }
 
@@ -234,6 +310,20 @@ void * graph_get_node_value(gnode_t * node)
     return node->data;
 }
 
+/*!
+ * @brief Fetch the id of the gnode object. The ids of a graph are dense, they
+ * go from 0 to graph_node_count - 1, which allows algorithms to keep their
+ * per node state in flat arrays. Removing a node moves the last node of the
+ * graph into the id of the removed node.
+ *
+ * @param node gnode object to fetch the id from
+ * @return Id of the node or GRAPH_NO_ID if the node is not in a graph
+ */
+size_t graph_get_node_id(gnode_t * node)
+{
+    return node->id;
+}
+
 /*!
  * @brief Remove a node from the graph and all its neighbors. This will also
  * remove the opposite side if the graph is directed
@@ -244,33 +334,38 @@ void * graph_get_node_value(gnode_t * node)
  */
 graph_opt_t graph_remove_node(graph_t * graph, gnode_t * node, void(free_func(void *)))
 {
-    if (!graph_node_in_graph(graph, node))
+    node = get_stored_node(graph, node);
+    if (NULL == node)
     {
         return GRAPH_NODE_NOT_FOUND;
     }
 
-    //First remove the edges
-    dlist_iter_t * neighbors = graph_get_neighbors_list(node);
-    edge_t * neighbor = iter_get_value(neighbors);
-    while (0 == dlist_get_iter_index(neighbors))
+    // First remove the edges. Every edge leading to the node is either the
+    // mirror of one of its edges or one of its in_edges, so the cost is the
+    // degree of the node
+    while (!dlist_is_empty(node->edges))
     {
-        if (GRAPH_DIRECTED == graph->graph_mode)
+        graph_edge_t * edge = (graph_edge_t *)dlist_get_head_node(node->edges)->data;
+        if (NULL != edge->mirror)
         {
-            graph_remove_edge(graph, node, neighbor->to_node);
+            unlink_edge(graph, edge->edge.to_node, &edge->mirror->edge);
         }
-        else
-        {
-            // If graph is not directional, and attempt to remove edge from
-            // both sides
-            graph_remove_edge(graph, neighbor->to_node, node);
-            graph_remove_edge(graph, node, neighbor->to_node);
-        }
-        neighbor = iter_get_value(neighbors);
+        unlink_edge(graph, node, &edge->edge);
     }
-    graph_destroy_neighbors_list(neighbors);
+    while ((NULL != node->in_edges) && !dlist_is_empty(node->in_edges))
+    {
+        edge_t * edge = (edge_t *)dlist_get_head_node(node->in_edges)->data;
+        unlink_edge(graph, edge->from_node, edge);
+    }
+
+    // Now we just remove the node from the graph by moving the last node into
+    // its slot which keeps the ids dense
+    gnode_t * last = graph->nodes[graph->node_count - 1];
+    graph->nodes[node->id] = last;
+    last->id = node->id;
+    graph->node_count--;
+    htable_del(graph->node_index, node, HT_FREE_PTR_FALSE);
 
-    // Now we just remove the node from the graph
-    dlist_remove_value(graph->nodes, node);
     graph_destroy_node(node, free_func);
     return GRAPH_SUCCESS;
 }
@@ -288,44 +383,32 @@ gnode_t * graph_create_node(void * data)
         return NULL;
     }
 
-    dlist_t * dlist = dlist_init(compare_nodes);
-    if (NULL == dlist)
+    if (!init_node(node, data))
     {
-        graph_destroy_node(node, NULL);
+        free(node);
+        return NULL;
     }
-
-    * node = (gnode_t){
-        .data   = data,
-        .edges  = dlist
-    };
-
     return node;
 }
 
 /*!
- * @brief Fetch a node in the graph by its stored value using the comparison
- * callback passed in
+ * @brief Fetch a node in the graph by its stored value using the node index.
+ * The value is wrapped in a probe gnode_t since the hash_callback works on
+ * gnode_t objects.
  * @param graph Pointer to the graph object
  * @param data Data to search for
  * @return Pointer to the graph object if found, else NULL
  */
 gnode_t * graph_get_node_by_value(graph_t * graph, void * data)
 {
-    dlist_iter_t * nodes = dlist_get_iterable(graph->nodes, ITER_HEAD);
-    gnode_t * node = iter_get_value(nodes);
-    dlist_match_t result;
-
-    while (NULL != node)
-    {
-        result = graph->compare_callback(node->data, data);
-        if (DLIST_MATCH == result)
-        {
-            break;
-        }
-        node = dlist_get_iter_next(nodes);
-    }
-    dlist_destroy_iter(nodes);
-    return node;
+    gnode_t probe = {
+        .data       = data,
+        .edges      = NULL,
+        .id         = GRAPH_NO_ID,
+        .graph      = NULL,
+        .edge_index = NULL
+    };
+    return (gnode_t *)htable_get(graph->node_index, &probe);
 }
 
 /*!
@@ -336,7 +419,7 @@ gnode_t * graph_get_node_by_value(graph_t * graph, void * data)
  */
 bool graph_node_in_graph(graph_t * graph, gnode_t * node)
 {
-    return graph_value_in_graph(graph, node->data);
+    return (NULL != get_stored_node(graph, node));
 }
 
 /*!
@@ -392,7 +475,21 @@ void graph_destroy_node(gnode_t * node, void (* free_func)(void *))
     {
         free_func(node->data);
     }
+    if (NULL != node->edge_index)
+    {
+        htable_destroy(node->edge_index, HT_FREE_PTR_FALSE, HT_FREE_PTR_FALSE);
+    }
+    if (NULL != node->in_edges)
+    {
+        // The edges are owned by the edge lists of their source nodes
+        dlist_destroy(node->in_edges);
+    }
     free_edges(node->edges);
+    if (NULL != node->pool)
+    {
+        graph_pool_release(node->pool, node);
+        return;
+    }
     free(node);
 }
 
@@ -410,6 +507,8 @@ void graph_destroy_node(gnode_t * node, void (* free_func)(void *))
  * GRAPH_EDGE_ALREADY_EXISTS if the edge already exists.
  * GRAPH_NODE_NOT_FOUND if node is the node attempting to link is not in the
  * graph
+ * GRAPH_ALLOC_FAILED if the edge or its mirror could not be allocated, the
+ * graph is then unchanged
  */
 graph_opt_t graph_add_edge(graph_t * graph,
                            gnode_t * source_node,
@@ -421,8 +520,9 @@ graph_opt_t graph_add_edge(graph_t * graph,
     assert(target_node);
 
     // First make sure that both nodes are already in the graph
-    if (!(graph_node_in_graph(graph, source_node))
-        || !(graph_node_in_graph(graph, target_node)))
+    source_node = get_stored_node(graph, source_node);
+    target_node = get_stored_node(graph, target_node);
+    if ((NULL == source_node) || (NULL == target_node))
     {
         return GRAPH_NODE_NOT_FOUND;
     }
@@ -430,14 +530,14 @@ graph_opt_t graph_add_edge(graph_t * graph,
 
     // First step is to see if the source node already has the edge for that
     // target node
-    if (NULL == dlist_get_by_value(source_node->edges, target_node))
+    if (NULL != find_edge(source_node, target_node))
     {
-        edge_t * edge = create_edge(source_node, target_node, weight);
-        dlist_append(source_node->edges, edge);
+        return GRAPH_EDGE_ALREADY_EXISTS;
     }
-    else
+    edge_t * edge = link_edge(graph, source_node, target_node, weight);
+    if (NULL == edge)
     {
-        return GRAPH_EDGE_ALREADY_EXISTS;
+        return GRAPH_ALLOC_FAILED;
     }
 
     // finally, if the graph mode is unidirectional, then add the edge
@@ -445,16 +545,106 @@ graph_opt_t graph_add_edge(graph_t * graph,
     if (GRAPH_DIRECTED == graph->graph_mode)
     {
         // only add it if the edge does not exist
-        if (NULL == dlist_get_by_value(target_node->edges, source_node))
+        if (NULL == find_edge(target_node, source_node))
         {
-            edge_t * edge = create_edge(target_node, source_node, weight);
-            dlist_append(target_node->edges, edge);
+            // An edge without its mirror would break the mirrored pairs, so
+            // the first edge is taken back if the mirror can not be linked
+            edge_t * mirror = link_edge(graph, target_node, source_node, weight);
+            if (NULL == mirror)
+            {
+                unlink_edge(graph, source_node, edge);
+                return GRAPH_ALLOC_FAILED;
+            }
+            pair_edges(edge, mirror);
         }
     }
 
     return GRAPH_SUCCESS;
 }
 
+/*!
+ * @brief Build a graph from a list of edges in one pass. The nodes are created
+ * from the distinct values of the list and the edges are bucketed by their
+ * source node, which lets duplicates be dropped in O(V + E) without the
+ * membership check graph_add_edge does for every edge.
+ *
+ * The first edge of the list between two nodes is kept and every later
+ * duplicate is ignored, which is the same result as calling graph_add_edge
+ * for every edge in order. In GRAPH_DIRECTED mode an edge and its opposite
+ * are duplicates of each other.
+ *
+ * A node stores the first pointer of the list holding its value. Pointers to
+ * values that were already seen are not stored and stay owned by the caller.
+ *
+ * @param graph_mode GRAPH_DIRECTED or GRAPH_UNDIRECTED
+ * @param edges Array of edges to load
+ * @param edge_count Number of edges in the array
+ * @param compare_callback Function pointer for making comparisons between nodes
+ * @param hash_callback Function pointer for hashing a gnode_t by its value
+ * @return Pointer to the graph or NULL if an allocation failed, in which case
+ * none of the values are freed
+ */
+graph_t * graph_build_from_edges(graph_mode_t graph_mode,
+                                 const graph_edge_input_t * edges,
+                                 size_t edge_count,
+                                 dlist_match_t (* compare_callback)(void *, void *),
+                                 uint64_t (* hash_callback)(void *))
+{
+    assert(edges || (0 == edge_count));
+
+    graph_t * graph = graph_init(graph_mode, compare_callback, hash_callback);
+    if (NULL == graph)
+    {
+        return NULL;
+    }
+
+    build_edge_t * resolved = (build_edge_t *)malloc(sizeof(build_edge_t) * (edge_count + 1));
+    if (UV_INVALID_ALLOC == verify_alloc(resolved))
+    {
+        graph_destroy(graph, NULL);
+        return NULL;
+    }
+
+    bool loaded = true;
+    for (size_t index = 0; (index < edge_count) && loaded; index++)
+    {
+        size_t source = resolve_node(graph, edges[index].source_value);
+        size_t target = resolve_node(graph, edges[index].target_value);
+        loaded = (GRAPH_NO_ID != source) && (GRAPH_NO_ID != target);
+
+        // Both directions of a GRAPH_DIRECTED edge land in the same bucket
+        if ((GRAPH_DIRECTED == graph_mode) && (target < source))
+        {
+            size_t swap = source;
+            source = target;
+            target = swap;
+        }
+        resolved[index] = (build_edge_t){
+            .source = source,
+            .target = target,
+            .weight = edges[index].weight
+        };
+    }
+
+    // Carve every edge and its dnodes from one chunk per pool. A mirrored
+    // edge is stored twice and a one way edge is also in the in_edges
+    if (loaded)
+    {
+        size_t stored_count = (GRAPH_DIRECTED == graph_mode) ? 2 * edge_count : edge_count;
+        loaded = graph_pool_reserve(&graph->edge_pool, stored_count)
+                 && graph_pool_reserve(&graph->link_pool, 2 * edge_count)
+                 && link_bulk_edges(graph, resolved, edge_count);
+    }
+    free(resolved);
+
+    if (!loaded)
+    {
+        graph_destroy(graph, NULL);
+        return NULL;
+    }
+    return graph;
+}
+
 /*!
  * @brief Remove an edge from the graph. This will also remove the opposite
  * side if the graph is a directed graph
@@ -471,30 +661,26 @@ graph_opt_t graph_remove_edge(graph_t * graph, gnode_t * source_node,
     assert(target_node);
 
     // First make sure that both nodes are already in the graph
-    if (!(graph_node_in_graph(graph, source_node))
-        || !(graph_node_in_graph(graph, target_node)))
+    source_node = get_stored_node(graph, source_node);
+    target_node = get_stored_node(graph, target_node);
+    if ((NULL == source_node) || (NULL == target_node))
     {
         return GRAPH_NODE_NOT_FOUND;
     }
 
-    edge_t * edge = graph_get_edge(graph, source_node, target_node);
+    edge_t * edge = find_edge(source_node, target_node);
     if (NULL == edge)
     {
         return GRAPH_EDGE_NOT_FOUND;
     }
-    dlist_remove_value(source_node->edges, edge);
-    free_edge_dnode(edge);
 
-    if (graph->graph_mode == GRAPH_DIRECTED)
+    // The opposite side of a GRAPH_DIRECTED edge is its mirror
+    graph_edge_t * mirror = ((graph_edge_t *)edge)->mirror;
+    if (NULL != mirror)
     {
-        edge = NULL;
-        edge = graph_get_edge(graph, target_node, source_node);
-        if (NULL != edge)
-        {
-            dlist_remove_value(target_node->edges, edge);
-            free_edge_dnode(edge);
-        }
+        unlink_edge(graph, target_node, &mirror->edge);
     }
+    unlink_edge(graph, source_node, edge);
     return GRAPH_SUCCESS;
 }
 
@@ -513,31 +699,13 @@ edge_t * graph_get_edge(graph_t * graph, gnode_t * source_node,
     assert(target_node);
 
     // First make sure that both nodes are already in the graph
-    if (!(graph_node_in_graph(graph, source_node))
-        || !(graph_node_in_graph(graph, target_node)))
+    source_node = get_stored_node(graph, source_node);
+    target_node = get_stored_node(graph, target_node);
+    if ((NULL == source_node) || (NULL == target_node))
     {
         return NULL;
     }
-
-    dlist_iter_t * edges = dlist_get_iterable(source_node->edges, ITER_HEAD);
-    edge_t * edge = iter_get_value(edges);
-    bool found = false;
-    while (NULL != edge)
-    {
-        if (edge->to_node == target_node)
-        {
-            found = true;
-            break;
-        }
-        edge = dlist_get_iter_next(edges);
-    }
-
-    dlist_destroy_iter(edges);
-    if (found)
-    {
-        return edge;
-    }
-    return NULL;
+    return find_edge(source_node, target_node);
 }
 
 /*!
@@ -557,21 +725,8 @@ bool graph_edge_in_graph(graph_t * graph, edge_t * edge)
         return false;
     }
 
-    bool edge_in_graph = false;
-    // Grab all the source_node_edges from the source node of the edge we are looking for
-    dlist_iter_t * source_node_edges =
-        dlist_get_iterable(edge->from_node->edges, ITER_HEAD);
-    edge_t * source_node_edge = iter_get_value(source_node_edges);
-    while (NULL != source_node_edge)
-    {
-        if (source_node_edge->to_node == edge->to_node)
-        {
-            edge_in_graph = true;
-            break;
-        }
-    }
-    dlist_destroy_iter(source_node_edges);
-    return edge_in_graph;
+    // Look for the edge from the source node of the edge we are looking for
+    return (NULL != graph_get_edge(graph, edge->from_node, edge->to_node));
 }
 
 /*!
@@ -582,20 +737,7 @@ bool graph_edge_in_graph(graph_t * graph, edge_t * edge)
  */
 bool graph_node_a_neighbor(gnode_t * source_node, gnode_t * target_node)
 {
-    dlist_iter_t * edges = dlist_get_iterable(source_node->edges, ITER_HEAD);
-    edge_t * edge = iter_get_value(edges);
-    bool edge_in_node = false;
-    while (NULL != edge)
-    {
-        if (target_node == edge->to_node)
-        {
-            edge_in_node = true;
-            break;
-        }
-        edge = dlist_get_iter_next(edges);
-    }
-    dlist_destroy_iter(edges);
-    return edge_in_node;
+    return (NULL != find_edge(source_node, target_node));
 }
 
 /*!
@@ -606,26 +748,38 @@ bool graph_node_a_neighbor(gnode_t * source_node, gnode_t * target_node)
  */
 void graph_destroy(graph_t * graph, void (* free_func)(void *))
 {
-    // If for some reason nodes is null, just free the graph
-    if (NULL != graph->nodes)
+    // The edges and the dnodes of the edge lists all live in the pools, so
+    // only the parts of every node that are not pooled are freed here. With
+    // no free_node the edge lists skip their dnodes when they are destroyed
+    graph->link_allocator.free_node = NULL;
+    for (size_t id = 0; id < graph->node_count; id++)
     {
-        // If free function is provided then free the actual data stored in
-        // the nodes before freeing the graph structure
+        gnode_t * node = graph->nodes[id];
         if (NULL != free_func)
         {
-            dlist_iter_t * nodes = dlist_get_iterable(graph->nodes, ITER_HEAD);
-            gnode_t * g_node = iter_get_value(nodes);
-            while (NULL != g_node)
-            {
-                graph_destroy_node(g_node, free_func);
-                g_node = dlist_get_iter_next(nodes);
-            }
-            dlist_destroy_iter(nodes);
+            free_func(node->data);
+        }
+        if (NULL != node->edge_index)
+        {
+            htable_destroy(node->edge_index, HT_FREE_PTR_FALSE, HT_FREE_PTR_FALSE);
+        }
+        if (NULL != node->in_edges)
+        {
+            dlist_destroy(node->in_edges);
+        }
+        dlist_destroy(node->edges);
+        if (NULL == node->pool)
+        {
+            free(node);
         }
     }
-    // free the graph structure
-    dlist_destroy(graph->nodes);
 
+    // free the graph structure, the pools free their chunks in bulk
+    graph_pool_destroy(&graph->node_pool);
+    graph_pool_destroy(&graph->edge_pool);
+    graph_pool_destroy(&graph->link_pool);
+    htable_destroy(graph->node_index, HT_FREE_PTR_FALSE, HT_FREE_PTR_FALSE);
+    free(graph->nodes);
     free(graph);
 }
 
@@ -634,7 +788,8 @@ void graph_destroy(graph_t * graph, void (* free_func)(void *))
  * value is the path structure containing a linked list of the nodes in order
  * with its accumulated weight.
  *
- * The function utilizes a min priority queue and two hashtables.
+ * The search keeps its state in flat arrays indexed by the node ids and stops
+ * as soon as the target node is reached.
  * @param graph Pointer to the graph structure
  * @param source_node Pointer to the source node object
  * @param target_node Pointer to the target node object
@@ -643,229 +798,246 @@ void graph_destroy(graph_t * graph, void (* free_func)(void *))
 path_t * graph_get_path(graph_t * graph, gnode_t * source_node, gnode_t * target_node)
 {
     // First make sure that both nodes are already in the graph
-    if (!(graph_node_in_graph(graph, source_node))
-        || !(graph_node_in_graph(graph, target_node)))
+    source_node = get_stored_node(graph, source_node);
+    target_node = get_stored_node(graph, target_node);
+    if ((NULL == source_node) || (NULL == target_node))
     {
         return NULL;
     }
 
-    // Create the queue that contains all the paths
-    heap_t * heap = heap_init(MIN_HEAP,
-                             HEAP_PTR,
-                             0,
-                             NULL,
-                             heap_ptr_cmp);
-
-
-    // Table to quickly map gnode_t -> dij_node_t
-    htable_t * dij_lookup_table = htable_create(
-        graph->hash_callback,
-        (htable_match_t (*)(void *, void *))graph->compare_callback,
-        NULL,
-        free_dijkstra_node);
-
-    // Table for marking the visited items
-    // Table to quickly map gnode_t -> gnode_t
-    htable_t * visited_table = htable_create(
-        graph->hash_callback,
-        (htable_match_t (*)(void *, void *))graph->compare_callback,
-        NULL,
-        free_dijkstra_node);
+    graph_view_t view;
+    graph_view_of_graph(graph, &view);
+    return graph_view_get_path(&view, source_node->id, target_node->id);
+}
 
-    // Populate the heap structure
-    init_min_heap(heap, graph, source_node, dij_lookup_table);
-    bool target_found = false;
-    dijkstra_t * curr_dij_node;
-    while (!heap_is_empty(heap))
+/*!
+ * @brief Find the shortest path between two nodes by searching from both ends
+ * at once until the two searches meet. This explores far fewer nodes than
+ * graph_get_path on point to point queries. In GRAPH_UNDIRECTED mode the
+ * backward search follows the in_edges kept on every node.
+ *
+ * @param graph Pointer to the graph structure
+ * @param source_node Pointer to the source node object
+ * @param target_node Pointer to the target node object
+ * @return NULL if no path was found or a path structure containing the path
+ */
+path_t * graph_get_path_bidirectional(graph_t * graph,
+                                      gnode_t * source_node,
+                                      gnode_t * target_node)
+{
+    source_node = get_stored_node(graph, source_node);
+    target_node = get_stored_node(graph, target_node);
+    if ((NULL == source_node) || (NULL == target_node))
     {
-        // Peek the next item from the priority queue
-        curr_dij_node = (dijkstra_t *)heap_peek(heap);
-
-        if (curr_dij_node->self == target_node)
-        {
-            target_found = true;
-            break;
-        }
-
-        // Add current dij_node to the visited list
-        htable_set(visited_table,
-                   (void *)curr_dij_node->self,
-                   curr_dij_node->self);
+        return NULL;
+    }
 
-        // Iterate over all the neighbors of the current node
-        dlist_iter_t * neighbors = graph_get_neighbors_list(curr_dij_node->self);
-        edge_t * neighbor = iter_get_value(neighbors);
-        while (NULL != neighbor)
-        {
-            // Grab the neigh_dij_node that belongs to the current neighbor
-            dijkstra_t * neigh_dij_node = (dijkstra_t *)htable_get(dij_lookup_table, (void *)neighbor->to_node);
+    graph_view_t view;
+    graph_view_t reverse;
+    graph_view_of_graph(graph, &view);
+    graph_view_reverse_of_graph(graph, &reverse);
+    return graph_view_get_path_bidirectional(&view, &reverse,
+                                             source_node->id, target_node->id);
+}
 
-            // Make sure that the current neighbor was not already visited
-            // if it was, we can skip to the next one
-            if (htable_key_exists(visited_table, (void *)neigh_dij_node->self))
-            {
-                neighbor = dlist_get_iter_next(neighbors);
-                continue;
-            }
+/*!
+ * @brief Find the shortest path between two nodes with the A* algorithm. The
+ * heuristic estimates the remaining weight from a node to the target, which
+ * makes the search expand the nodes that lead towards the target first and
+ * leave most of the graph untouched on point to point queries.
+ *
+ * The heuristic must be admissible, it may never return more than the real
+ * weight of the shortest path from the node to the target, otherwise the path
+ * returned may not be the shortest. A heuristic that always returns 0 gives
+ * the same result as graph_get_path.
+ *
+ * @param graph Pointer to the graph structure
+ * @param source_node Pointer to the source node object
+ * @param target_node Pointer to the target node object
+ * @param heuristic Callback returning the estimate from a node to the target
+ * @param ctx Context passed to every call of the heuristic
+ * @return NULL if no path was found or a path structure containing the path
+ */
+path_t * graph_get_path_astar(graph_t * graph,
+                              gnode_t * source_node,
+                              gnode_t * target_node,
+                              graph_heuristic_t heuristic,
+                              void * ctx)
+{
+    assert(heuristic);
 
-            /*
-             * This one might be a little hard to read. Here we are checking to
-             * see if the current distance from the neigh_dij_node (should be MAX
-             * if never seen before) is greater than the current distance
-             * (will be 0 for the source) plus the weight of the two nodes
-             * connection.
-             *
-             * If it is less, than update the distance to the new value. This
-             * should make the MAX distance to a lower value when it connects
-             * to the source
-             */
-            if (neigh_dij_node->distance > (curr_dij_node->distance + neighbor->weight))
-            {
-                // Set the previous to be the current dij node we are inspecting
-                neigh_dij_node->distance = curr_dij_node->distance + neighbor->weight;
-                neigh_dij_node->prev = curr_dij_node;
-            }
-            neighbor = dlist_get_iter_next(neighbors);
-        }
+    source_node = get_stored_node(graph, source_node);
+    target_node = get_stored_node(graph, target_node);
+    if ((NULL == source_node) || (NULL == target_node))
+    {
+        return NULL;
+    }
 
-        // Actually remove the value from the heap after the values were modified
-        heap_pop(heap);
-        dlist_destroy_iter(neighbors);
+    graph_view_t view;
+    graph_view_of_graph(graph, &view);
+    graph_search_t * search = graph_search_init(view.node_count);
+    if (NULL == search)
+    {
+        return NULL;
     }
 
     path_t * path = NULL;
-    if (target_found)
+    if (graph_search_run_astar(search, &view, source_node->id, target_node->id,
+                               heuristic, ctx))
     {
-        dlist_t * path_list = dlist_init(graph->compare_callback);
-        uint64_t path_weight = curr_dij_node->distance;
-        dlist_append(path_list, curr_dij_node->self);
-        dijkstra_t * prev = curr_dij_node->prev;
-        while (NULL != prev)
-        {
-            dlist_append(path_list, prev->self);
-            prev = prev->prev;
-        }
-
-        dlist_iter_t * iter = dlist_get_iterable(path_list, ITER_HEAD);
-        gnode_t * node = iter_get_value(iter);
-        while (NULL != node)
-        {
-            node = (gnode_t *)dlist_get_iter_next(iter);
-        }
-        dlist_destroy_iter(iter);
-
-        // reverse the order of the list to show the relationship
-        // from source -> target
-        dlist_reverse(path_list);
-
-        // Save the items into the path structure
-        path = (path_t *)malloc(sizeof(path_t));
-        path->path = path_list;
-        path->path_weight = path_weight;
+        path = graph_view_build_path(&view,
+                                     search->prev,
+                                     target_node->id,
+                                     search->distances[target_node->id]);
     }
 
-    heap_destroy(heap);
-    htable_destroy(visited_table, HT_FREE_PTR_FALSE, HT_FREE_PTR_FALSE);
-    htable_destroy(dij_lookup_table, HT_FREE_PTR_FALSE, HT_FREE_PTR_TRUE);
+    graph_search_destroy(search);
     return path;
 }
 
-void graph_free_path(path_t * path)
+/*!
+ * @brief Compute the shortest path from the source node to every node of the
+ * graph. The tree holds the distance and the previous node of every node, so
+ * any number of paths from the same source can be extracted from it in the
+ * length of the path without searching again.
+ *
+ * The tree refers to the nodes of the graph, the graph must not be modified
+ * while the tree is in use.
+ *
+ * @param graph Pointer to the graph structure
+ * @param source_node Pointer to the source node object
+ * @return Shortest path tree or NULL if the source is not in the graph
+ */
+graph_spt_t * graph_shortest_path_tree(graph_t * graph, gnode_t * source_node)
 {
-    dlist_destroy(path->path);
-    free(path);
+    source_node = get_stored_node(graph, source_node);
+    if (NULL == source_node)
+    {
+        return NULL;
+    }
+
+    graph_view_t view;
+    graph_view_of_graph(graph, &view);
+    return graph_view_shortest_path_tree(&view, source_node->id);
 }
 
 /*!
- * @brief Iterate over all the nodes in the graph and create dijsktra_t path
- * nodes while setting the source to 0.
+ * @brief Perform a breadth first search from the source node. The result
+ * holds the number of hops from the source to every node and the parent of
+ * every node in the BFS tree.
+ *
+ * Large levels are expanded bottom up through the in_edges of the nodes, the
+ * work of a level is spread across a pool of threads.
  *
- * @param heap Min priority heap of all the dijkstra nodes
- * @param graph Graph of all the nodes
- * @param source The source node to start searching from.
+ * @param graph Pointer to the graph structure
+ * @param source_node Pointer to the source node object
+ * @param thread_count Number of threads to use, 0 for one per online cpu
+ * @return Result of the search or NULL if the source is not in the graph
  */
-static void init_min_heap(heap_t * heap,
-                          graph_t * graph,
-                          gnode_t * source,
-                          htable_t * table)
+graph_bfs_t * graph_bfs(graph_t * graph, gnode_t * source_node, size_t thread_count)
 {
-    dlist_iter_t * nodes = dlist_get_iterable(graph->nodes, ITER_HEAD);
-    gnode_t * node = iter_get_value(nodes);
-    while (NULL != node)
+    source_node = get_stored_node(graph, source_node);
+    if (NULL == source_node)
     {
-        dijkstra_t * dj_node = get_dijkstra_node(node);
-        if (node == source)
-        {
-            // Set the source nodes distance to 0 since it is the start
-            dj_node->distance = 0;
-        }
-        heap_insert(heap, dj_node);
-        htable_set(table, (void *)node, dj_node);
-        node = dlist_get_iter_next(nodes);
+        return NULL;
     }
-    dlist_destroy_iter(nodes);
+
+    graph_view_t view;
+    graph_view_t reverse;
+    graph_view_of_graph(graph, &view);
+    graph_view_reverse_of_graph(graph, &reverse);
+    return graph_view_bfs(&view, &reverse, source_node->id, thread_count);
 }
 
-static heap_compare_t heap_ptr_cmp(void * left, void * right)
+/*!
+ * @brief Label the connected components of the graph. Edges are treated as
+ * undirected, so in GRAPH_UNDIRECTED mode where edges go one way these are
+ * the weakly connected components.
+ *
+ * @param graph Pointer to the graph structure
+ * @param thread_count Number of threads to use, 0 for one per online cpu
+ * @return Component labels or NULL if an allocation failed
+ */
+graph_components_t * graph_connected_components(graph_t * graph, size_t thread_count)
 {
-    dijkstra_t * d_left = (dijkstra_t *)left;
-    dijkstra_t * d_right = (dijkstra_t *)right;
-
-    if (d_left->distance > d_right->distance)
-    {
-        return HEAP_GT;
-    }
-    else if (d_left->distance < d_right->distance)
-    {
-        return HEAP_LT;
-    }
-    return HEAP_EQ;
+    graph_view_t view;
+    graph_view_of_graph(graph, &view);
+    return graph_view_components(&view, thread_count);
 }
 
+/*!
+ * @brief Label the strongly connected components of the graph. Two nodes share
+ * a label if each can reach the other. The labels follow the topological order
+ * of the components, so every edge between two components goes from a smaller
+ * to a larger label.
+ *
+ * In GRAPH_DIRECTED mode every edge has its mirror, which makes these the same
+ * components as graph_connected_components. One way edges are only stored in
+ * GRAPH_UNDIRECTED mode.
+ *
+ * @param graph Pointer to the graph structure
+ * @return Component labels or NULL if an allocation failed
+ */
+graph_components_t * graph_strongly_connected_components(graph_t * graph)
+{
+    graph_view_t view;
+    graph_view_of_graph(graph, &view);
+    return graph_view_strong_components(&view);
+}
 
-static dijkstra_t * get_dijkstra_node(gnode_t * self_node)
+/*!
+ * @brief Order the nodes of the graph so that every edge goes from a node to a
+ * node after it. The graph must not have a cycle, which in GRAPH_DIRECTED mode
+ * means it must not have any edge since every edge has its mirror.
+ *
+ * @param graph Pointer to the graph structure
+ * @return dlist of the gnode_t in topological order or NULL if the graph has a
+ * cycle. The dlist is freed with dlist_destroy
+ */
+dlist_t * graph_topological_sort(graph_t * graph)
 {
-    dijkstra_t * node = (dijkstra_t *)malloc(sizeof(dijkstra_t));
-    if (UV_INVALID_ALLOC == verify_alloc(node))
-    {
-        return NULL;
-    }
-    * node = (dijkstra_t){
-        .distance = UINT32_MAX,
-        .self     = self_node,
-        .prev     = NULL
-    };
-    return node;
+    graph_view_t view;
+    graph_view_of_graph(graph, &view);
+    return graph_view_topological_sort(&view);
 }
 
-static void free_dijkstra_node(void * node)
+void graph_free_path(path_t * path)
 {
-    free(node);
+    dlist_destroy(path->path);
+    free(path);
 }
 
 /*!
- * @brief Create an edge object
+ * @brief Create an edge object from the edge pool of the graph
+ * @param graph Pointer to the graph object
+ * @param from_node Pointer to the gnode_t object that the edge starts from
  * @param to_node Pointer to the gnode_t object that the edge leads to
  * @param weight Weight of the edge
  * @return Pointer to a edge object or NULL if invalid with a error message to
  * stderr.
  */
-static edge_t * create_edge(gnode_t * from_node,
+static edge_t * create_edge(graph_t * graph,
+                            gnode_t * from_node,
                             gnode_t * to_node,
                             uint32_t weight)
 {
-    edge_t * edge = (edge_t *)malloc(sizeof(edge_t));
-    if (UV_INVALID_ALLOC == verify_alloc(edge))
+    graph_edge_t * edge = (graph_edge_t *)graph_pool_alloc(&graph->edge_pool);
+    if (NULL == edge)
     {
         return NULL;
     }
 
-    * edge = (edge_t){
-        .from_node  = from_node,
-        .to_node    = to_node,
-        .weight     = weight
+    * edge = (graph_edge_t){
+        .edge       = {
+            .weight     = weight,
+            .from_node  = from_node,
+            .to_node    = to_node
+        },
+        .out_link   = NULL,
+        .in_link    = NULL,
+        .mirror     = NULL
     };
-    return edge;
+    return &edge->edge;
 }
 
 static void free_edges(dlist_t * edge)
@@ -875,7 +1047,69 @@ static void free_edges(dlist_t * edge)
 
 static void free_edge_dnode(void * node)
 {
-    free(node);
+    edge_t * edge = (edge_t *)node;
+    graph_pool_release(&edge->from_node->graph->edge_pool, edge);
+}
+
+/*!
+ * @brief Fill in a node that is not part of a graph yet
+ * @param node Memory of the node
+ * @param data Pointer to the data being stored in the graph
+ * @return False if the edge list could not be allocated
+ */
+static bool init_node(gnode_t * node, void * data)
+{
+    dlist_t * dlist = dlist_init(compare_nodes);
+    if (NULL == dlist)
+    {
+        return false;
+    }
+
+    * node = (gnode_t){
+        .data       = data,
+        .edges      = dlist,
+        .id         = GRAPH_NO_ID,
+        .graph      = NULL,
+        .edge_index = NULL,
+        .in_edges   = NULL,
+        .pool       = NULL
+    };
+    return true;
+}
+
+/*!
+ * @brief Create a node from the node pool of the graph. The node is not added
+ * to the graph, but when it is destroyed it goes back to the pool
+ * @param graph Pointer to the graph object owning the pool
+ * @param data Pointer to the data being stored in the graph
+ * @return Pointer to the node object or NULL if an allocation failed
+ */
+static gnode_t * create_pooled_node(graph_t * graph, void * data)
+{
+    gnode_t * node = (gnode_t *)graph_pool_alloc(&graph->node_pool);
+    if (NULL == node)
+    {
+        return NULL;
+    }
+
+    if (!init_node(node, data))
+    {
+        graph_pool_release(&graph->node_pool, node);
+        return NULL;
+    }
+    node->pool = &graph->node_pool;
+    return node;
+}
+
+// dlist allocator over the dnode pool of a graph
+static dnode_t * alloc_link(void * pool)
+{
+    return (dnode_t *)graph_pool_alloc((graph_pool_t *)pool);
+}
+
+static void free_link(void * pool, dnode_t * link)
+{
+    graph_pool_release((graph_pool_t *)pool, link);
 }
 
 static dlist_match_t compare_nodes(void * left, void * right)
@@ -887,6 +1121,362 @@ static dlist_match_t compare_nodes(void * left, void * right)
     return DLIST_MISS_MATCH;
 }
 
+/*!
+ * @brief Return the node stored in the graph for the node passed in. A node
+ * that belongs to the graph is recognized through its id. Any other node is
+ * matched by value which gives the node of the graph holding the same value.
+ *
+ * @param graph Pointer to the graph object
+ * @param node Pointer to the node object
+ * @return Node stored in the graph or NULL if the value is not in the graph
+ */
+static gnode_t * get_stored_node(graph_t * graph, gnode_t * node)
+{
+    if ((node->graph == graph) && (graph->nodes[node->id] == node))
+    {
+        return node;
+    }
+    return graph_get_node_by_value(graph, node->data);
+}
+
+/*!
+ * @brief Double the node array when it is full
+ * @param graph Pointer to the graph object
+ * @return False if the array could not grow
+ */
+static bool ensure_node_space(graph_t * graph)
+{
+    if (graph->node_count < graph->node_size)
+    {
+        return true;
+    }
+
+    gnode_t ** nodes = (gnode_t **)realloc(graph->nodes,
+                                           sizeof(gnode_t *) * graph->node_size * 2);
+    if (UV_INVALID_ALLOC == verify_alloc(nodes))
+    {
+        return false;
+    }
+    graph->nodes = nodes;
+    graph->node_size *= 2;
+    return true;
+}
+
+/*!
+ * @brief Compare callback of the node index. The right node is the one stored
+ * in the index and carries the graph whose compare_callback matches the values.
+ * @param left gnode_t being searched for
+ * @param right gnode_t stored in the index
+ * @return HT_MATCH_TRUE if both nodes hold the same value
+ */
+static htable_match_t compare_index_nodes(void * left, void * right)
+{
+    gnode_t * node_left = (gnode_t *)left;
+    gnode_t * node_right = (gnode_t *)right;
+    if (DLIST_MATCH == node_right->graph->compare_callback(node_left->data,
+                                                           node_right->data))
+    {
+        return HT_MATCH_TRUE;
+    }
+    return HT_MATCH_FALSE;
+}
+
+/*!
+ * @brief Find the edge from the source node to the target node. Nodes with a
+ * high degree keep an index of their edges keyed by the target node which
+ * makes the lookup O(1), every other node walks its edge list.
+ * @param source_node Pointer to the gnode_t the edge starts from
+ * @param target_node Pointer to the gnode_t the edge leads to
+ * @return Pointer to the edge or NULL if there is no such edge
+ */
+static edge_t * find_edge(gnode_t * source_node, gnode_t * target_node)
+{
+    if (NULL != source_node->edge_index)
+    {
+        return (edge_t *)htable_get(source_node->edge_index, target_node);
+    }
 
+    dnode_t * link = dlist_get_head_node(source_node->edges);
+    while (NULL != link)
+    {
+        edge_t * edge = (edge_t *)link->data;
+        if (edge->to_node == target_node)
+        {
+            return edge;
+        }
+        link = link->next;
+    }
+    return NULL;
+}
 
+/*!
+ * @brief Create the edge and append it to the edges of the source node. The
+ * edge index of the source node is built once it reaches
+ * GRAPH_EDGE_INDEX_DEGREE edges. In GRAPH_UNDIRECTED mode the edge is also
+ * added to the in_edges of the target node.
+ * @param graph Pointer to the graph object
+ * @param source_node Pointer to the gnode_t the edge starts from
+ * @param target_node Pointer to the gnode_t the edge leads to
+ * @param weight Weight of the edge
+ * @return Pointer to the new edge or NULL if it could not be allocated
+ */
+static edge_t * link_edge(graph_t * graph,
+                          gnode_t * source_node,
+                          gnode_t * target_node,
+                          uint32_t weight)
+{
+    if ((GRAPH_UNDIRECTED == graph->graph_mode) && (NULL == target_node->in_edges))
+    {
+        target_node->in_edges = dlist_init(compare_nodes);
+        if (NULL == target_node->in_edges)
+        {
+            return NULL;
+        }
+        dlist_set_allocator(target_node->in_edges, &graph->link_allocator);
+    }
 
+    edge_t * edge = create_edge(graph, source_node, target_node, weight);
+    if (NULL == edge)
+    {
+        return NULL;
+    }
+
+    // Keep the dnodes of the edge so that it can be unlinked without a search.
+    // The dnodes come from the link pool, so either append can fail
+    graph_edge_t * storage = (graph_edge_t *)edge;
+    storage->out_link = dlist_append_node(source_node->edges, edge);
+    if (NULL == storage->out_link)
+    {
+        graph_pool_release(&graph->edge_pool, edge);
+        return NULL;
+    }
+    if (GRAPH_UNDIRECTED == graph->graph_mode)
+    {
+        storage->in_link = dlist_append_node(target_node->in_edges, edge);
+        if (NULL == storage->in_link)
+        {
+            dlist_remove_node(source_node->edges, storage->out_link);
+            graph_pool_release(&graph->edge_pool, edge);
+            return NULL;
+        }
+    }
+    graph->edge_count++;
+    if (NULL != source_node->edge_index)
+    {
+        // Drop an index that could not take the edge and walk the list instead
+        size_t indexed = htable_get_length(source_node->edge_index);
+        htable_set(source_node->edge_index, target_node, edge);
+        if (htable_get_length(source_node->edge_index) == indexed)
+        {
+            htable_destroy(source_node->edge_index, HT_FREE_PTR_FALSE, HT_FREE_PTR_FALSE);
+            source_node->edge_index = NULL;
+        }
+    }
+    else if (dlist_get_length(source_node->edges) >= GRAPH_EDGE_INDEX_DEGREE)
+    {
+        build_edge_index(source_node);
+    }
+    return edge;
+}
+
+/*!
+ * @brief Remove the edge from the edges of the source node and free it. The
+ * dnodes kept in the edge storage are unlinked directly.
+ * @param graph Pointer to the graph object
+ * @param source_node Pointer to the gnode_t the edge starts from
+ * @param edge Pointer to the edge to remove
+ */
+static void unlink_edge(graph_t * graph, gnode_t * source_node, edge_t * edge)
+{
+    if (NULL != source_node->edge_index)
+    {
+        htable_del(source_node->edge_index, edge->to_node, HT_FREE_PTR_FALSE);
+    }
+    graph_edge_t * storage = (graph_edge_t *)edge;
+    if (NULL != storage->in_link)
+    {
+        dlist_remove_node(edge->to_node->in_edges, storage->in_link);
+    }
+    if (NULL != storage->mirror)
+    {
+        storage->mirror->mirror = NULL;
+    }
+    dlist_remove_node(source_node->edges, storage->out_link);
+    free_edge_dnode(edge);
+    graph->edge_count--;
+}
+
+/*!
+ * @brief Index the edges of the node by their target node. If the index can
+ * not be created or can not hold every edge the node keeps walking its edge
+ * list.
+ * @param node Pointer to the gnode_t to index
+ */
+static void build_edge_index(gnode_t * node)
+{
+    htable_t * edge_index = htable_create(hash_edge_target,
+                                          compare_edge_targets,
+                                          NULL,
+                                          NULL);
+    if (NULL == edge_index)
+    {
+        return;
+    }
+
+    dnode_t * link = dlist_get_head_node(node->edges);
+    while (NULL != link)
+    {
+        edge_t * edge = (edge_t *)link->data;
+        htable_set(edge_index, edge->to_node, edge);
+        link = link->next;
+    }
+
+    // htable_set returns NULL for new keys, so a failed insert is only
+    // visible through the length of the index. An index missing an edge
+    // would hide it from find_edge, so the list is walked instead
+    if (htable_get_length(edge_index) != dlist_get_length(node->edges))
+    {
+        htable_destroy(edge_index, HT_FREE_PTR_FALSE, HT_FREE_PTR_FALSE);
+        return;
+    }
+    node->edge_index = edge_index;
+}
+
+/*!
+ * @brief Link two edges of a GRAPH_DIRECTED graph as mirrors of each other
+ * @param edge Pointer to the edge
+ * @param mirror Pointer to the edge going the other way
+ */
+static void pair_edges(edge_t * edge, edge_t * mirror)
+{
+    ((graph_edge_t *)edge)->mirror = (graph_edge_t *)mirror;
+    ((graph_edge_t *)mirror)->mirror = (graph_edge_t *)edge;
+}
+
+/*!
+ * @brief Fetch the id of the node holding the value, adding a node for the
+ * value if the graph does not have one yet
+ * @param graph Pointer to the graph object
+ * @param value Value of the node
+ * @return Id of the node or GRAPH_NO_ID if the node could not be added
+ */
+static size_t resolve_node(graph_t * graph, void * value)
+{
+    gnode_t * node = graph_get_node_by_value(graph, value);
+    if (NULL != node)
+    {
+        return node->id;
+    }
+
+    node = create_pooled_node(graph, value);
+    if (NULL == node)
+    {
+        return GRAPH_NO_ID;
+    }
+    if (GRAPH_SUCCESS != graph_add_node(graph, node))
+    {
+        graph_destroy_node(node, NULL);
+        return GRAPH_NO_ID;
+    }
+    return node->id;
+}
+
+/*!
+ * @brief Link the edges of a bulk load. The edges are placed in buckets by
+ * their source id with a stable counting sort. Within a bucket a target that
+ * was already linked is marked with the source id, so every duplicate is
+ * found in O(1) and the first edge of the list wins.
+ *
+ * @param graph Pointer to a graph without edges
+ * @param edges Edges with resolved ids
+ * @param edge_count Number of edges
+ * @return False if an allocation failed
+ */
+static bool link_bulk_edges(graph_t * graph,
+                            const build_edge_t * edges,
+                            size_t edge_count)
+{
+    size_t node_count = graph->node_count;
+    size_t * buckets = (size_t *)calloc(node_count + 1, sizeof(size_t));
+    size_t * order = (size_t *)malloc(sizeof(size_t) * (edge_count + 1));
+    size_t * linked_from = (size_t *)malloc(sizeof(size_t) * (node_count + 1));
+    if ((NULL == buckets) || (NULL == order) || (NULL == linked_from))
+    {
+        debug_print_err("%s\n", "Unable to allocate the bulk load buckets");
+        free(buckets);
+        free(order);
+        free(linked_from);
+        return false;
+    }
+
+    // Counting sort by source, the edges of id end up in
+    // order[buckets[id]] to order[buckets[id + 1]] in the order of the list
+    for (size_t index = 0; index < edge_count; index++)
+    {
+        buckets[edges[index].source + 1]++;
+    }
+    for (size_t id = 0; id < node_count; id++)
+    {
+        buckets[id + 1] += buckets[id];
+        linked_from[id] = buckets[id];
+    }
+    for (size_t index = 0; index < edge_count; index++)
+    {
+        order[linked_from[edges[index].source]++] = index;
+    }
+    for (size_t id = 0; id < node_count; id++)
+    {
+        linked_from[id] = GRAPH_NO_ID;
+    }
+
+    bool linked = true;
+    for (size_t source = 0; (source < node_count) && linked; source++)
+    {
+        for (size_t slot = buckets[source]; (slot < buckets[source + 1]) && linked; slot++)
+        {
+            const build_edge_t * entry = &edges[order[slot]];
+            if (source == linked_from[entry->target])
+            {
+                continue;
+            }
+            linked_from[entry->target] = source;
+
+            gnode_t * source_node = graph->nodes[source];
+            gnode_t * target_node = graph->nodes[entry->target];
+            edge_t * edge = link_edge(graph, source_node, target_node, entry->weight);
+            linked = (NULL != edge);
+            if (linked && (GRAPH_DIRECTED == graph->graph_mode) && (source != entry->target))
+            {
+                edge_t * mirror = link_edge(graph, target_node, source_node, entry->weight);
+                linked = (NULL != mirror);
+                if (linked)
+                {
+                    pair_edges(edge, mirror);
+                }
+            }
+        }
+    }
+
+    free(buckets);
+    free(order);
+    free(linked_from);
+    return linked;
+}
+
+// The edge index is keyed by the address of the target gnode_t which does
+// not change for as long as the node is in the graph
+static uint64_t hash_edge_target(void * key)
+{
+    uint64_t hash = htable_get_init_hash();
+    htable_hash_key(&hash, &key, sizeof(void *));
+    return hash;
+}
+
+static htable_match_t compare_edge_targets(void * left, void * right)
+{
+    if (left == right)
+    {
+        return HT_MATCH_TRUE;
+    }
+    return HT_MATCH_FALSE;
+}
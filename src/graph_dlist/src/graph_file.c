@@ -0,0 +1,333 @@
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <graph_csr.h>
+#include <utils.h>
+
+#include "graph_internal.h"
+
+#define GRAPH_FILE_MAGIC "GRAPHCSR"
+
+typedef enum
+{
+    GRAPH_FILE_VERSION = 1,
+    GRAPH_FILE_BYTE_ORDER = 0x01020304,     // Written as a native uint32_t
+    GRAPH_FILE_ALIGNMENT = 8,               // Alignment of every section
+} graph_file_settings_t;
+
+/*
+ * The file starts with the header followed by the sections below, each
+ * starting on a multiple of GRAPH_FILE_ALIGNMENT:
+ *
+ *  values:  node_count records of value_size bytes, one per node id
+ *  offsets: node_count + 1 uint64_t
+ *  targets: edge_count uint32_t
+ *  weights: edge_count uint32_t
+ *
+ * The numbers are stored in the byte order of the machine that wrote the
+ * file. A file is only mapped by a machine with the same byte order.
+ */
+typedef struct graph_file_header_t
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t graph_mode;
+    uint32_t value_size;
+    uint64_t node_count;
+    uint64_t edge_count;
+} graph_file_header_t;
+
+// Offset of every section of a file
+typedef struct graph_file_layout_t
+{
+    size_t values;
+    size_t offsets;
+    size_t targets;
+    size_t weights;
+    size_t file_size;
+} graph_file_layout_t;
+
+static graph_file_layout_t get_layout(const graph_file_header_t * header);
+static size_t align_section(size_t offset);
+static bool write_section(FILE * file, const void * data, size_t size, size_t end);
+static bool validate_edges(const graph_csr_t * csr);
+
+/*!
+ * @brief Write the snapshot to a binary file that graph_csr_map can load
+ * without parsing. The value of every node is written as a fixed size record
+ * by the write_value callback, the edges are written as the CSR arrays of the
+ * snapshot.
+ *
+ * @param csr Pointer to the snapshot object
+ * @param file_path Path of the file to create or truncate
+ * @param value_size Size in bytes of the record of a node value
+ * @param write_value Callback that writes the value of a node into a record of
+ * value_size bytes
+ * @return False if the file could not be written
+ */
+bool graph_csr_write(graph_csr_t * csr,
+                     const char * file_path,
+                     size_t value_size,
+                     void (* write_value)(void * data, void * record))
+{
+    assert(csr);
+    assert(file_path);
+    assert(write_value);
+    assert((0 < value_size) && (value_size <= UINT32_MAX));
+
+    graph_file_header_t header = {
+        .version    = GRAPH_FILE_VERSION,
+        .byte_order = GRAPH_FILE_BYTE_ORDER,
+        .graph_mode = (uint32_t)csr->graph_mode,
+        .value_size = (uint32_t)value_size,
+        .node_count = csr->node_count,
+        .edge_count = csr->edge_count
+    };
+    memcpy(header.magic, GRAPH_FILE_MAGIC, sizeof(header.magic));
+    graph_file_layout_t layout = get_layout(&header);
+
+    // The records are built in one buffer so that the values are written
+    // with a single call
+    size_t values_size = csr->node_count * value_size;
+    unsigned char * records = (unsigned char *)calloc(values_size + 1, 1);
+    if (UV_INVALID_ALLOC == verify_alloc(records))
+    {
+        return false;
+    }
+    for (size_t id = 0; id < csr->node_count; id++)
+    {
+        write_value(csr->nodes[id]->data, records + (id * value_size));
+    }
+
+    FILE * file = fopen(file_path, "wb");
+    if (NULL == file)
+    {
+        debug_print_err("Unable to open %s\n", file_path);
+        free(records);
+        return false;
+    }
+
+    bool written = write_section(file, &header, sizeof(header), layout.values)
+        && write_section(file, records, values_size, layout.offsets)
+        && write_section(file, csr->offsets,
+                         sizeof(uint64_t) * (csr->node_count + 1), layout.targets)
+        && write_section(file, csr->targets,
+                         sizeof(uint32_t) * csr->edge_count, layout.weights)
+        && write_section(file, csr->weights,
+                         sizeof(uint32_t) * csr->edge_count, layout.file_size);
+    free(records);
+
+    if ((0 != fclose(file)) || !written)
+    {
+        debug_print_err("Unable to write %s\n", file_path);
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * @brief Map a file written by graph_csr_write into a read only snapshot. The
+ * edge arrays and the node values are used in place from the mapping, only a
+ * gnode_t per node is allocated, so loading costs O(V) and the pages of the
+ * file are read on first use.
+ *
+ * The gnode_t objects of a mapped snapshot have no edge list, they are only
+ * meant for the graph_csr_* functions and graph_get_node_value. The data of a
+ * node points into the mapping and is only valid until the snapshot is
+ * destroyed.
+ *
+ * The offsets are checked to only grow and every target to be a node id, in
+ * one O(V + E) pass, so a corrupted file is rejected instead of making the
+ * queries read outside of the mapping. The values and weights are not
+ * checked.
+ *
+ * @param file_path Path of the file to map
+ * @param compare_callback Function pointer for making comparisons between the
+ * node values stored in the file
+ * @return Pointer to the snapshot or NULL if the file is not a valid graph file
+ */
+graph_csr_t * graph_csr_map(const char * file_path,
+                            dlist_match_t (* compare_callback)(void *, void *))
+{
+    assert(file_path);
+    assert(compare_callback);
+
+    int file = open(file_path, O_RDONLY);
+    if (-1 == file)
+    {
+        debug_print_err("Unable to open %s\n", file_path);
+        return NULL;
+    }
+
+    struct stat file_stat;
+    graph_file_header_t header;
+    if ((0 != fstat(file, &file_stat))
+        || ((size_t)file_stat.st_size < sizeof(header))
+        || (sizeof(header) != (size_t)read(file, &header, sizeof(header))))
+    {
+        debug_print_err("Unable to read the header of %s\n", file_path);
+        close(file);
+        return NULL;
+    }
+
+    graph_file_layout_t layout = get_layout(&header);
+    if ((0 != memcmp(header.magic, GRAPH_FILE_MAGIC, sizeof(header.magic)))
+        || (GRAPH_FILE_VERSION != header.version)
+        || (GRAPH_FILE_BYTE_ORDER != header.byte_order)
+        || ((GRAPH_DIRECTED != header.graph_mode) && (GRAPH_UNDIRECTED != header.graph_mode))
+        || (header.node_count >= UINT32_MAX)
+        || (header.node_count * header.value_size > (uint64_t)file_stat.st_size)
+        || (header.edge_count > (uint64_t)file_stat.st_size)
+        || (layout.file_size != (size_t)file_stat.st_size))
+    {
+        debug_print_err("%s is not a graph file\n", file_path);
+        close(file);
+        return NULL;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    void * mapping = mmap(NULL, layout.file_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (MAP_FAILED == mapping)
+    {
+        debug_print_err("Unable to map %s\n", file_path);
+        return NULL;
+    }
+
+    graph_csr_t * csr = (graph_csr_t *)calloc(1, sizeof(graph_csr_t));
+    if (UV_INVALID_ALLOC == verify_alloc(csr))
+    {
+        munmap(mapping, layout.file_size);
+        return NULL;
+    }
+
+    size_t node_count = (size_t)header.node_count;
+    unsigned char * base = (unsigned char *)mapping;
+    * csr = (graph_csr_t){
+        .node_count         = node_count,
+        .edge_count         = (size_t)header.edge_count,
+        .offsets            = (uint64_t *)(base + layout.offsets),
+        .targets            = (uint32_t *)(base + layout.targets),
+        .weights            = (uint32_t *)(base + layout.weights),
+        .nodes              = (gnode_t **)calloc(node_count + 1, sizeof(gnode_t *)),
+        .graph_mode         = (graph_mode_t)header.graph_mode,
+        .compare_callback   = compare_callback,
+        .mapping            = mapping,
+        .mapping_size       = layout.file_size,
+        .node_storage       = (gnode_t *)calloc(node_count + 1, sizeof(gnode_t))
+    };
+    if ((NULL == csr->nodes) || (NULL == csr->node_storage) || !validate_edges(csr))
+    {
+        debug_print_err("Unable to load %s\n", file_path);
+        graph_csr_destroy(csr);
+        return NULL;
+    }
+
+    for (size_t id = 0; id < node_count; id++)
+    {
+        csr->node_storage[id] = (gnode_t){
+            .data       = base + layout.values + (id * header.value_size),
+            .edges      = NULL,
+            .id         = id,
+            .graph      = NULL,
+            .edge_index = NULL,
+            .in_edges   = NULL
+        };
+        csr->nodes[id] = &csr->node_storage[id];
+    }
+    return csr;
+}
+
+/*!
+ * @brief Release the mapping and the nodes of a mapped snapshot
+ * @param csr Pointer to a snapshot created by graph_csr_map
+ */
+void graph_csr_unmap(graph_csr_t * csr)
+{
+    munmap(csr->mapping, csr->mapping_size);
+    free(csr->node_storage);
+    free(csr->nodes);
+    free(csr);
+}
+
+static graph_file_layout_t get_layout(const graph_file_header_t * header)
+{
+    graph_file_layout_t layout;
+    layout.values = align_section(sizeof(graph_file_header_t));
+    layout.offsets = align_section(layout.values
+                                   + (size_t)(header->node_count * header->value_size));
+    layout.targets = align_section(layout.offsets
+                                   + (sizeof(uint64_t) * (size_t)(header->node_count + 1)));
+    layout.weights = align_section(layout.targets
+                                   + (sizeof(uint32_t) * (size_t)header->edge_count));
+    layout.file_size = layout.weights + (sizeof(uint32_t) * (size_t)header->edge_count);
+    return layout;
+}
+
+/*!
+ * @brief Check that the edge arrays of a mapped snapshot stay within bounds.
+ * The offsets must start at 0, never shrink and end at the edge count, and
+ * every target must be a node id
+ * @param csr Snapshot whose arrays point into the mapping
+ * @return False if the arrays are corrupted
+ */
+static bool validate_edges(const graph_csr_t * csr)
+{
+    if ((0 != csr->offsets[0]) || (csr->edge_count != csr->offsets[csr->node_count]))
+    {
+        return false;
+    }
+    for (size_t id = 0; id < csr->node_count; id++)
+    {
+        if (csr->offsets[id] > csr->offsets[id + 1])
+        {
+            return false;
+        }
+    }
+    for (size_t index = 0; index < csr->edge_count; index++)
+    {
+        if (csr->targets[index] >= csr->node_count)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static size_t align_section(size_t offset)
+{
+    return (offset + GRAPH_FILE_ALIGNMENT - 1) & ~((size_t)GRAPH_FILE_ALIGNMENT - 1);
+}
+
+/*!
+ * @brief Write a section and pad the file with zeros up to the end offset
+ * @param file File being written
+ * @param data Section to write
+ * @param size Size of the section
+ * @param end Offset the file must reach after the section
+ * @return False if the write failed
+ */
+static bool write_section(FILE * file, const void * data, size_t size, size_t end)
+{
+    if ((0 != size) && (1 != fwrite(data, size, 1, file)))
+    {
+        return false;
+    }
+
+    long position = ftell(file);
+    if (position < 0)
+    {
+        return false;
+    }
+
+    static const unsigned char padding[GRAPH_FILE_ALIGNMENT] = {0};
+    size_t pad = end - (size_t)position;
+    return (0 == pad) || (1 == fwrite(padding, pad, 1, file));
+}
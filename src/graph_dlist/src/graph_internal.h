@@ -0,0 +1,235 @@
+#ifndef DATA_STRUCTURES_C_SRC_GRAPH_DLIST_SRC_GRAPH_INTERNAL_H_
+#define DATA_STRUCTURES_C_SRC_GRAPH_DLIST_SRC_GRAPH_INTERNAL_H_
+
+/*
+ * Structures shared by the translation units of the graph module. Nothing in
+ * here is part of the public API.
+ */
+#include <graph_dlist.h>
+#include <graph_csr.h>
+#include <hashtable.h>
+#include <heap_indexed.h>
+
+// Fixed size blocks carved from chunks that are all freed together
+typedef struct graph_pool_t
+{
+    size_t block_size;
+    size_t chunk_blocks;            // Blocks of the next chunk
+    uint8_t * cursor;               // Next block of the current chunk
+    uint8_t * chunk_end;
+    void * chunks;                  // Every chunk, linked through their header
+    void * free_list;               // Released blocks, linked through their first bytes
+    size_t reserved;                // Blocks to carve before the free list is used again
+} graph_pool_t;
+
+typedef struct graph_t
+{
+    gnode_t ** nodes;               // Dense array, a node is at nodes[node->id]
+    size_t node_count;              // Number of nodes in the array
+    size_t node_size;               // Physical size of the array
+    size_t edge_count;              // Number of edge_t stored across all nodes
+    htable_t * node_index;          // gnode_t -> gnode_t matched by value
+    graph_mode_t graph_mode;
+    dlist_match_t (* compare_callback)(void *, void *);
+    uint64_t (* hash_callback)(void *);
+    graph_pool_t node_pool;         // gnode_t of the nodes added by value
+    graph_pool_t edge_pool;         // Storage of every edge_t
+    graph_pool_t link_pool;         // dnode_t of the edge lists
+    dlist_allocator_t link_allocator;
+} graph_t;
+
+typedef struct gnode_t
+{
+    void * data;
+    dlist_t * edges;
+    size_t id;                      // Index in graph->nodes or GRAPH_NO_ID
+    graph_t * graph;                // Graph holding the node or NULL
+    htable_t * edge_index;          // to_node -> edge_t, NULL for low degrees
+    dlist_t * in_edges;             // Edges leading to the node, GRAPH_UNDIRECTED only
+    graph_pool_t * pool;            // Pool the node was carved from or NULL
+} gnode_t;
+
+typedef struct graph_csr_t
+{
+    size_t node_count;
+    size_t edge_count;
+    uint64_t * offsets;             // Edges of node i are [offsets[i], offsets[i + 1])
+    uint32_t * targets;             // Target id of every edge, sorted per node
+    uint32_t * weights;             // Weight of every edge
+    gnode_t ** nodes;               // Id to the gnode_t of the frozen graph
+    graph_mode_t graph_mode;
+    dlist_match_t (* compare_callback)(void *, void *);
+    void * mapping;                 // File the arrays live in or NULL
+    size_t mapping_size;
+    gnode_t * node_storage;         // Nodes of a mapped snapshot
+} graph_csr_t;
+
+/*
+ * A view lets the read only algorithms run on the linked graph_t and on the
+ * graph_csr_t snapshot with the same code. A view over a graph_t has no
+ * offsets and walks the edge dlists of the nodes instead. A reverse view over
+ * a graph_t walks the in_edges of the nodes, so every edge leads back to the
+ * node it starts from.
+ */
+typedef struct graph_view_t
+{
+    size_t node_count;
+    size_t edge_count;
+    gnode_t ** nodes;
+    const uint64_t * offsets;
+    const uint32_t * targets;
+    const uint32_t * weights;
+    bool reverse;                   // Walk the in_edges of a graph_t
+    dlist_match_t (* compare_callback)(void *, void *);
+} graph_view_t;
+
+// Position while walking the edges of one node of a view
+typedef struct graph_cursor_t
+{
+    dnode_t * link;                 // Next dnode of the edge dlist of a graph_t
+    uint64_t index;                 // Next edge of a graph_csr_t
+    uint64_t end;
+} graph_cursor_t;
+
+// Reusable state of a shortest path search. Only the ids written by a search
+// are reset before the next one, so one state serves many queries
+typedef struct graph_search_t
+{
+    size_t node_count;
+    uint64_t * distances;           // UINT64_MAX for ids that were not reached
+    size_t * prev;                  // Previous id on the path or GRAPH_NO_ID
+    bool * settled;
+    size_t * touched;               // Ids whose state was written
+    size_t touched_count;
+    heap_indexed_t * heap;
+} graph_search_t;
+
+void graph_pool_init(graph_pool_t * pool, size_t block_size);
+void graph_pool_destroy(graph_pool_t * pool);
+bool graph_pool_reserve(graph_pool_t * pool, size_t block_count);
+void * graph_pool_alloc(graph_pool_t * pool);
+void graph_pool_release(graph_pool_t * pool, void * block);
+
+graph_search_t * graph_search_init(size_t node_count);
+void graph_search_destroy(graph_search_t * search);
+void graph_search_reset(graph_search_t * search);
+bool graph_search_run(graph_search_t * search,
+                      const graph_view_t * view,
+                      size_t source,
+                      size_t target);
+bool graph_search_run_astar(graph_search_t * search,
+                            const graph_view_t * view,
+                            size_t source,
+                            size_t target,
+                            graph_heuristic_t heuristic,
+                            void * ctx);
+
+void graph_view_of_graph(graph_t * graph, graph_view_t * view);
+void graph_view_reverse_of_graph(graph_t * graph, graph_view_t * view);
+void graph_view_of_csr(graph_csr_t * csr, graph_view_t * view);
+void graph_csr_unmap(graph_csr_t * csr);
+size_t graph_view_get_node_id(const graph_view_t * view, gnode_t * node);
+graph_spt_t * graph_view_shortest_path_tree(const graph_view_t * view,
+                                            size_t source);
+path_t * graph_view_get_path(graph_view_t * view, size_t source, size_t target);
+path_t * graph_view_get_path_bidirectional(const graph_view_t * view,
+                                           const graph_view_t * reverse,
+                                           size_t source,
+                                           size_t target);
+path_t * graph_view_build_path(const graph_view_t * view,
+                               const size_t * prev,
+                               size_t target,
+                               uint64_t path_weight);
+graph_bfs_t * graph_view_bfs(const graph_view_t * view,
+                             const graph_view_t * reverse,
+                             size_t source,
+                             size_t thread_count);
+graph_components_t * graph_view_components(const graph_view_t * view, size_t thread_count);
+graph_components_t * graph_components_from_labels(const graph_view_t * view,
+                                                  size_t * labels,
+                                                  size_t count);
+graph_components_t * graph_view_strong_components(const graph_view_t * view);
+dlist_t * graph_view_topological_sort(const graph_view_t * view);
+
+/*!
+ * @brief Return the number of edges walked from the node in the view
+ * @param view View of the graph
+ * @param id Id of the node
+ * @return Number of edges
+ */
+static inline size_t graph_view_degree(const graph_view_t * view, size_t id)
+{
+    if (view->reverse)
+    {
+        dlist_t * in_edges = view->nodes[id]->in_edges;
+        return (NULL == in_edges) ? 0 : dlist_get_length(in_edges);
+    }
+    if (NULL == view->offsets)
+    {
+        return dlist_get_length(view->nodes[id]->edges);
+    }
+    return (size_t)(view->offsets[id + 1] - view->offsets[id]);
+}
+
+/*!
+ * @brief Position the cursor on the first edge of the node
+ * @param view View of the graph
+ * @param id Id of the node whose edges are walked
+ * @param cursor Cursor to initialize
+ */
+static inline void graph_view_first(const graph_view_t * view,
+                                    size_t id,
+                                    graph_cursor_t * cursor)
+{
+    if (view->reverse)
+    {
+        dlist_t * in_edges = view->nodes[id]->in_edges;
+        cursor->link = (NULL == in_edges) ? NULL : dlist_get_head_node(in_edges);
+        return;
+    }
+    if (NULL == view->offsets)
+    {
+        cursor->link = dlist_get_head_node(view->nodes[id]->edges);
+        return;
+    }
+    cursor->index = view->offsets[id];
+    cursor->end = view->offsets[id + 1];
+}
+
+/*!
+ * @brief Read the edge under the cursor and advance it
+ * @param view View of the graph
+ * @param cursor Cursor positioned with graph_view_first
+ * @param target Set to the id of the node the edge leads to
+ * @param weight Set to the weight of the edge
+ * @return False once every edge of the node was read
+ */
+static inline bool graph_view_next(const graph_view_t * view,
+                                   graph_cursor_t * cursor,
+                                   size_t * target,
+                                   uint32_t * weight)
+{
+    if (NULL == view->offsets)
+    {
+        if (NULL == cursor->link)
+        {
+            return false;
+        }
+        edge_t * edge = (edge_t *)cursor->link->data;
+        * target = view->reverse ? edge->from_node->id : edge->to_node->id;
+        * weight = edge->weight;
+        cursor->link = cursor->link->next;
+        return true;
+    }
+
+    if (cursor->index == cursor->end)
+    {
+        return false;
+    }
+    * target = view->targets[cursor->index];
+    * weight = view->weights[cursor->index];
+    cursor->index++;
+    return true;
+}
+
+#endif //DATA_STRUCTURES_C_SRC_GRAPH_DLIST_SRC_GRAPH_INTERNAL_H_
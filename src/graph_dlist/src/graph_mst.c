@@ -0,0 +1,311 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include <graph_dlist.h>
+#include <heap.h>
+#include <utils.h>
+
+#include "graph_internal.h"
+
+static graph_mst_t * create_mst(size_t edge_capacity);
+static heap_compare_t compare_edge_weight(void * left, void * right);
+static size_t find_root(size_t * parents, size_t id);
+static void relax_edge(heap_indexed_t * heap,
+                       edge_t ** best_edges,
+                       const bool * in_tree,
+                       edge_t * edge,
+                       gnode_t * neighbor);
+
+/*!
+ * @brief Find the minimum spanning forest of the graph with Kruskal's
+ * algorithm. The edges are sorted by weight with heap_sort_parallel and then
+ * added in order unless a union-find over the node ids shows that both ends
+ * are already connected.
+ *
+ * The edges are treated as undirected. In GRAPH_DIRECTED mode every edge has a
+ * mirror and only one of the two is considered, in GRAPH_UNDIRECTED mode both
+ * directions of a pair of one way edges are candidates. Self loops are never
+ * part of the forest.
+ *
+ * The forest points at the edge_t objects of the graph, so the graph must not
+ * be modified while the forest is in use.
+ *
+ * @param graph Pointer to the graph structure
+ * @param thread_count Number of threads used for the sort, 0 for one per
+ * online cpu
+ * @return Spanning forest or NULL if an allocation failed. The forest is freed
+ * with graph_free_mst
+ */
+graph_mst_t * graph_mst_kruskal(graph_t * graph, size_t thread_count)
+{
+    assert(graph);
+    size_t node_count = graph->node_count;
+
+    // The candidates are collected in the array of the forest and the chosen
+    // edges are compacted to its front, so no other edge storage is needed
+    graph_mst_t * mst = create_mst(graph->edge_count);
+    size_t * parents = (size_t *)malloc(sizeof(size_t) * (node_count + 1));
+    size_t * sizes = (size_t *)malloc(sizeof(size_t) * (node_count + 1));
+    if ((NULL == mst) || (NULL == parents) || (NULL == sizes))
+    {
+        debug_print_err("%s\n", "Unable to allocate the Kruskal state");
+        if (NULL != mst)
+        {
+            graph_free_mst(mst);
+        }
+        free(parents);
+        free(sizes);
+        return NULL;
+    }
+
+    size_t candidate_count = 0;
+    for (size_t id = 0; id < node_count; id++)
+    {
+        parents[id] = id;
+        sizes[id] = 1;
+
+        dnode_t * link = dlist_get_head_node(graph->nodes[id]->edges);
+        for (; NULL != link; link = link->next)
+        {
+            edge_t * edge = (edge_t *)link->data;
+            size_t target = edge->to_node->id;
+            if ((id == target)
+                || ((GRAPH_DIRECTED == graph->graph_mode) && (target < id)))
+            {
+                continue;
+            }
+            mst->edges[candidate_count++] = edge;
+        }
+    }
+
+    heap_sort_parallel(mst->edges,
+                       candidate_count,
+                       sizeof(edge_t *),
+                       HEAP_PTR,
+                       MIN_HEAP,
+                       compare_edge_weight,
+                       thread_count);
+
+    for (size_t index = 0; index < candidate_count; index++)
+    {
+        // A forest over n nodes can not hold more than n - 1 edges
+        if (mst->edge_count + 1 == node_count)
+        {
+            break;
+        }
+
+        edge_t * edge = mst->edges[index];
+        size_t source = find_root(parents, edge->from_node->id);
+        size_t target = find_root(parents, edge->to_node->id);
+        if (source == target)
+        {
+            continue;
+        }
+
+        // Union by size keeps the trees shallow
+        if (sizes[source] < sizes[target])
+        {
+            size_t swap = source;
+            source = target;
+            target = swap;
+        }
+        parents[target] = source;
+        sizes[source] += sizes[target];
+
+        mst->edges[mst->edge_count++] = edge;
+        mst->total_weight += edge->weight;
+    }
+
+    free(parents);
+    free(sizes);
+    return mst;
+}
+
+/*!
+ * @brief Find the minimum spanning forest of the graph with Prim's algorithm.
+ * Every tree is grown from the smallest id that is not yet in the forest and
+ * the nodes bordering the tree are kept in an indexed heap keyed by the
+ * lightest edge that reaches them, which is lowered with a decrease key.
+ *
+ * The edges are treated as undirected the same way as in graph_mst_kruskal.
+ * In GRAPH_UNDIRECTED mode the in_edges of every node are walked as well so
+ * that one way edges are reached from both ends.
+ *
+ * @param graph Pointer to the graph structure
+ * @return Spanning forest or NULL if an allocation failed. The forest is freed
+ * with graph_free_mst
+ */
+graph_mst_t * graph_mst_prim(graph_t * graph)
+{
+    assert(graph);
+    size_t node_count = graph->node_count;
+
+    graph_mst_t * mst = create_mst((0 == node_count) ? 0 : node_count - 1);
+    edge_t ** best_edges = (edge_t **)calloc(node_count + 1, sizeof(edge_t *));
+    bool * in_tree = (bool *)calloc(node_count + 1, sizeof(bool));
+    heap_indexed_t * heap = heap_indexed_init(node_count);
+    if ((NULL == mst) || (NULL == best_edges) || (NULL == in_tree) || (NULL == heap))
+    {
+        debug_print_err("%s\n", "Unable to allocate the Prim state");
+        if (NULL != mst)
+        {
+            graph_free_mst(mst);
+        }
+        if (NULL != heap)
+        {
+            heap_indexed_destroy(heap);
+        }
+        free(best_edges);
+        free(in_tree);
+        return NULL;
+    }
+
+    for (size_t root = 0; root < node_count; root++)
+    {
+        if (in_tree[root])
+        {
+            continue;
+        }
+
+        heap_indexed_push(heap, root, 0);
+        while (!heap_indexed_is_empty(heap))
+        {
+            size_t id = heap_indexed_pop(heap, NULL);
+            in_tree[id] = true;
+            if (NULL != best_edges[id])
+            {
+                mst->edges[mst->edge_count++] = best_edges[id];
+                mst->total_weight += best_edges[id]->weight;
+            }
+
+            gnode_t * node = graph->nodes[id];
+            dnode_t * link = dlist_get_head_node(node->edges);
+            for (; NULL != link; link = link->next)
+            {
+                edge_t * edge = (edge_t *)link->data;
+                relax_edge(heap, best_edges, in_tree, edge, edge->to_node);
+            }
+
+            if (NULL == node->in_edges)
+            {
+                continue;
+            }
+            link = dlist_get_head_node(node->in_edges);
+            for (; NULL != link; link = link->next)
+            {
+                edge_t * edge = (edge_t *)link->data;
+                relax_edge(heap, best_edges, in_tree, edge, edge->from_node);
+            }
+        }
+    }
+
+    heap_indexed_destroy(heap);
+    free(best_edges);
+    free(in_tree);
+    return mst;
+}
+
+/*!
+ * @brief Free the spanning forest. The edges belong to the graph and are left
+ * alone
+ * @param mst Spanning forest returned by graph_mst_kruskal or graph_mst_prim
+ */
+void graph_free_mst(graph_mst_t * mst)
+{
+    assert(mst);
+    free(mst->edges);
+    free(mst);
+}
+
+/*!
+ * @brief Allocate an empty forest with room for the given number of edges
+ * @param edge_capacity Number of edges the array must hold
+ * @return Empty forest or NULL if an allocation failed
+ */
+static graph_mst_t * create_mst(size_t edge_capacity)
+{
+    graph_mst_t * mst = (graph_mst_t *)calloc(1, sizeof(graph_mst_t));
+    if (NULL == mst)
+    {
+        return NULL;
+    }
+
+    mst->edges = (edge_t **)malloc(sizeof(edge_t *) * (edge_capacity + 1));
+    if (NULL == mst->edges)
+    {
+        free(mst);
+        return NULL;
+    }
+    return mst;
+}
+
+/*!
+ * @brief Compare two edge_t by weight for heap_sort_parallel
+ * @param left Pointer to an edge_t
+ * @param right Pointer to an edge_t
+ * @return HEAP_LT, HEAP_EQ or HEAP_GT
+ */
+static heap_compare_t compare_edge_weight(void * left, void * right)
+{
+    uint32_t left_weight = ((edge_t *)left)->weight;
+    uint32_t right_weight = ((edge_t *)right)->weight;
+    if (left_weight < right_weight)
+    {
+        return HEAP_LT;
+    }
+    if (left_weight > right_weight)
+    {
+        return HEAP_GT;
+    }
+    return HEAP_EQ;
+}
+
+/*!
+ * @brief Return the root of the set holding the id. Every visited id is
+ * pointed at its grandparent which halves the path for the next search
+ * @param parents Parent of every id, roots point at themselves
+ * @param id Id to look up
+ * @return Root of the set
+ */
+static size_t find_root(size_t * parents, size_t id)
+{
+    while (parents[id] != id)
+    {
+        parents[id] = parents[parents[id]];
+        id = parents[id];
+    }
+    return id;
+}
+
+/*!
+ * @brief Offer the edge as the lightest connection of the neighbor to the tree
+ * @param heap Heap of the nodes bordering the tree
+ * @param best_edges Lightest edge found so far for every id
+ * @param in_tree Marks the ids already in the forest
+ * @param edge Edge between a node of the tree and the neighbor
+ * @param neighbor End of the edge that is not the node of the tree
+ */
+static void relax_edge(heap_indexed_t * heap,
+                       edge_t ** best_edges,
+                       const bool * in_tree,
+                       edge_t * edge,
+                       gnode_t * neighbor)
+{
+    size_t id = neighbor->id;
+    if (in_tree[id])
+    {
+        return;
+    }
+
+    edge_t * best_edge = best_edges[id];
+    if (NULL == best_edge)
+    {
+        best_edges[id] = edge;
+        heap_indexed_push(heap, id, edge->weight);
+    }
+    else if (edge->weight < best_edge->weight)
+    {
+        best_edges[id] = edge;
+        heap_indexed_decrease_key(heap, id, edge->weight);
+    }
+}
@@ -0,0 +1,220 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include <graph_dlist.h>
+#include <utils.h>
+
+#include "graph_internal.h"
+
+// Node of the explicit call stack of the Tarjan search
+typedef struct tarjan_frame_t
+{
+    size_t id;
+    graph_cursor_t cursor;          // Next edge of the node to visit
+} tarjan_frame_t;
+
+static void push_frame(tarjan_frame_t * frames,
+                       size_t * depth,
+                       size_t * order,
+                       size_t * lowlink,
+                       size_t id,
+                       size_t * counter,
+                       const graph_view_t * view);
+
+/*!
+ * @brief Label the strongly connected components of the view with Tarjan's
+ * algorithm. The recursion is replaced by an explicit stack of frames that
+ * remember the next edge of every node, so the depth of the graph is only
+ * bounded by memory.
+ *
+ * Tarjan finds the components in reverse topological order of the graph of
+ * components. The labels are numbered the other way around so that every
+ * edge between two components goes from a smaller to a larger label.
+ *
+ * @param view View of the graph
+ * @return Component labels or NULL if an allocation failed
+ */
+graph_components_t * graph_view_strong_components(const graph_view_t * view)
+{
+    size_t node_count = view->node_count;
+    size_t * order = (size_t *)malloc(sizeof(size_t) * (node_count + 1));
+    size_t * lowlink = (size_t *)malloc(sizeof(size_t) * (node_count + 1));
+    size_t * labels = (size_t *)malloc(sizeof(size_t) * (node_count + 1));
+    size_t * stack = (size_t *)malloc(sizeof(size_t) * (node_count + 1));
+    tarjan_frame_t * frames = (tarjan_frame_t *)malloc(sizeof(tarjan_frame_t) * (node_count + 1));
+    if ((NULL == order) || (NULL == lowlink) || (NULL == labels)
+        || (NULL == stack) || (NULL == frames))
+    {
+        debug_print_err("%s\n", "Unable to allocate the Tarjan state");
+        free(order);
+        free(lowlink);
+        free(labels);
+        free(stack);
+        free(frames);
+        return NULL;
+    }
+
+    // A node is on the stack while it has an order and no label yet
+    for (size_t id = 0; id < node_count; id++)
+    {
+        order[id] = GRAPH_NO_ID;
+        labels[id] = GRAPH_NO_ID;
+    }
+
+    size_t counter = 0;
+    size_t count = 0;
+    size_t stack_length = 0;
+    for (size_t root = 0; root < node_count; root++)
+    {
+        if (GRAPH_NO_ID != order[root])
+        {
+            continue;
+        }
+
+        size_t depth = 0;
+        push_frame(frames, &depth, order, lowlink, root, &counter, view);
+        stack[stack_length++] = root;
+        while (0 != depth)
+        {
+            tarjan_frame_t * frame = &frames[depth - 1];
+            size_t neighbor;
+            uint32_t weight;
+            if (graph_view_next(view, &frame->cursor, &neighbor, &weight))
+            {
+                if (GRAPH_NO_ID == order[neighbor])
+                {
+                    push_frame(frames, &depth, order, lowlink, neighbor, &counter, view);
+                    stack[stack_length++] = neighbor;
+                }
+                else if ((GRAPH_NO_ID == labels[neighbor]) && (order[neighbor] < lowlink[frame->id]))
+                {
+                    lowlink[frame->id] = order[neighbor];
+                }
+                continue;
+            }
+
+            // Every edge of the node was visited
+            size_t id = frame->id;
+            depth--;
+            if (lowlink[id] == order[id])
+            {
+                size_t member;
+                do
+                {
+                    member = stack[--stack_length];
+                    labels[member] = count;
+                } while (member != id);
+                count++;
+            }
+            if ((0 != depth) && (lowlink[id] < lowlink[frames[depth - 1].id]))
+            {
+                lowlink[frames[depth - 1].id] = lowlink[id];
+            }
+        }
+    }
+
+    for (size_t id = 0; id < node_count; id++)
+    {
+        labels[id] = count - 1 - labels[id];
+    }
+
+    free(order);
+    free(lowlink);
+    free(stack);
+    free(frames);
+    return graph_components_from_labels(view, labels, count);
+}
+
+/*!
+ * @brief Sort the nodes of the view so that every edge goes from a node to a
+ * node after it, with Kahn's algorithm. Nodes without incoming edges are
+ * emitted in the order of their id.
+ *
+ * @param view View of the graph
+ * @return dlist of the gnode_t in topological order or NULL if the graph has a
+ * cycle or an allocation failed. The dlist is freed with dlist_destroy
+ */
+dlist_t * graph_view_topological_sort(const graph_view_t * view)
+{
+    size_t node_count = view->node_count;
+    size_t * in_degrees = (size_t *)calloc(node_count + 1, sizeof(size_t));
+    size_t * queue = (size_t *)malloc(sizeof(size_t) * (node_count + 1));
+    if ((NULL == in_degrees) || (NULL == queue))
+    {
+        debug_print_err("%s\n", "Unable to allocate the topological sort");
+        free(in_degrees);
+        free(queue);
+        return NULL;
+    }
+
+    graph_cursor_t cursor;
+    size_t neighbor;
+    uint32_t weight;
+    for (size_t id = 0; id < node_count; id++)
+    {
+        graph_view_first(view, id, &cursor);
+        while (graph_view_next(view, &cursor, &neighbor, &weight))
+        {
+            in_degrees[neighbor]++;
+        }
+    }
+
+    size_t queue_length = 0;
+    for (size_t id = 0; id < node_count; id++)
+    {
+        if (0 == in_degrees[id])
+        {
+            queue[queue_length++] = id;
+        }
+    }
+
+    for (size_t index = 0; index < queue_length; index++)
+    {
+        graph_view_first(view, queue[index], &cursor);
+        while (graph_view_next(view, &cursor, &neighbor, &weight))
+        {
+            in_degrees[neighbor]--;
+            if (0 == in_degrees[neighbor])
+            {
+                queue[queue_length++] = neighbor;
+            }
+        }
+    }
+    free(in_degrees);
+
+    // Nodes on a cycle never lose all their incoming edges
+    dlist_t * sorted = NULL;
+    if (queue_length == node_count)
+    {
+        sorted = dlist_init(view->compare_callback);
+    }
+    if (NULL != sorted)
+    {
+        for (size_t index = 0; index < queue_length; index++)
+        {
+            dlist_append(sorted, view->nodes[queue[index]]);
+        }
+    }
+
+    free(queue);
+    return sorted;
+}
+
+/*!
+ * @brief Give the node its order and start walking its edges
+ */
+static void push_frame(tarjan_frame_t * frames,
+                       size_t * depth,
+                       size_t * order,
+                       size_t * lowlink,
+                       size_t id,
+                       size_t * counter,
+                       const graph_view_t * view)
+{
+    order[id] = * counter;
+    lowlink[id] = * counter;
+    (* counter)++;
+    frames[* depth].id = id;
+    graph_view_first(view, id, &frames[* depth].cursor);
+    (* depth)++;
+}
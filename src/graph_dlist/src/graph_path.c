@@ -0,0 +1,650 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include <graph_dlist.h>
+#include <utils.h>
+
+#include "graph_internal.h"
+
+typedef struct graph_spt_t
+{
+    graph_view_t view;              // Owns a copy of the nodes of the view
+    size_t source;
+    uint64_t * distances;           // UINT64_MAX for unreachable nodes
+    size_t * prev;                  // Previous id on the path or GRAPH_NO_ID
+} graph_spt_t;
+
+static size_t get_spt_node_id(graph_spt_t * spt, gnode_t * node);
+
+/*!
+ * @brief Create a view over the linked graph for the shared algorithms
+ * @param graph Pointer to the graph object
+ * @param view View to initialize
+ */
+void graph_view_of_graph(graph_t * graph, graph_view_t * view)
+{
+    * view = (graph_view_t){
+        .node_count         = graph->node_count,
+        .edge_count         = graph->edge_count,
+        .nodes              = graph->nodes,
+        .offsets            = NULL,
+        .targets            = NULL,
+        .weights            = NULL,
+        .reverse            = false,
+        .compare_callback   = graph->compare_callback
+    };
+}
+
+/*!
+ * @brief Create a view that follows the edges of the graph backwards. In
+ * GRAPH_DIRECTED mode every edge has its mirror so the view is the same as
+ * the forward one.
+ * @param graph Pointer to the graph object
+ * @param view View to initialize
+ */
+void graph_view_reverse_of_graph(graph_t * graph, graph_view_t * view)
+{
+    graph_view_of_graph(graph, view);
+    view->reverse = (GRAPH_UNDIRECTED == graph->graph_mode);
+}
+
+/*!
+ * @brief Fetch the id of the node in the view. A node of the view is found in
+ * O(1), any other node is matched by value.
+ *
+ * @param view View of the graph
+ * @param node Pointer to the node to search for
+ * @return Id of the node or GRAPH_NO_ID if the node is not in the view
+ */
+size_t graph_view_get_node_id(const graph_view_t * view, gnode_t * node)
+{
+    if ((node->id < view->node_count) && (view->nodes[node->id] == node))
+    {
+        return node->id;
+    }
+
+    for (size_t id = 0; id < view->node_count; id++)
+    {
+        if (DLIST_MATCH == view->compare_callback(view->nodes[id]->data, node->data))
+        {
+            return id;
+        }
+    }
+    return GRAPH_NO_ID;
+}
+
+/*!
+ * @brief Allocate the state of a shortest path search for a graph with the
+ * given number of nodes
+ * @param node_count Number of nodes of the graphs the state is used on
+ * @return Pointer to the search state or NULL if an allocation failed
+ */
+graph_search_t * graph_search_init(size_t node_count)
+{
+    graph_search_t * search = (graph_search_t *)calloc(1, sizeof(graph_search_t));
+    if (UV_INVALID_ALLOC == verify_alloc(search))
+    {
+        return NULL;
+    }
+
+    // Allocate at least one item so that an empty graph still gets valid arrays
+    search->distances = (uint64_t *)malloc(sizeof(uint64_t) * (node_count + 1));
+    search->prev = (size_t *)malloc(sizeof(size_t) * (node_count + 1));
+    search->settled = (bool *)calloc(node_count + 1, sizeof(bool));
+    search->touched = (size_t *)malloc(sizeof(size_t) * (node_count + 1));
+    search->heap = heap_indexed_init(node_count);
+    if ((NULL == search->distances) || (NULL == search->prev)
+        || (NULL == search->settled) || (NULL == search->touched)
+        || (NULL == search->heap))
+    {
+        debug_print_err("%s\n", "Unable to allocate the search state");
+        graph_search_destroy(search);
+        return NULL;
+    }
+
+    for (size_t id = 0; id < node_count; id++)
+    {
+        search->distances[id] = UINT64_MAX;
+        search->prev[id] = GRAPH_NO_ID;
+    }
+    search->node_count = node_count;
+    return search;
+}
+
+/*!
+ * @brief Free the search state
+ * @param search Pointer to the search state
+ */
+void graph_search_destroy(graph_search_t * search)
+{
+    if (NULL != search->heap)
+    {
+        heap_indexed_destroy(search->heap);
+    }
+    free(search->distances);
+    free(search->prev);
+    free(search->settled);
+    free(search->touched);
+    free(search);
+}
+
+/*!
+ * @brief Reset the state written by the last search. Only the ids the search
+ * reached are visited, which keeps short queries on large graphs cheap.
+ * @param search Pointer to the search state
+ */
+void graph_search_reset(graph_search_t * search)
+{
+    for (size_t index = 0; index < search->touched_count; index++)
+    {
+        size_t id = search->touched[index];
+        search->distances[id] = UINT64_MAX;
+        search->prev[id] = GRAPH_NO_ID;
+        search->settled[id] = false;
+    }
+    search->touched_count = 0;
+    heap_indexed_clear(search->heap);
+}
+
+/*!
+ * @brief Perform the dijkstra algorithm from the source id of the view. The
+ * distance, previous id and settled flag of every node live in flat arrays
+ * indexed by id and the queue is an indexed heap, so a node is in the queue
+ * at most once and improving its distance lowers its key in place.
+ *
+ * The search stops as soon as the target is settled. With a target of
+ * GRAPH_NO_ID every node reachable from the source is settled.
+ *
+ * @param search Search state sized for the view, it is reset first
+ * @param view View of the graph
+ * @param source Id of the source node
+ * @param target Id of the target node or GRAPH_NO_ID
+ * @return True if the target was reached or if no target was given
+ */
+bool graph_search_run(graph_search_t * search,
+                      const graph_view_t * view,
+                      size_t source,
+                      size_t target)
+{
+    assert(search->node_count >= view->node_count);
+    assert(source < view->node_count);
+
+    graph_search_reset(search);
+
+    search->distances[source] = 0;
+    search->touched[search->touched_count++] = source;
+    heap_indexed_push(search->heap, source, 0);
+
+    while (!heap_indexed_is_empty(search->heap))
+    {
+        uint64_t distance;
+        size_t id = heap_indexed_pop(search->heap, &distance);
+        search->settled[id] = true;
+        if (id == target)
+        {
+            return true;
+        }
+
+        graph_cursor_t cursor;
+        size_t neighbor;
+        uint32_t weight;
+        graph_view_first(view, id, &cursor);
+        while (graph_view_next(view, &cursor, &neighbor, &weight))
+        {
+            uint64_t next = distance + weight;
+            if (search->settled[neighbor] || (next >= search->distances[neighbor]))
+            {
+                continue;
+            }
+
+            if (UINT64_MAX == search->distances[neighbor])
+            {
+                search->touched[search->touched_count++] = neighbor;
+                heap_indexed_push(search->heap, neighbor, next);
+            }
+            else
+            {
+                heap_indexed_decrease_key(search->heap, neighbor, next);
+            }
+            search->distances[neighbor] = next;
+            search->prev[neighbor] = id;
+        }
+    }
+    return (GRAPH_NO_ID == target);
+}
+
+/*!
+ * @brief Perform the A* algorithm from the source to the target id of the
+ * view. The heap is keyed by the distance from the source plus the estimate
+ * of the heuristic, while the distances array keeps the real distance.
+ *
+ * An admissible heuristic that is not consistent can find a shorter way to a
+ * node that was already expanded. Such a node is pushed again instead of
+ * being skipped, so the first time the target is popped its distance is the
+ * shortest one.
+ *
+ * @param search Search state sized for the view, it is reset first
+ * @param view View of the graph
+ * @param source Id of the source node
+ * @param target Id of the target node
+ * @param heuristic Callback estimating the weight from a node to the target
+ * @param ctx Context passed to the heuristic
+ * @return True if the target was reached
+ */
+bool graph_search_run_astar(graph_search_t * search,
+                            const graph_view_t * view,
+                            size_t source,
+                            size_t target,
+                            graph_heuristic_t heuristic,
+                            void * ctx)
+{
+    assert(search->node_count >= view->node_count);
+    assert(source < view->node_count);
+    assert(target < view->node_count);
+
+    graph_search_reset(search);
+
+    gnode_t * target_node = view->nodes[target];
+    search->distances[source] = 0;
+    search->touched[search->touched_count++] = source;
+    heap_indexed_push(search->heap, source,
+                      heuristic(view->nodes[source], target_node, ctx));
+
+    while (!heap_indexed_is_empty(search->heap))
+    {
+        size_t id = heap_indexed_pop(search->heap, NULL);
+        if (id == target)
+        {
+            return true;
+        }
+
+        graph_cursor_t cursor;
+        size_t neighbor;
+        uint32_t weight;
+        graph_view_first(view, id, &cursor);
+        while (graph_view_next(view, &cursor, &neighbor, &weight))
+        {
+            uint64_t next = search->distances[id] + weight;
+            if (next >= search->distances[neighbor])
+            {
+                continue;
+            }
+
+            if (UINT64_MAX == search->distances[neighbor])
+            {
+                search->touched[search->touched_count++] = neighbor;
+            }
+            search->distances[neighbor] = next;
+            search->prev[neighbor] = id;
+
+            uint64_t key = next + heuristic(view->nodes[neighbor], target_node, ctx);
+            if (!heap_indexed_decrease_key(search->heap, neighbor, key))
+            {
+                heap_indexed_push(search->heap, neighbor, key);
+            }
+        }
+    }
+    return false;
+}
+
+/*!
+ * @brief Find the shortest path between two ids of the view
+ *
+ * @param view View of the graph
+ * @param source Id of the source node
+ * @param target Id of the target node
+ * @return NULL if no path was found or a path structure containing the path
+ */
+path_t * graph_view_get_path(graph_view_t * view, size_t source, size_t target)
+{
+    assert(source < view->node_count);
+    assert(target < view->node_count);
+
+    graph_search_t * search = graph_search_init(view->node_count);
+    if (NULL == search)
+    {
+        return NULL;
+    }
+
+    path_t * path = NULL;
+    if (graph_search_run(search, view, source, target))
+    {
+        path = graph_view_build_path(view,
+                                     search->prev,
+                                     target,
+                                     search->distances[target]);
+    }
+
+    graph_search_destroy(search);
+    return path;
+}
+
+/*!
+ * @brief Settle the closest node of one side of a bidirectional search and
+ * relax its edges. Every time a node gets a shorter distance and the other
+ * side already reached it, the path through that node is a candidate for the
+ * shortest path.
+ *
+ * @param search Search state of the side being expanded
+ * @param other Search state of the opposite side
+ * @param view View walked by this side
+ * @param best Weight of the shortest path met so far
+ * @param meet Id of the node where the shortest path met so far crosses
+ */
+static void expand_side(graph_search_t * search,
+                        graph_search_t * other,
+                        const graph_view_t * view,
+                        uint64_t * best,
+                        size_t * meet)
+{
+    uint64_t distance;
+    size_t id = heap_indexed_pop(search->heap, &distance);
+    search->settled[id] = true;
+
+    graph_cursor_t cursor;
+    size_t neighbor;
+    uint32_t weight;
+    graph_view_first(view, id, &cursor);
+    while (graph_view_next(view, &cursor, &neighbor, &weight))
+    {
+        uint64_t next = distance + weight;
+        if (search->settled[neighbor] || (next >= search->distances[neighbor]))
+        {
+            continue;
+        }
+
+        if (UINT64_MAX == search->distances[neighbor])
+        {
+            search->touched[search->touched_count++] = neighbor;
+            heap_indexed_push(search->heap, neighbor, next);
+        }
+        else
+        {
+            heap_indexed_decrease_key(search->heap, neighbor, next);
+        }
+        search->distances[neighbor] = next;
+        search->prev[neighbor] = id;
+
+        if ((UINT64_MAX != other->distances[neighbor])
+            && (next + other->distances[neighbor] < * best))
+        {
+            * best = next + other->distances[neighbor];
+            * meet = neighbor;
+        }
+    }
+}
+
+/*!
+ * @brief Find the shortest path between two ids by running dijkstra from the
+ * source on the view and from the target on the reverse view at the same
+ * time. The side with the closer frontier is expanded first and the search
+ * stops once the two frontiers together are at least as far as the best path
+ * that crosses both sides, so each side only explores about half the radius
+ * of a single search.
+ *
+ * @param view View of the graph
+ * @param reverse View of the graph with every edge reversed
+ * @param source Id of the source node
+ * @param target Id of the target node
+ * @return NULL if no path was found or a path structure containing the path
+ */
+path_t * graph_view_get_path_bidirectional(const graph_view_t * view,
+                                           const graph_view_t * reverse,
+                                           size_t source,
+                                           size_t target)
+{
+    assert(source < view->node_count);
+    assert(target < view->node_count);
+
+    graph_search_t * forward = graph_search_init(view->node_count);
+    graph_search_t * backward = graph_search_init(view->node_count);
+    if ((NULL == forward) || (NULL == backward))
+    {
+        if (NULL != forward)
+        {
+            graph_search_destroy(forward);
+        }
+        if (NULL != backward)
+        {
+            graph_search_destroy(backward);
+        }
+        return NULL;
+    }
+
+    forward->distances[source] = 0;
+    forward->touched[forward->touched_count++] = source;
+    heap_indexed_push(forward->heap, source, 0);
+    backward->distances[target] = 0;
+    backward->touched[backward->touched_count++] = target;
+    heap_indexed_push(backward->heap, target, 0);
+
+    uint64_t best = (source == target) ? 0 : UINT64_MAX;
+    size_t meet = (source == target) ? source : GRAPH_NO_ID;
+    while (!heap_indexed_is_empty(forward->heap)
+           && !heap_indexed_is_empty(backward->heap))
+    {
+        uint64_t forward_key;
+        uint64_t backward_key;
+        heap_indexed_peek(forward->heap, &forward_key);
+        heap_indexed_peek(backward->heap, &backward_key);
+        if ((UINT64_MAX != best) && (forward_key + backward_key >= best))
+        {
+            break;
+        }
+
+        if (forward_key <= backward_key)
+        {
+            expand_side(forward, backward, view, &best, &meet);
+        }
+        else
+        {
+            expand_side(backward, forward, reverse, &best, &meet);
+        }
+    }
+
+    path_t * path = NULL;
+    if (GRAPH_NO_ID != meet)
+    {
+        // The forward half runs from the source to the meeting node and the
+        // backward prev ids lead from there on to the target
+        path = graph_view_build_path(view, forward->prev, meet, best);
+        if (NULL != path)
+        {
+            for (size_t id = backward->prev[meet]; GRAPH_NO_ID != id; id = backward->prev[id])
+            {
+                dlist_append(path->path, view->nodes[id]);
+            }
+        }
+    }
+
+    graph_search_destroy(forward);
+    graph_search_destroy(backward);
+    return path;
+}
+
+/*!
+ * @brief Build the path_t structure by walking the prev ids from the target
+ * back to the source
+ *
+ * @param view View of the graph
+ * @param prev Previous id of every node on its shortest path, GRAPH_NO_ID for
+ * the source
+ * @param target Id of the last node of the path
+ * @param path_weight Total weight of the path
+ * @return Path structure or NULL if it could not be allocated
+ */
+path_t * graph_view_build_path(const graph_view_t * view,
+                               const size_t * prev,
+                               size_t target,
+                               uint64_t path_weight)
+{
+    path_t * path = (path_t *)malloc(sizeof(path_t));
+    if (UV_INVALID_ALLOC == verify_alloc(path))
+    {
+        return NULL;
+    }
+
+    dlist_t * path_list = dlist_init(view->compare_callback);
+    if (NULL == path_list)
+    {
+        free(path);
+        return NULL;
+    }
+
+    for (size_t id = target; GRAPH_NO_ID != id; id = prev[id])
+    {
+        dlist_prepend(path_list, view->nodes[id]);
+    }
+
+    * path = (path_t){
+        .path_weight    = path_weight,
+        .path           = path_list
+    };
+    return path;
+}
+
+/*!
+ * @brief Run a search from the source without a target and keep its distance
+ * and previous id arrays as the shortest path tree
+ *
+ * @param view View of the graph
+ * @param source Id of the source node
+ * @return Shortest path tree or NULL if an allocation failed
+ */
+graph_spt_t * graph_view_shortest_path_tree(const graph_view_t * view,
+                                            size_t source)
+{
+    assert(source < view->node_count);
+
+    graph_spt_t * spt = (graph_spt_t *)calloc(1, sizeof(graph_spt_t));
+    if (UV_INVALID_ALLOC == verify_alloc(spt))
+    {
+        return NULL;
+    }
+
+    gnode_t ** nodes = (gnode_t **)malloc(sizeof(gnode_t *) * (view->node_count + 1));
+    graph_search_t * search = graph_search_init(view->node_count);
+    if ((NULL == nodes) || (NULL == search))
+    {
+        free(nodes);
+        if (NULL != search)
+        {
+            graph_search_destroy(search);
+        }
+        free(spt);
+        return NULL;
+    }
+
+    graph_search_run(search, view, source, GRAPH_NO_ID);
+
+    for (size_t id = 0; id < view->node_count; id++)
+    {
+        nodes[id] = view->nodes[id];
+    }
+    spt->view = (graph_view_t){
+        .node_count         = view->node_count,
+        .nodes              = nodes,
+        .compare_callback   = view->compare_callback
+    };
+    spt->source = source;
+
+    // The tree takes over the arrays of the search
+    spt->distances = search->distances;
+    spt->prev = search->prev;
+    search->distances = NULL;
+    search->prev = NULL;
+    graph_search_destroy(search);
+    return spt;
+}
+
+/*!
+ * @brief Destroy the shortest path tree
+ * @param spt Pointer to the shortest path tree
+ */
+void graph_spt_destroy(graph_spt_t * spt)
+{
+    free(spt->view.nodes);
+    free(spt->distances);
+    free(spt->prev);
+    free(spt);
+}
+
+/*!
+ * @brief Fetch the source node of the shortest path tree
+ * @param spt Pointer to the shortest path tree
+ * @return Pointer to the source gnode
+ */
+gnode_t * graph_spt_get_source(graph_spt_t * spt)
+{
+    return spt->view.nodes[spt->source];
+}
+
+/*!
+ * @brief Check if there is a path from the source to the target node
+ * @param spt Pointer to the shortest path tree
+ * @param target_node Pointer to the target node object
+ * @return Bool indicating if the target can be reached
+ */
+bool graph_spt_reachable(graph_spt_t * spt, gnode_t * target_node)
+{
+    return (UINT64_MAX != graph_spt_get_distance(spt, target_node));
+}
+
+/*!
+ * @brief Fetch the weight of the shortest path from the source to the target
+ * @param spt Pointer to the shortest path tree
+ * @param target_node Pointer to the target node object
+ * @return Weight of the path or UINT64_MAX if the target can not be reached
+ */
+uint64_t graph_spt_get_distance(graph_spt_t * spt, gnode_t * target_node)
+{
+    size_t target = get_spt_node_id(spt, target_node);
+    if (GRAPH_NO_ID == target)
+    {
+        return UINT64_MAX;
+    }
+    return spt->distances[target];
+}
+
+/*!
+ * @brief Fetch the node before the given node on its shortest path
+ * @param spt Pointer to the shortest path tree
+ * @param node Pointer to the node object
+ * @return Pointer to the previous gnode or NULL for the source and for nodes
+ * that can not be reached
+ */
+gnode_t * graph_spt_get_prev(graph_spt_t * spt, gnode_t * node)
+{
+    size_t id = get_spt_node_id(spt, node);
+    if ((GRAPH_NO_ID == id) || (GRAPH_NO_ID == spt->prev[id]))
+    {
+        return NULL;
+    }
+    return spt->view.nodes[spt->prev[id]];
+}
+
+/*!
+ * @brief Extract the path from the source to the target. The cost is the
+ * length of the path.
+ * @param spt Pointer to the shortest path tree
+ * @param target_node Pointer to the target node object
+ * @return NULL if the target can not be reached or a path structure
+ * containing the path. The path is freed with graph_free_path
+ */
+path_t * graph_spt_get_path(graph_spt_t * spt, gnode_t * target_node)
+{
+    size_t target = get_spt_node_id(spt, target_node);
+    if ((GRAPH_NO_ID == target) || (UINT64_MAX == spt->distances[target]))
+    {
+        return NULL;
+    }
+    return graph_view_build_path(&spt->view,
+                                 spt->prev,
+                                 target,
+                                 spt->distances[target]);
+}
+
+static size_t get_spt_node_id(graph_spt_t * spt, gnode_t * node)
+{
+    return graph_view_get_node_id(&spt->view, node);
+}
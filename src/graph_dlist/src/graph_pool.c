@@ -0,0 +1,172 @@
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include <utils.h>
+
+#include "graph_internal.h"
+
+typedef enum
+{
+    POOL_FIRST_CHUNK = 64,          // Blocks of the first chunk
+    POOL_MAX_CHUNK = 65536,         // Chunks stop doubling at this many blocks
+} graph_pool_settings_t;
+
+// Header in front of the blocks of every chunk, sized so the blocks that
+// follow it are aligned for any type
+typedef union pool_chunk_t
+{
+    union pool_chunk_t * next;
+    max_align_t align;
+} pool_chunk_t;
+
+static bool add_chunk(graph_pool_t * pool, size_t block_count);
+
+/*!
+ * @brief Initialize an empty pool. No memory is taken until the first block
+ * is allocated
+ * @param pool Pool to initialize
+ * @param block_size Size of every block, rounded up so that blocks stay
+ * aligned for pointers and 64 bit integers
+ */
+void graph_pool_init(graph_pool_t * pool, size_t block_size)
+{
+    size_t alignment = sizeof(void *) > sizeof(uint64_t) ? sizeof(void *) : sizeof(uint64_t);
+    if (block_size < sizeof(void *))
+    {
+        block_size = sizeof(void *);
+    }
+
+    * pool = (graph_pool_t){
+        .block_size     = (block_size + alignment - 1) / alignment * alignment,
+        .chunk_blocks   = POOL_FIRST_CHUNK,
+        .cursor         = NULL,
+        .chunk_end      = NULL,
+        .chunks         = NULL,
+        .free_list      = NULL,
+        .reserved       = 0
+    };
+}
+
+/*!
+ * @brief Free every chunk of the pool at once, including the blocks that are
+ * still handed out
+ * @param pool Pool to destroy
+ */
+void graph_pool_destroy(graph_pool_t * pool)
+{
+    pool_chunk_t * chunk = (pool_chunk_t *)pool->chunks;
+    while (NULL != chunk)
+    {
+        pool_chunk_t * next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    graph_pool_init(pool, pool->block_size);
+}
+
+/*!
+ * @brief Make sure the next block_count allocations are carved one after the
+ * other from a single chunk. Released blocks are not handed out until the
+ * reservation is used up. Used by bulk loads that know how many blocks they
+ * need
+ * @param pool Pointer to the pool
+ * @param block_count Number of blocks to reserve
+ * @return False if the chunk could not be allocated
+ */
+bool graph_pool_reserve(graph_pool_t * pool, size_t block_count)
+{
+    size_t left = (NULL == pool->cursor)
+        ? 0 : (size_t)(pool->chunk_end - pool->cursor) / pool->block_size;
+    if (left < block_count)
+    {
+        // Keep the tail of the current chunk for later allocations
+        while (pool->cursor != pool->chunk_end)
+        {
+            graph_pool_release(pool, pool->cursor);
+            pool->cursor += pool->block_size;
+        }
+        if (!add_chunk(pool, block_count))
+        {
+            return false;
+        }
+    }
+    pool->reserved = block_count;
+    return true;
+}
+
+/*!
+ * @brief Take a block from the pool. Outside of a reservation released blocks
+ * are reused first, then the current chunk is carved, and a new chunk twice
+ * the size of the last one is added once it runs out
+ * @param pool Pointer to the pool
+ * @return Uninitialized block or NULL if a chunk could not be allocated
+ */
+void * graph_pool_alloc(graph_pool_t * pool)
+{
+    if (0 != pool->reserved)
+    {
+        // graph_pool_reserve made sure the current chunk holds these blocks
+        pool->reserved--;
+        void * block = pool->cursor;
+        pool->cursor += pool->block_size;
+        return block;
+    }
+
+    if (NULL != pool->free_list)
+    {
+        void * block = pool->free_list;
+        pool->free_list = * (void **)block;
+        return block;
+    }
+
+    if (pool->cursor == pool->chunk_end)
+    {
+        if (!add_chunk(pool, pool->chunk_blocks))
+        {
+            return NULL;
+        }
+        if (pool->chunk_blocks < POOL_MAX_CHUNK)
+        {
+            pool->chunk_blocks *= 2;
+        }
+    }
+
+    void * block = pool->cursor;
+    pool->cursor += pool->block_size;
+    return block;
+}
+
+/*!
+ * @brief Give a block back to the pool so that the next allocation reuses it
+ * @param pool Pointer to the pool the block came from
+ * @param block Block to release
+ */
+void graph_pool_release(graph_pool_t * pool, void * block)
+{
+    assert(block);
+    * (void **)block = pool->free_list;
+    pool->free_list = block;
+}
+
+/*!
+ * @brief Allocate a chunk of blocks and make it the one being carved
+ * @param pool Pointer to the pool
+ * @param block_count Number of blocks in the chunk
+ * @return False if the chunk could not be allocated
+ */
+static bool add_chunk(graph_pool_t * pool, size_t block_count)
+{
+    pool_chunk_t * chunk = (pool_chunk_t *)malloc(sizeof(pool_chunk_t)
+                                                  + (pool->block_size * block_count));
+    if (UV_INVALID_ALLOC == verify_alloc(chunk))
+    {
+        return false;
+    }
+
+    chunk->next = (pool_chunk_t *)pool->chunks;
+    pool->chunks = chunk;
+    pool->cursor = (uint8_t *)(chunk + 1);
+    pool->chunk_end = pool->cursor + (pool->block_size * block_count);
+    return true;
+}
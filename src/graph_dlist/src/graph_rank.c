@@ -0,0 +1,366 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include <graph_csr.h>
+#include <thread_pool.h>
+#include <utils.h>
+
+#include "graph_internal.h"
+
+typedef enum
+{
+    RANK_CHUNK = 2048,              // Node ids per task
+} graph_rank_settings_t;
+
+typedef struct graph_rank_t
+{
+    graph_view_t view;              // Owns a copy of the nodes of the view
+    double * scores;                // Score of every node id, they sum to 1
+    size_t iterations;
+    bool converged;
+} graph_rank_t;
+
+// State shared by the tasks of one iteration
+typedef struct rank_state_t
+{
+    size_t node_count;
+    const uint64_t * offsets;       // Out edges of the snapshot
+    const uint64_t * in_offsets;    // Edges leading to node i are
+    const uint32_t * in_sources;    // in_sources[in_offsets[i], in_offsets[i + 1])
+    double * scores;
+    double * next_scores;
+    double * contributions;         // Score of a node divided by its out degree
+    double * partials;              // Sum computed by every task
+    double damping;
+    double base;                    // Score every node gets without edges
+} rank_state_t;
+
+static void contribution_task(void * context, size_t task_index, size_t thread_index);
+static void pull_task(void * context, size_t task_index, size_t thread_index);
+static double run_step(rank_state_t * state,
+                       thread_pool_t * pool,
+                       size_t task_count,
+                       void (* task)(void *, size_t, size_t));
+static bool build_in_edges(graph_csr_t * csr, rank_state_t * state);
+static size_t get_rank_node_id(graph_rank_t * rank, gnode_t * node);
+
+/*!
+ * @brief Compute the PageRank of every node of the snapshot with a pull based
+ * power iteration.
+ *
+ * Every iteration first stores the score of each node divided by its out
+ * degree in a flat array and then has every node sum the entries of the nodes
+ * with an edge to it. Both passes are split in chunks of RANK_CHUNK
+ * consecutive ids across a thread pool. A node only writes its own score, so
+ * the passes need no atomics, and the sources of every node are sorted so the
+ * reads of a chunk move forward through the contribution array. The score of
+ * nodes without out edges is spread evenly over all nodes.
+ *
+ * In GRAPH_DIRECTED mode every edge has its mirror and the edges of the
+ * snapshot are read as they are. Otherwise the edges are transposed once
+ * before the first iteration. The weights of the edges are ignored.
+ *
+ * @param csr Pointer to the snapshot object
+ * @param damping Probability of following an edge, in [0, 1], usually 0.85
+ * @param tolerance The iteration stops once the scores changed by less than
+ * this in total
+ * @param max_iterations Upper bound of the number of iterations
+ * @param thread_count Number of threads to use, 0 for one per online cpu
+ * @return Scores or NULL if the damping is out of range or an allocation
+ * failed
+ */
+graph_rank_t * graph_csr_pagerank(graph_csr_t * csr,
+                                  double damping,
+                                  double tolerance,
+                                  size_t max_iterations,
+                                  size_t thread_count)
+{
+    assert(csr);
+    if ((damping < 0.0) || (damping > 1.0))
+    {
+        debug_print_err("%s\n", "The damping must be within [0, 1]");
+        return NULL;
+    }
+
+    size_t node_count = csr->node_count;
+    size_t task_count = (node_count + RANK_CHUNK - 1) / RANK_CHUNK;
+    graph_rank_t * rank = (graph_rank_t *)calloc(1, sizeof(graph_rank_t));
+    gnode_t ** nodes = (gnode_t **)malloc(sizeof(gnode_t *) * (node_count + 1));
+    rank_state_t state = {
+        .node_count     = node_count,
+        .offsets        = csr->offsets,
+        .in_offsets     = csr->offsets,
+        .in_sources     = csr->targets,
+        .scores         = (double *)malloc(sizeof(double) * (node_count + 1)),
+        .next_scores    = (double *)malloc(sizeof(double) * (node_count + 1)),
+        .contributions  = (double *)malloc(sizeof(double) * (node_count + 1)),
+        .partials       = (double *)malloc(sizeof(double) * (task_count + 1)),
+        .damping        = damping
+    };
+    bool transposed = (GRAPH_DIRECTED != csr->graph_mode);
+    if ((NULL == rank) || (NULL == nodes) || (NULL == state.scores)
+        || (NULL == state.next_scores) || (NULL == state.contributions)
+        || (NULL == state.partials) || (transposed && !build_in_edges(csr, &state)))
+    {
+        debug_print_err("%s\n", "Unable to allocate the PageRank state");
+        free(rank);
+        free(nodes);
+        free(state.scores);
+        free(state.next_scores);
+        free(state.contributions);
+        free(state.partials);
+        return NULL;
+    }
+
+    double initial = (0 == node_count) ? 0.0 : 1.0 / (double)node_count;
+    for (size_t id = 0; id < node_count; id++)
+    {
+        nodes[id] = csr->nodes[id];
+        state.scores[id] = initial;
+    }
+
+    if (0 == thread_count)
+    {
+        thread_count = thread_pool_get_cpu_count();
+    }
+    thread_pool_t * pool = ((thread_count > 1) && (task_count > 1))
+        ? thread_pool_init(thread_count) : NULL;
+
+    size_t iterations = 0;
+    bool converged = (0 == node_count);
+    while (!converged && (iterations < max_iterations))
+    {
+        double dangling = run_step(&state, pool, task_count, contribution_task);
+        state.base = (1.0 - damping + damping * dangling) / (double)node_count;
+        double change = run_step(&state, pool, task_count, pull_task);
+
+        double * swap = state.scores;
+        state.scores = state.next_scores;
+        state.next_scores = swap;
+        iterations++;
+        converged = (change < tolerance);
+    }
+
+    if (NULL != pool)
+    {
+        thread_pool_destroy(pool);
+    }
+    if (transposed)
+    {
+        free((void *)state.in_offsets);
+        free((void *)state.in_sources);
+    }
+    free(state.next_scores);
+    free(state.contributions);
+    free(state.partials);
+
+    * rank = (graph_rank_t){
+        .view           = {
+            .node_count         = node_count,
+            .nodes              = nodes,
+            .compare_callback   = csr->compare_callback
+        },
+        .scores         = state.scores,
+        .iterations     = iterations,
+        .converged      = converged
+    };
+    return rank;
+}
+
+/*!
+ * @brief Destroy the result of graph_csr_pagerank
+ * @param rank Pointer to the scores
+ */
+void graph_rank_destroy(graph_rank_t * rank)
+{
+    free(rank->view.nodes);
+    free(rank->scores);
+    free(rank);
+}
+
+/*!
+ * @brief Fetch the score of the node
+ * @param rank Pointer to the scores
+ * @param node Pointer to the node object
+ * @return Score of the node or 0 if the node is not in the snapshot
+ */
+double graph_rank_get_score(graph_rank_t * rank, gnode_t * node)
+{
+    size_t id = get_rank_node_id(rank, node);
+    if (GRAPH_NO_ID == id)
+    {
+        return 0.0;
+    }
+    return rank->scores[id];
+}
+
+/*!
+ * @brief Fetch the number of iterations that were run
+ * @param rank Pointer to the scores
+ * @return Number of iterations
+ */
+size_t graph_rank_iterations(graph_rank_t * rank)
+{
+    return rank->iterations;
+}
+
+/*!
+ * @brief Check if the scores changed by less than the tolerance in the last
+ * iteration
+ * @param rank Pointer to the scores
+ * @return True if the iteration converged before max_iterations
+ */
+bool graph_rank_converged(graph_rank_t * rank)
+{
+    return rank->converged;
+}
+
+/*!
+ * @brief Compute the contribution of a chunk of nodes and sum the scores of
+ * the nodes of the chunk without out edges
+ */
+static void contribution_task(void * context, size_t task_index, size_t thread_index)
+{
+    (void)thread_index;
+    rank_state_t * state = (rank_state_t *)context;
+    size_t start = task_index * RANK_CHUNK;
+    size_t end = start + RANK_CHUNK;
+    if (end > state->node_count)
+    {
+        end = state->node_count;
+    }
+
+    double dangling = 0.0;
+    for (size_t id = start; id < end; id++)
+    {
+        uint64_t degree = state->offsets[id + 1] - state->offsets[id];
+        if (0 == degree)
+        {
+            dangling += state->scores[id];
+            state->contributions[id] = 0.0;
+        }
+        else
+        {
+            state->contributions[id] = state->scores[id] / (double)degree;
+        }
+    }
+    state->partials[task_index] = dangling;
+}
+
+/*!
+ * @brief Compute the next score of a chunk of nodes from the contributions of
+ * their sources and sum how much the scores changed
+ */
+static void pull_task(void * context, size_t task_index, size_t thread_index)
+{
+    (void)thread_index;
+    rank_state_t * state = (rank_state_t *)context;
+    size_t start = task_index * RANK_CHUNK;
+    size_t end = start + RANK_CHUNK;
+    if (end > state->node_count)
+    {
+        end = state->node_count;
+    }
+
+    double change = 0.0;
+    for (size_t id = start; id < end; id++)
+    {
+        double sum = 0.0;
+        for (uint64_t index = state->in_offsets[id]; index < state->in_offsets[id + 1]; index++)
+        {
+            sum += state->contributions[state->in_sources[index]];
+        }
+
+        double score = state->base + state->damping * sum;
+        double delta = score - state->scores[id];
+        change += (delta < 0.0) ? -delta : delta;
+        state->next_scores[id] = score;
+    }
+    state->partials[task_index] = change;
+}
+
+/*!
+ * @brief Run every task of a pass, on the pool if there is one, and add up
+ * their partial sums. The sums are added in task order so the result does not
+ * depend on the number of threads
+ * @return Sum of the partial sums of the tasks
+ */
+static double run_step(rank_state_t * state,
+                       thread_pool_t * pool,
+                       size_t task_count,
+                       void (* task)(void *, size_t, size_t))
+{
+    if (NULL == pool)
+    {
+        for (size_t index = 0; index < task_count; index++)
+        {
+            task(state, index, 0);
+        }
+    }
+    else
+    {
+        thread_pool_run(pool, task_count, task, state);
+    }
+
+    double total = 0.0;
+    for (size_t index = 0; index < task_count; index++)
+    {
+        total += state->partials[index];
+    }
+    return total;
+}
+
+/*!
+ * @brief Transpose the edges of the snapshot with a counting sort by target.
+ * The sources are walked in order so the sources of every node stay sorted
+ * @param csr Pointer to the snapshot object
+ * @param state State whose in_offsets and in_sources are set
+ * @return False if an allocation failed
+ */
+static bool build_in_edges(graph_csr_t * csr, rank_state_t * state)
+{
+    size_t node_count = csr->node_count;
+    uint64_t * in_offsets = (uint64_t *)calloc(node_count + 1, sizeof(uint64_t));
+    uint32_t * in_sources = (uint32_t *)malloc(sizeof(uint32_t) * (csr->edge_count + 1));
+    if ((NULL == in_offsets) || (NULL == in_sources))
+    {
+        free(in_offsets);
+        free(in_sources);
+        return false;
+    }
+
+    for (size_t index = 0; index < csr->edge_count; index++)
+    {
+        in_offsets[csr->targets[index] + 1]++;
+    }
+    for (size_t id = 0; id < node_count; id++)
+    {
+        in_offsets[id + 1] += in_offsets[id];
+    }
+
+    // Use the start of every row as its write position and shift back after
+    for (size_t id = 0; id < node_count; id++)
+    {
+        for (uint64_t index = csr->offsets[id]; index < csr->offsets[id + 1]; index++)
+        {
+            in_sources[in_offsets[csr->targets[index]]++] = (uint32_t)id;
+        }
+    }
+    for (size_t id = node_count; id > 0; id--)
+    {
+        in_offsets[id] = in_offsets[id - 1];
+    }
+    in_offsets[0] = 0;
+
+    state->in_offsets = in_offsets;
+    state->in_sources = in_sources;
+    return true;
+}
+
+/*!
+ * @brief Find the id of the node within the scores
+ */
+static size_t get_rank_node_id(graph_rank_t * rank, gnode_t * node)
+{
+    return graph_view_get_node_id(&rank->view, node);
+}
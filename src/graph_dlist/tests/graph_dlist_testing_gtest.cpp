@@ -1,6 +1,10 @@
 #include <gtest/gtest.h>
 #include <graph_dlist.h>
+#include <graph_csr.h>
 #include <hashtable.h>
+#include <algorithm>
+#include <random>
+#include <tuple>
 
 /*
  * Helper Functions for testing
@@ -50,6 +54,52 @@ char * print_callback(void * node)
     return str;
 }
 
+// Graph of a random test, nodes[value] is the node holding value and edges
+// holds the (source, target, weight) of every edge graph_add_edge accepted
+typedef struct
+{
+    graph_t * graph;
+    std::vector<gnode_t *> nodes;
+    std::vector<std::tuple<size_t, size_t, uint32_t>> edges;
+} random_graph_t;
+
+// Create a graph holding the values 0 to node_count - 1 and try to add
+// edge_count random edges. The targets are drawn from the first target_count
+// nodes, all of them when 0, and the weights are below max_weight, or
+// NO_WEIGHT when 0
+static random_graph_t create_random_graph(graph_mode_t mode,
+                                          size_t node_count,
+                                          size_t edge_count,
+                                          uint32_t seed,
+                                          size_t target_count = 0,
+                                          uint32_t max_weight = 0)
+{
+    random_graph_t random_graph = {graph_init(mode, compare_payloads, hash_callback), {}, {}};
+    for (size_t value = 0; value < node_count; value++)
+    {
+        graph_add_value(random_graph.graph, get_payload((int)value));
+        int key = (int)value;
+        random_graph.nodes.push_back(graph_get_node_by_value(random_graph.graph, &key));
+    }
+
+    std::mt19937 rng(seed);
+    target_count = (0 == target_count) ? node_count : target_count;
+    for (size_t index = 0; index < edge_count; index++)
+    {
+        size_t source = rng() % node_count;
+        size_t target = rng() % target_count;
+        uint32_t weight = (0 == max_weight) ? NO_WEIGHT : (uint32_t)(rng() % max_weight);
+        if (GRAPH_SUCCESS == graph_add_edge(random_graph.graph,
+                                            random_graph.nodes[source],
+                                            random_graph.nodes[target],
+                                            weight))
+        {
+            random_graph.edges.emplace_back(source, target, weight);
+        }
+    }
+    return random_graph;
+}
+
 
 TEST(GraphBasic, TestBasicStartUp)
 {
@@ -167,6 +217,12 @@ TEST_F(GraphDlistFixture, AddEdgeTest)
     uint32_t weight = 0;
     EXPECT_EQ(graph_add_edge(this->graph, node0, node6, weight), GRAPH_SUCCESS);
     EXPECT_EQ(3, graph_edge_count(node0));
+
+    // The edge is mirrored so it can not be added again from either side
+    EXPECT_EQ(graph_add_edge(this->graph, node0, node6, weight), GRAPH_EDGE_ALREADY_EXISTS);
+    EXPECT_EQ(graph_add_edge(this->graph, node6, node0, weight), GRAPH_EDGE_ALREADY_EXISTS);
+    EXPECT_EQ(3, graph_edge_count(node0));
+    EXPECT_EQ(3, graph_edge_count(node6));
 }
 
 //Test ability to remove an edge that exist and an edge that does not
@@ -258,6 +314,13 @@ TEST_F(GraphDlistFixture, TestNodeRemoval)
     EXPECT_EQ(2, graph_edge_count(node1));
     EXPECT_EQ(2, graph_edge_count(node5));
     EXPECT_EQ(2, graph_edge_count(node8));
+
+    // The ids stay dense after the removal
+    for (size_t id = 0; id < graph_node_count(this->graph); id++)
+    {
+        gnode_t * node = graph_get_node_by_value(this->graph, &this->graph_data.at(id < 4 ? id : id + 1));
+        EXPECT_LT(graph_get_node_id(node), graph_node_count(this->graph));
+    }
 }
 
 
@@ -497,3 +560,1373 @@ TEST_F(GraphDlistFixture, TestPathFinding7)
     dlist_destroy_iter(iter);
     graph_free_path(path);
 }
+
+// Test that nodes are found by value through the node index while nodes are
+// added and removed
+TEST(GraphBasic, TestNodeIndex)
+{
+    graph_t * graph = graph_init(GRAPH_DIRECTED, compare_payloads, hash_callback);
+    int node_count = 5000;
+    for (int value = 0; value < node_count; value++)
+    {
+        EXPECT_EQ(GRAPH_SUCCESS, graph_add_value(graph, get_payload(value)));
+    }
+    EXPECT_EQ(node_count, graph_node_count(graph));
+
+    int * duplicate = get_payload(10);
+    EXPECT_EQ(GRAPH_FAIL_NODE_ALREADY_EXISTS, graph_add_value(graph, duplicate));
+    free(duplicate);
+
+    // Remove every even value
+    for (int value = 0; value < node_count; value += 2)
+    {
+        gnode_t * node = graph_get_node_by_value(graph, &value);
+        ASSERT_NE(node, nullptr);
+        EXPECT_EQ(GRAPH_SUCCESS, graph_remove_node(graph, node, free_payload));
+    }
+    EXPECT_EQ(node_count / 2, graph_node_count(graph));
+
+    for (int value = 0; value < node_count; value++)
+    {
+        gnode_t * node = graph_get_node_by_value(graph, &value);
+        if (0 == value % 2)
+        {
+            EXPECT_EQ(node, nullptr);
+            EXPECT_FALSE(graph_value_in_graph(graph, &value));
+        }
+        else
+        {
+            ASSERT_NE(node, nullptr);
+            EXPECT_EQ(value, *(int *)graph_get_node_value(node));
+            EXPECT_TRUE(graph_node_in_graph(graph, node));
+        }
+    }
+
+    // A node that is not in the graph is matched by its value
+    int value = 7;
+    gnode_t * probe = graph_create_node(&value);
+    EXPECT_TRUE(graph_node_in_graph(graph, probe));
+    graph_destroy_node(probe, nullptr);
+
+    graph_destroy(graph, free_payload);
+}
+
+// Test that a hub node finds its edges through its edge index and that
+// duplicate edges are rejected
+TEST(GraphBasic, TestHubEdges)
+{
+    graph_t * graph = graph_init(GRAPH_UNDIRECTED, compare_payloads, hash_callback);
+    int node_count = 300;
+    for (int value = 0; value < node_count; value++)
+    {
+        graph_add_value(graph, get_payload(value));
+    }
+
+    int hub_value = 0;
+    gnode_t * hub = graph_get_node_by_value(graph, &hub_value);
+    for (int value = 1; value < node_count; value++)
+    {
+        gnode_t * node = graph_get_node_by_value(graph, &value);
+        EXPECT_EQ(GRAPH_SUCCESS, graph_add_edge(graph, hub, node, (uint32_t)value));
+        EXPECT_EQ(GRAPH_EDGE_ALREADY_EXISTS, graph_add_edge(graph, hub, node, 1));
+    }
+    EXPECT_EQ(node_count - 1, graph_edge_count(hub));
+
+    // Remove every even edge
+    for (int value = 2; value < node_count; value += 2)
+    {
+        gnode_t * node = graph_get_node_by_value(graph, &value);
+        EXPECT_EQ(GRAPH_SUCCESS, graph_remove_edge(graph, hub, node));
+        EXPECT_EQ(GRAPH_EDGE_NOT_FOUND, graph_remove_edge(graph, hub, node));
+    }
+
+    for (int value = 1; value < node_count; value++)
+    {
+        gnode_t * node = graph_get_node_by_value(graph, &value);
+        edge_t * edge = graph_get_edge(graph, hub, node);
+        if (0 == value % 2)
+        {
+            EXPECT_EQ(edge, nullptr);
+            EXPECT_FALSE(graph_node_a_neighbor(hub, node));
+        }
+        else
+        {
+            ASSERT_NE(edge, nullptr);
+            EXPECT_EQ(edge->weight, (uint32_t)value);
+            EXPECT_TRUE(graph_node_a_neighbor(hub, node));
+            EXPECT_TRUE(graph_edge_in_graph(graph, edge));
+        }
+        // The graph is one way so there is no edge back to the hub
+        EXPECT_FALSE(graph_node_a_neighbor(node, hub));
+    }
+
+    EXPECT_EQ(GRAPH_SUCCESS, graph_remove_node(graph, hub, free_payload));
+    graph_destroy(graph, free_payload);
+}
+
+// Test that the CSR snapshot holds the same adjacency as the graph
+TEST_F(GraphDlistFixture, TestCsrFreeze)
+{
+    graph_csr_t * csr = graph_csr_freeze(this->graph);
+    ASSERT_NE(csr, nullptr);
+    EXPECT_EQ(graph_node_count(this->graph), graph_csr_node_count(csr));
+
+    size_t total_edges = 0;
+    for (size_t id = 0; id < graph_csr_node_count(csr); id++)
+    {
+        gnode_t * node = graph_csr_get_node(csr, id);
+        EXPECT_EQ(id, graph_csr_get_node_id(csr, node));
+        EXPECT_EQ(graph_edge_count(node), graph_csr_edge_count(csr, id));
+
+        const uint32_t * targets = nullptr;
+        const uint32_t * weights = nullptr;
+        size_t degree = graph_csr_get_neighbors(csr, id, &targets, &weights);
+        for (size_t index = 0; index < degree; index++)
+        {
+            gnode_t * target = graph_csr_get_node(csr, targets[index]);
+            edge_t * edge = graph_get_edge(this->graph, node, target);
+            ASSERT_NE(edge, nullptr);
+            EXPECT_EQ(edge->weight, weights[index]);
+            EXPECT_TRUE(graph_csr_node_a_neighbor(csr, id, targets[index]));
+            if (index > 0)
+            {
+                EXPECT_LT(targets[index - 1], targets[index]);
+            }
+        }
+        total_edges += degree;
+    }
+    EXPECT_EQ(total_edges, graph_csr_total_edges(csr));
+
+    gnode_t * node0 = graph_get_node_by_value(this->graph, &this->graph_data.at(0));
+    gnode_t * node6 = graph_get_node_by_value(this->graph, &this->graph_data.at(6));
+    uint32_t weight = 0;
+    EXPECT_FALSE(graph_csr_node_a_neighbor(csr, graph_get_node_id(node0), graph_get_node_id(node6)));
+    EXPECT_FALSE(graph_csr_get_edge_weight(csr, graph_get_node_id(node0), graph_get_node_id(node6), &weight));
+    EXPECT_TRUE(graph_csr_get_edge_weight(csr, graph_get_node_id(node0), graph_get_node_id(node0) + 1, &weight));
+    EXPECT_EQ(weight, 2);
+
+    graph_csr_destroy(csr);
+}
+
+// Test ability to find the path from 0 to 7 on the CSR snapshot
+TEST_F(GraphDlistFixture, TestCsrPathFinding)
+{
+    gnode_t * node0 = graph_get_node_by_value(this->graph, &this->graph_data.at(0));
+    gnode_t * node7 = graph_get_node_by_value(this->graph, &this->graph_data.at(7));
+
+    std::vector<int> expected_path = {0, 1, 4, 8, 7};
+    size_t expected_weight = 9;
+
+    graph_csr_t * csr = graph_csr_freeze(this->graph);
+    ASSERT_NE(csr, nullptr);
+
+    path_t * path = graph_csr_get_path(csr, node0, node7);
+    ASSERT_NE(path, nullptr);
+    EXPECT_EQ(path->path_weight, expected_weight);
+
+    dlist_iter_t * iter = dlist_get_iterable(path->path, ITER_HEAD);
+    gnode_t * node = (gnode_t *)iter_get_value(iter);
+    int count = 0;
+    while (NULL != node)
+    {
+        int data = *(int*)graph_get_node_value(node);
+        EXPECT_EQ(data, expected_path.at((unsigned long)count));
+        node = (gnode_t *)dlist_get_iter_next(iter);
+        count++;
+    }
+    EXPECT_EQ(count, expected_path.size());
+
+    dlist_destroy_iter(iter);
+    graph_free_path(path);
+    graph_csr_destroy(csr);
+}
+
+// Test that the shortest paths of a random one way graph match the distances
+// computed with Floyd-Warshall, on the graph and on its CSR snapshot
+TEST(GraphBasic, TestPathMatchesFloydWarshall)
+{
+    graph_t * graph = graph_init(GRAPH_UNDIRECTED, compare_payloads, hash_callback);
+    size_t node_count = 60;
+    std::vector<gnode_t *> nodes;
+    for (size_t value = 0; value < node_count; value++)
+    {
+        graph_add_value(graph, get_payload((int)value));
+        int key = (int)value;
+        nodes.push_back(graph_get_node_by_value(graph, &key));
+    }
+
+    const uint64_t infinity = UINT64_MAX / 4;
+    std::vector<std::vector<uint64_t>> distances(
+        node_count, std::vector<uint64_t>(node_count, infinity));
+    std::mt19937 rng(11);
+    for (size_t index = 0; index < node_count * 4; index++)
+    {
+        size_t source = rng() % node_count;
+        size_t target = rng() % node_count;
+        uint32_t weight = (uint32_t)(rng() % 20);
+        if ((source != target)
+            && (GRAPH_SUCCESS == graph_add_edge(graph, nodes[source], nodes[target], weight)))
+        {
+            distances[source][target] = weight;
+        }
+    }
+
+    for (size_t id = 0; id < node_count; id++)
+    {
+        distances[id][id] = 0;
+    }
+    for (size_t middle = 0; middle < node_count; middle++)
+    {
+        for (size_t source = 0; source < node_count; source++)
+        {
+            for (size_t target = 0; target < node_count; target++)
+            {
+                uint64_t distance = distances[source][middle] + distances[middle][target];
+                if (distance < distances[source][target])
+                {
+                    distances[source][target] = distance;
+                }
+            }
+        }
+    }
+
+    graph_csr_t * csr = graph_csr_freeze(graph);
+    ASSERT_NE(csr, nullptr);
+    for (size_t source = 0; source < node_count; source++)
+    {
+        for (size_t target = 0; target < node_count; target++)
+        {
+            path_t * path = graph_get_path(graph, nodes[source], nodes[target]);
+            path_t * csr_path = graph_csr_get_path(csr, nodes[source], nodes[target]);
+            path_t * both_path = graph_get_path_bidirectional(graph, nodes[source], nodes[target]);
+            if (infinity == distances[source][target])
+            {
+                EXPECT_EQ(path, nullptr);
+                EXPECT_EQ(csr_path, nullptr);
+                EXPECT_EQ(both_path, nullptr);
+                continue;
+            }
+
+            ASSERT_NE(path, nullptr);
+            ASSERT_NE(csr_path, nullptr);
+            ASSERT_NE(both_path, nullptr);
+            EXPECT_EQ(distances[source][target], path->path_weight);
+            EXPECT_EQ(distances[source][target], csr_path->path_weight);
+            EXPECT_EQ(distances[source][target], both_path->path_weight);
+            EXPECT_EQ(nodes[source], dlist_get_head_node(both_path->path)->data);
+            EXPECT_EQ(nodes[target], dlist_get_tail_node(both_path->path)->data);
+
+            // The weights along the path add up to the path weight
+            uint64_t weight = 0;
+            dnode_t * link = dlist_get_head_node(path->path);
+            while (NULL != link->next)
+            {
+                edge_t * edge = graph_get_edge(graph,
+                                               (gnode_t *)link->data,
+                                               (gnode_t *)link->next->data);
+                ASSERT_NE(edge, nullptr);
+                weight += edge->weight;
+                link = link->next;
+            }
+            EXPECT_EQ(weight, path->path_weight);
+
+            // The two halves of the bidirectional path join into one path
+            weight = 0;
+            link = dlist_get_head_node(both_path->path);
+            while (NULL != link->next)
+            {
+                edge_t * edge = graph_get_edge(graph,
+                                               (gnode_t *)link->data,
+                                               (gnode_t *)link->next->data);
+                ASSERT_NE(edge, nullptr);
+                weight += edge->weight;
+                link = link->next;
+            }
+            EXPECT_EQ(weight, both_path->path_weight);
+
+            graph_free_path(path);
+            graph_free_path(csr_path);
+            graph_free_path(both_path);
+        }
+    }
+
+    graph_csr_destroy(csr);
+    graph_destroy(graph, free_payload);
+}
+
+// Test that every path extracted from the shortest path tree matches the path
+// found by graph_get_path
+TEST_F(GraphDlistFixture, TestShortestPathTree)
+{
+    gnode_t * node0 = graph_get_node_by_value(this->graph, &this->graph_data.at(0));
+    graph_spt_t * spt = graph_shortest_path_tree(this->graph, node0);
+    ASSERT_NE(spt, nullptr);
+    EXPECT_EQ(node0, graph_spt_get_source(spt));
+    EXPECT_EQ(nullptr, graph_spt_get_prev(spt, node0));
+    EXPECT_EQ(0, graph_spt_get_distance(spt, node0));
+
+    graph_csr_t * csr = graph_csr_freeze(this->graph);
+    ASSERT_NE(csr, nullptr);
+    graph_spt_t * csr_spt = graph_csr_shortest_path_tree(csr, node0);
+    ASSERT_NE(csr_spt, nullptr);
+
+    for (auto & value : this->graph_data)
+    {
+        gnode_t * target = graph_get_node_by_value(this->graph, &value);
+        path_t * expected = graph_get_path(this->graph, node0, target);
+        path_t * path = graph_spt_get_path(spt, target);
+        ASSERT_NE(expected, nullptr);
+        ASSERT_NE(path, nullptr);
+        EXPECT_TRUE(graph_spt_reachable(spt, target));
+        EXPECT_EQ(expected->path_weight, path->path_weight);
+        EXPECT_EQ(expected->path_weight, graph_spt_get_distance(spt, target));
+        EXPECT_EQ(expected->path_weight, graph_spt_get_distance(csr_spt, target));
+
+        EXPECT_EQ(dlist_get_length(expected->path), dlist_get_length(path->path));
+        dnode_t * expected_link = dlist_get_head_node(expected->path);
+        dnode_t * link = dlist_get_head_node(path->path);
+        while ((NULL != expected_link) && (NULL != link))
+        {
+            EXPECT_EQ(expected_link->data, link->data);
+            expected_link = expected_link->next;
+            link = link->next;
+        }
+
+        graph_free_path(expected);
+        graph_free_path(path);
+    }
+
+    // A node that is not in the graph can not be reached
+    int missing_value = this->safe_test_value1;
+    gnode_t * missing = graph_create_node(&missing_value);
+    EXPECT_FALSE(graph_spt_reachable(spt, missing));
+    EXPECT_EQ(nullptr, graph_spt_get_path(spt, missing));
+    graph_destroy_node(missing, nullptr);
+
+    graph_spt_destroy(csr_spt);
+    graph_csr_destroy(csr);
+    graph_spt_destroy(spt);
+}
+
+// Test that a batch of queries run on several threads returns the same paths
+// as graph_get_path
+TEST_F(GraphDlistFixture, TestCsrPathBatch)
+{
+    graph_csr_t * csr = graph_csr_freeze(this->graph);
+    ASSERT_NE(csr, nullptr);
+
+    std::vector<graph_query_t> queries;
+    for (auto & source_value : this->graph_data)
+    {
+        for (auto & target_value : this->graph_data)
+        {
+            graph_query_t query = {
+                graph_get_node_by_value(this->graph, &source_value),
+                graph_get_node_by_value(this->graph, &target_value)
+            };
+            queries.push_back(query);
+        }
+    }
+
+    // A query with a node that is not in the graph has no path
+    int missing_value = this->safe_test_value1;
+    gnode_t * missing = graph_create_node(&missing_value);
+    graph_query_t missing_query = {queries.at(0).source_node, missing};
+    queries.push_back(missing_query);
+
+    std::vector<path_t *> paths(queries.size());
+    size_t found = graph_csr_get_paths(csr, queries.data(), queries.size(), paths.data(), 4);
+    EXPECT_EQ(queries.size() - 1, found);
+    EXPECT_EQ(nullptr, paths.back());
+
+    for (size_t index = 0; index < queries.size() - 1; index++)
+    {
+        path_t * expected = graph_get_path(this->graph,
+                                           queries.at(index).source_node,
+                                           queries.at(index).target_node);
+        ASSERT_NE(expected, nullptr);
+        ASSERT_NE(paths.at(index), nullptr);
+        EXPECT_EQ(expected->path_weight, paths.at(index)->path_weight);
+        path_t * both_path = graph_get_path_bidirectional(this->graph,
+                                                          queries.at(index).source_node,
+                                                          queries.at(index).target_node);
+        ASSERT_NE(both_path, nullptr);
+        EXPECT_EQ(expected->path_weight, both_path->path_weight);
+        graph_free_path(both_path);
+        EXPECT_EQ(queries.at(index).target_node,
+                  dlist_get_tail_node(paths.at(index)->path)->data);
+        graph_free_path(expected);
+        graph_free_path(paths.at(index));
+    }
+
+    graph_destroy_node(missing, nullptr);
+    graph_csr_destroy(csr);
+}
+
+// Manhattan distance between two cells of the grid, ctx holds the width
+static uint64_t grid_heuristic(gnode_t * node, gnode_t * target_node, void * ctx)
+{
+    int width = *(int *)ctx;
+    int cell = *(int *)graph_get_node_value(node);
+    int target = *(int *)graph_get_node_value(target_node);
+    return (uint64_t)(abs((cell % width) - (target % width))
+                      + abs((cell / width) - (target / width)));
+}
+
+// Test that A* with an admissible heuristic finds paths as short as dijkstra
+TEST(GraphBasic, TestAstarPath)
+{
+    graph_t * graph = graph_init(GRAPH_UNDIRECTED, compare_payloads, hash_callback);
+    int width = 20;
+    std::vector<gnode_t *> nodes;
+    for (int cell = 0; cell < width * width; cell++)
+    {
+        graph_add_value(graph, get_payload(cell));
+        nodes.push_back(graph_get_node_by_value(graph, &cell));
+    }
+
+    // Every move costs at least 1 so the manhattan distance is admissible
+    std::mt19937 rng(5);
+    for (int cell = 0; cell < width * width; cell++)
+    {
+        if (0 != ((cell + 1) % width))
+        {
+            graph_add_edge(graph, nodes[cell], nodes[cell + 1], 1 + (uint32_t)(rng() % 9));
+            graph_add_edge(graph, nodes[cell + 1], nodes[cell], 1 + (uint32_t)(rng() % 9));
+        }
+        if (cell + width < width * width)
+        {
+            graph_add_edge(graph, nodes[cell], nodes[cell + width], 1 + (uint32_t)(rng() % 9));
+            graph_add_edge(graph, nodes[cell + width], nodes[cell], 1 + (uint32_t)(rng() % 9));
+        }
+    }
+
+    for (int query = 0; query < 50; query++)
+    {
+        gnode_t * source = nodes[rng() % nodes.size()];
+        gnode_t * target = nodes[rng() % nodes.size()];
+        path_t * expected = graph_get_path(graph, source, target);
+        path_t * path = graph_get_path_astar(graph, source, target, grid_heuristic, &width);
+        ASSERT_NE(expected, nullptr);
+        ASSERT_NE(path, nullptr);
+        EXPECT_EQ(expected->path_weight, path->path_weight);
+        EXPECT_EQ(source, dlist_get_head_node(path->path)->data);
+        EXPECT_EQ(target, dlist_get_tail_node(path->path)->data);
+        graph_free_path(expected);
+        graph_free_path(path);
+    }
+
+    // A target behind a one way edge can not be reached
+    graph_t * one_way = graph_init(GRAPH_UNDIRECTED, compare_payloads, hash_callback);
+    graph_add_value(one_way, get_payload(0));
+    graph_add_value(one_way, get_payload(1));
+    int first = 0;
+    int second = 1;
+    graph_add_edge(one_way,
+                   graph_get_node_by_value(one_way, &first),
+                   graph_get_node_by_value(one_way, &second),
+                   1);
+    EXPECT_EQ(nullptr, graph_get_path_astar(one_way,
+                                            graph_get_node_by_value(one_way, &second),
+                                            graph_get_node_by_value(one_way, &first),
+                                            grid_heuristic,
+                                            &width));
+
+    graph_destroy(one_way, free_payload);
+    graph_destroy(graph, free_payload);
+}
+
+// Test that removing a node of a one way graph also removes the edges that
+// only lead to it
+TEST(GraphBasic, TestRemoveNodeInEdges)
+{
+    graph_t * graph = graph_init(GRAPH_UNDIRECTED, compare_payloads, hash_callback);
+    std::vector<gnode_t *> nodes;
+    for (int value = 0; value < 4; value++)
+    {
+        graph_add_value(graph, get_payload(value));
+        nodes.push_back(graph_get_node_by_value(graph, &value));
+    }
+    graph_add_edge(graph, nodes[0], nodes[1], 1);
+    graph_add_edge(graph, nodes[2], nodes[1], 1);
+    graph_add_edge(graph, nodes[1], nodes[3], 1);
+    graph_add_edge(graph, nodes[0], nodes[3], 5);
+
+    path_t * path = graph_get_path_bidirectional(graph, nodes[0], nodes[3]);
+    ASSERT_NE(path, nullptr);
+    EXPECT_EQ(2, path->path_weight);
+    EXPECT_EQ(3, dlist_get_length(path->path));
+    graph_free_path(path);
+
+    EXPECT_EQ(GRAPH_SUCCESS, graph_remove_node(graph, nodes[1], free_payload));
+    EXPECT_EQ(1, graph_edge_count(nodes[0]));
+    EXPECT_EQ(0, graph_edge_count(nodes[2]));
+
+    path = graph_get_path_bidirectional(graph, nodes[0], nodes[3]);
+    ASSERT_NE(path, nullptr);
+    EXPECT_EQ(5, path->path_weight);
+    graph_free_path(path);
+    EXPECT_EQ(nullptr, graph_get_path_bidirectional(graph, nodes[3], nodes[0]));
+
+    graph_destroy(graph, free_payload);
+}
+
+// Test that removing many nodes from both graph modes leaves no edge that
+// leads to a removed node
+TEST(GraphBasic, TestNodeChurn)
+{
+    graph_mode_t modes[] = {GRAPH_DIRECTED, GRAPH_UNDIRECTED};
+    for (graph_mode_t mode : modes)
+    {
+        graph_t * graph = graph_init(mode, compare_payloads, hash_callback);
+        int node_count = 300;
+        std::vector<gnode_t *> nodes;
+        for (int value = 0; value < node_count; value++)
+        {
+            graph_add_value(graph, get_payload(value));
+            nodes.push_back(graph_get_node_by_value(graph, &value));
+        }
+
+        // A few hubs push some nodes over the edge index degree
+        std::mt19937 rng(3);
+        for (int index = 0; index < node_count * 6; index++)
+        {
+            size_t source = (0 == index % 4) ? rng() % 5 : rng() % nodes.size();
+            size_t target = rng() % nodes.size();
+            graph_add_edge(graph, nodes[source], nodes[target], 1 + (uint32_t)(rng() % 9));
+        }
+
+        std::shuffle(nodes.begin(), nodes.end(), rng);
+        while (nodes.size() > (size_t)node_count / 3)
+        {
+            EXPECT_EQ(GRAPH_SUCCESS, graph_remove_node(graph, nodes.back(), free_payload));
+            nodes.pop_back();
+        }
+        EXPECT_EQ(nodes.size(), graph_node_count(graph));
+
+        size_t edge_count = 0;
+        for (gnode_t * node : nodes)
+        {
+            dlist_iter_t * neighbors = graph_get_neighbors_list(node);
+            edge_t * edge = (edge_t *)iter_get_value(neighbors);
+            while (NULL != edge)
+            {
+                EXPECT_TRUE(graph_node_in_graph(graph, edge->to_node));
+                EXPECT_EQ(edge, graph_get_edge(graph, node, edge->to_node));
+                if (GRAPH_DIRECTED == mode)
+                {
+                    EXPECT_NE(nullptr, graph_get_edge(graph, edge->to_node, node));
+                }
+                edge = (edge_t *)dlist_get_iter_next(neighbors);
+                edge_count++;
+            }
+            graph_destroy_neighbors_list(neighbors);
+        }
+
+        graph_csr_t * csr = graph_csr_freeze(graph);
+        ASSERT_NE(csr, nullptr);
+        EXPECT_EQ(edge_count, graph_csr_total_edges(csr));
+        graph_csr_destroy(csr);
+        graph_destroy(graph, free_payload);
+    }
+}
+
+// Test that a bulk load gives the same graph as adding the edges one by one
+TEST(GraphBasic, TestBuildFromEdges)
+{
+    graph_mode_t modes[] = {GRAPH_DIRECTED, GRAPH_UNDIRECTED};
+    for (graph_mode_t mode : modes)
+    {
+        int node_count = 120;
+        std::vector<int *> values;
+        for (int value = 0; value < node_count; value++)
+        {
+            values.push_back(get_payload(value));
+        }
+
+        // Many duplicates and a few self loops
+        std::mt19937 rng(17);
+        std::vector<graph_edge_input_t> edges;
+        for (int index = 0; index < node_count * 8; index++)
+        {
+            graph_edge_input_t edge = {
+                values[rng() % 60],
+                values[rng() % values.size()],
+                (uint32_t)(rng() % 50)
+            };
+            edges.push_back(edge);
+        }
+
+        graph_t * bulk = graph_build_from_edges(mode, edges.data(), edges.size(),
+                                                compare_payloads, hash_callback);
+        ASSERT_NE(bulk, nullptr);
+
+        graph_t * graph = graph_init(mode, compare_payloads, hash_callback);
+        for (graph_edge_input_t & edge : edges)
+        {
+            if (!graph_value_in_graph(graph, edge.source_value))
+            {
+                graph_add_value(graph, edge.source_value);
+            }
+            if (!graph_value_in_graph(graph, edge.target_value))
+            {
+                graph_add_value(graph, edge.target_value);
+            }
+            graph_add_edge(graph,
+                           graph_get_node_by_value(graph, edge.source_value),
+                           graph_get_node_by_value(graph, edge.target_value),
+                           edge.weight);
+        }
+
+        // Values that never appear in an edge are in neither graph
+        ASSERT_EQ(graph_node_count(graph), graph_node_count(bulk));
+        for (int * value : values)
+        {
+            gnode_t * node = graph_get_node_by_value(graph, value);
+            gnode_t * bulk_node = graph_get_node_by_value(bulk, value);
+            ASSERT_EQ(node == nullptr, bulk_node == nullptr);
+            if (nullptr == node)
+            {
+                continue;
+            }
+            EXPECT_EQ(graph_edge_count(node), graph_edge_count(bulk_node));
+
+            dlist_iter_t * neighbors = graph_get_neighbors_list(node);
+            edge_t * edge = (edge_t *)iter_get_value(neighbors);
+            while (NULL != edge)
+            {
+                edge_t * bulk_edge = graph_get_edge(bulk, bulk_node, edge->to_node);
+                ASSERT_NE(bulk_edge, nullptr);
+                EXPECT_EQ(edge->weight, bulk_edge->weight);
+                edge = (edge_t *)dlist_get_iter_next(neighbors);
+            }
+            graph_destroy_neighbors_list(neighbors);
+        }
+
+        graph_destroy(graph, nullptr);
+        graph_destroy(bulk, nullptr);
+        for (int * value : values)
+        {
+            free_payload(value);
+        }
+    }
+
+    graph_t * empty = graph_build_from_edges(GRAPH_DIRECTED, nullptr, 0,
+                                             compare_payloads, hash_callback);
+    ASSERT_NE(empty, nullptr);
+    EXPECT_EQ(0, graph_node_count(empty));
+    graph_destroy(empty, nullptr);
+}
+
+// Writes the int payload of a node into its file record
+static void write_payload(void * data, void * record)
+{
+    memcpy(record, data, sizeof(int));
+}
+
+// Test that a snapshot written to a file maps back with the same nodes,
+// edges and paths
+TEST_F(GraphDlistFixture, TestCsrFile)
+{
+    graph_csr_t * csr = graph_csr_freeze(this->graph);
+    ASSERT_NE(csr, nullptr);
+    std::string file_path = testing::TempDir() + "graph_dlist_csr.bin";
+    ASSERT_TRUE(graph_csr_write(csr, file_path.c_str(), sizeof(int), write_payload));
+
+    graph_csr_t * mapped = graph_csr_map(file_path.c_str(), compare_payloads);
+    ASSERT_NE(mapped, nullptr);
+    ASSERT_EQ(graph_csr_node_count(csr), graph_csr_node_count(mapped));
+    ASSERT_EQ(graph_csr_total_edges(csr), graph_csr_total_edges(mapped));
+
+    for (size_t id = 0; id < graph_csr_node_count(csr); id++)
+    {
+        EXPECT_EQ(*(int *)graph_get_node_value(graph_csr_get_node(csr, id)),
+                  *(int *)graph_get_node_value(graph_csr_get_node(mapped, id)));
+
+        const uint32_t * targets;
+        const uint32_t * weights;
+        const uint32_t * mapped_targets;
+        const uint32_t * mapped_weights;
+        size_t degree = graph_csr_get_neighbors(csr, id, &targets, &weights);
+        ASSERT_EQ(degree, graph_csr_get_neighbors(mapped, id, &mapped_targets, &mapped_weights));
+        for (size_t index = 0; index < degree; index++)
+        {
+            EXPECT_EQ(targets[index], mapped_targets[index]);
+            EXPECT_EQ(weights[index], mapped_weights[index]);
+        }
+    }
+
+    // Nodes of the original graph are matched to the mapped nodes by value
+    gnode_t * node0 = graph_get_node_by_value(this->graph, &this->graph_data.at(0));
+    gnode_t * node7 = graph_get_node_by_value(this->graph, &this->graph_data.at(7));
+    path_t * path = graph_csr_get_path(mapped, node0, node7);
+    ASSERT_NE(path, nullptr);
+    EXPECT_EQ(9, path->path_weight);
+    std::vector<int> expected = {0, 1, 4, 8, 7};
+    dnode_t * link = dlist_get_head_node(path->path);
+    for (int value : expected)
+    {
+        ASSERT_NE(link, nullptr);
+        EXPECT_EQ(value, *(int *)graph_get_node_value((gnode_t *)link->data));
+        link = link->next;
+    }
+    graph_free_path(path);
+
+    // A file of the right size with an edge outside of the snapshot or
+    // offsets that shrink is rejected. The sections follow the 40 byte header
+    // and start on multiples of 8
+    size_t node_count = graph_csr_node_count(csr);
+    size_t offsets_start = (40 + node_count * sizeof(int) + 7) & ~(size_t)7;
+    size_t targets_start = (offsets_start + (node_count + 1) * sizeof(uint64_t) + 7) & ~(size_t)7;
+    auto patch_file = [&](size_t position, void * bytes, size_t size, bool read_back) {
+        FILE * patched = fopen(file_path.c_str(), "r+b");
+        ASSERT_NE(patched, nullptr);
+        fseek(patched, (long)position, SEEK_SET);
+        if (read_back)
+        {
+            ASSERT_EQ(1, fread(bytes, size, 1, patched));
+        }
+        else
+        {
+            fwrite(bytes, size, 1, patched);
+        }
+        fclose(patched);
+    };
+    uint32_t first_target = 0;
+    patch_file(targets_start, &first_target, sizeof(first_target), true);
+    ASSERT_LT(first_target, node_count);
+    uint32_t bad_target = (uint32_t)node_count;
+    patch_file(targets_start, &bad_target, sizeof(bad_target), false);
+    EXPECT_EQ(nullptr, graph_csr_map(file_path.c_str(), compare_payloads));
+    patch_file(targets_start, &first_target, sizeof(first_target), false);
+    graph_csr_t * restored = graph_csr_map(file_path.c_str(), compare_payloads);
+    ASSERT_NE(restored, nullptr);
+    graph_csr_destroy(restored);
+
+    uint64_t bad_offset = graph_csr_total_edges(csr) + 1;
+    patch_file(offsets_start + sizeof(uint64_t), &bad_offset, sizeof(bad_offset), false);
+    EXPECT_EQ(nullptr, graph_csr_map(file_path.c_str(), compare_payloads));
+
+    graph_csr_destroy(mapped);
+    graph_csr_destroy(csr);
+
+    // A file that is not a graph file is rejected
+    FILE * file = fopen(file_path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    fputs("not a graph", file);
+    fclose(file);
+    EXPECT_EQ(nullptr, graph_csr_map(file_path.c_str(), compare_payloads));
+    remove(file_path.c_str());
+}
+
+// Test that the breadth first search finds the same hops as a plain queue
+// based search, with and without threads and on the snapshot
+TEST(GraphBasic, TestBfs)
+{
+    graph_mode_t modes[] = {GRAPH_DIRECTED, GRAPH_UNDIRECTED};
+    for (graph_mode_t mode : modes)
+    {
+        // Dense enough for the search to switch to bottom up steps, the last
+        // nodes are never a target
+        size_t node_count = 3000;
+        random_graph_t random_graph = create_random_graph(mode, node_count, node_count * 10, 23,
+                                                          node_count - 100);
+        graph_t * graph = random_graph.graph;
+        std::vector<gnode_t *> & nodes = random_graph.nodes;
+        std::vector<std::vector<size_t>> adjacency(node_count);
+        for (auto & [source, target, weight] : random_graph.edges)
+        {
+            adjacency[source].push_back(target);
+            if (GRAPH_DIRECTED == mode)
+            {
+                adjacency[target].push_back(source);
+            }
+        }
+
+        std::vector<size_t> expected(node_count, GRAPH_UNREACHABLE);
+        std::vector<size_t> queue = {0};
+        expected[0] = 0;
+        for (size_t index = 0; index < queue.size(); index++)
+        {
+            for (size_t neighbor : adjacency[queue[index]])
+            {
+                if (GRAPH_UNREACHABLE == expected[neighbor])
+                {
+                    expected[neighbor] = expected[queue[index]] + 1;
+                    queue.push_back(neighbor);
+                }
+            }
+        }
+
+        graph_csr_t * csr = graph_csr_freeze(graph);
+        ASSERT_NE(csr, nullptr);
+        graph_bfs_t * results[] = {
+            graph_bfs(graph, nodes[0], 1),
+            graph_bfs(graph, nodes[0], 4),
+            graph_csr_bfs(csr, nodes[0], 4)
+        };
+        for (graph_bfs_t * bfs : results)
+        {
+            ASSERT_NE(bfs, nullptr);
+            EXPECT_EQ(queue.size(), graph_bfs_reached_count(bfs));
+            EXPECT_EQ(nullptr, graph_bfs_get_parent(bfs, nodes[0]));
+            for (size_t id = 0; id < node_count; id++)
+            {
+                size_t hops = graph_bfs_get_hops(bfs, nodes[id]);
+                ASSERT_EQ(expected[id], hops);
+                if ((0 == hops) || (GRAPH_UNREACHABLE == hops))
+                {
+                    continue;
+                }
+
+                // The parent is one hop closer and has an edge to the node
+                gnode_t * parent = graph_bfs_get_parent(bfs, nodes[id]);
+                ASSERT_NE(parent, nullptr);
+                EXPECT_EQ(hops - 1, graph_bfs_get_hops(bfs, parent));
+                EXPECT_NE(nullptr, graph_get_edge(graph, parent, nodes[id]));
+            }
+            graph_bfs_destroy(bfs);
+        }
+
+        graph_csr_destroy(csr);
+        graph_destroy(graph, free_payload);
+    }
+}
+
+// Test that the component labels match the components found with a search
+// that follows the edges both ways
+TEST(GraphBasic, TestConnectedComponents)
+{
+    graph_mode_t modes[] = {GRAPH_DIRECTED, GRAPH_UNDIRECTED};
+    for (graph_mode_t mode : modes)
+    {
+        // Sparse enough to leave many components
+        size_t node_count = 5000;
+        random_graph_t random_graph = create_random_graph(mode, node_count, node_count / 2, 29);
+        graph_t * graph = random_graph.graph;
+        std::vector<gnode_t *> & nodes = random_graph.nodes;
+        std::vector<std::vector<size_t>> adjacency(node_count);
+        for (auto & [source, target, weight] : random_graph.edges)
+        {
+            adjacency[source].push_back(target);
+            adjacency[target].push_back(source);
+        }
+
+        std::vector<size_t> expected(node_count, GRAPH_NO_ID);
+        size_t expected_count = 0;
+        for (size_t root = 0; root < node_count; root++)
+        {
+            if (GRAPH_NO_ID != expected[root])
+            {
+                continue;
+            }
+            std::vector<size_t> queue = {root};
+            expected[root] = expected_count;
+            for (size_t index = 0; index < queue.size(); index++)
+            {
+                for (size_t neighbor : adjacency[queue[index]])
+                {
+                    if (GRAPH_NO_ID == expected[neighbor])
+                    {
+                        expected[neighbor] = expected_count;
+                        queue.push_back(neighbor);
+                    }
+                }
+            }
+            expected_count++;
+        }
+
+        graph_csr_t * csr = graph_csr_freeze(graph);
+        ASSERT_NE(csr, nullptr);
+        graph_components_t * results[] = {
+            graph_connected_components(graph, 1),
+            graph_connected_components(graph, 4),
+            graph_csr_connected_components(csr, 4)
+        };
+        for (graph_components_t * components : results)
+        {
+            ASSERT_NE(components, nullptr);
+            ASSERT_EQ(expected_count, graph_components_count(components));
+
+            // Both searches number the components by their smallest id
+            std::vector<size_t> sizes(expected_count, 0);
+            for (size_t id = 0; id < node_count; id++)
+            {
+                ASSERT_EQ(expected[id], graph_components_get_label(components, nodes[id]));
+                sizes[expected[id]]++;
+            }
+            for (size_t label = 0; label < expected_count; label++)
+            {
+                EXPECT_EQ(sizes[label], graph_components_get_size(components, label));
+            }
+            graph_components_destroy(components);
+        }
+
+        graph_csr_destroy(csr);
+        graph_destroy(graph, free_payload);
+    }
+}
+
+// Test that nodes share a strong component label exactly when they reach each
+// other and that the labels follow the edges
+TEST(GraphBasic, TestStrongComponents)
+{
+    size_t node_count = 150;
+    random_graph_t random_graph = create_random_graph(GRAPH_UNDIRECTED, node_count,
+                                                      node_count + node_count / 5, 31);
+    graph_t * graph = random_graph.graph;
+    std::vector<gnode_t *> & nodes = random_graph.nodes;
+    std::vector<std::vector<bool>> reach(node_count, std::vector<bool>(node_count, false));
+    for (auto & [source, target, weight] : random_graph.edges)
+    {
+        reach[source][target] = true;
+    }
+    for (size_t id = 0; id < node_count; id++)
+    {
+        reach[id][id] = true;
+    }
+    for (size_t middle = 0; middle < node_count; middle++)
+    {
+        for (size_t source = 0; source < node_count; source++)
+        {
+            for (size_t target = 0; target < node_count; target++)
+            {
+                if (reach[source][middle] && reach[middle][target])
+                {
+                    reach[source][target] = true;
+                }
+            }
+        }
+    }
+
+    graph_components_t * components = graph_strongly_connected_components(graph);
+    ASSERT_NE(components, nullptr);
+    for (size_t source = 0; source < node_count; source++)
+    {
+        size_t label = graph_components_get_label(components, nodes[source]);
+        for (size_t target = 0; target < node_count; target++)
+        {
+            size_t target_label = graph_components_get_label(components, nodes[target]);
+            EXPECT_EQ(reach[source][target] && reach[target][source], label == target_label);
+            if (graph_node_a_neighbor(nodes[source], nodes[target]))
+            {
+                EXPECT_LE(label, target_label);
+            }
+        }
+    }
+    graph_components_destroy(components);
+    graph_destroy(graph, free_payload);
+}
+
+// Test the topological sort and the strong components on a chain that would
+// be too deep for a recursive search
+TEST(GraphBasic, TestTopologicalSort)
+{
+    graph_t * graph = graph_init(GRAPH_UNDIRECTED, compare_payloads, hash_callback);
+    size_t node_count = 100000;
+    std::vector<gnode_t *> nodes;
+    for (size_t value = 0; value < node_count; value++)
+    {
+        graph_add_value(graph, get_payload((int)value));
+        int key = (int)value;
+        nodes.push_back(graph_get_node_by_value(graph, &key));
+    }
+
+    // The chain runs from the last id to the first
+    for (size_t id = node_count - 1; id > 0; id--)
+    {
+        graph_add_edge(graph, nodes[id], nodes[id - 1], NO_WEIGHT);
+    }
+
+    dlist_t * sorted = graph_topological_sort(graph);
+    ASSERT_NE(sorted, nullptr);
+    ASSERT_EQ(node_count, dlist_get_length(sorted));
+    size_t expected = node_count;
+    for (dnode_t * link = dlist_get_head_node(sorted); NULL != link; link = link->next)
+    {
+        EXPECT_EQ(nodes[--expected], link->data);
+    }
+    dlist_destroy(sorted);
+
+    graph_components_t * components = graph_strongly_connected_components(graph);
+    ASSERT_NE(components, nullptr);
+    EXPECT_EQ(node_count, graph_components_count(components));
+    EXPECT_EQ(0, graph_components_get_label(components, nodes[node_count - 1]));
+    graph_components_destroy(components);
+
+    // Closing the chain into a cycle leaves no order and a single component
+    graph_add_edge(graph, nodes[0], nodes[node_count - 1], NO_WEIGHT);
+    EXPECT_EQ(nullptr, graph_topological_sort(graph));
+    components = graph_strongly_connected_components(graph);
+    ASSERT_NE(components, nullptr);
+    EXPECT_EQ(1, graph_components_count(components));
+    EXPECT_EQ(node_count, graph_components_get_size(components, 0));
+    graph_components_destroy(components);
+
+    graph_destroy(graph, free_payload);
+}
+
+// Root of the set holding the id in a plain union-find used as a reference
+static size_t find_set(std::vector<size_t> & parents, size_t id)
+{
+    while (parents[id] != id)
+    {
+        id = parents[id] = parents[parents[id]];
+    }
+    return id;
+}
+
+// Test that Kruskal and Prim find forests with the weight of a plain Kruskal
+// over the same edges, in both graph modes
+TEST(GraphBasic, TestMinimumSpanningForest)
+{
+    graph_mode_t modes[] = {GRAPH_DIRECTED, GRAPH_UNDIRECTED};
+    for (graph_mode_t mode : modes)
+    {
+        // Enough edges for the parallel sort, a few nodes stay isolated
+        size_t node_count = 20000;
+        random_graph_t random_graph = create_random_graph(mode, node_count, node_count * 3, 31, 0, 1000);
+        graph_t * graph = random_graph.graph;
+        std::vector<std::tuple<uint32_t, size_t, size_t>> edges;
+        for (auto & [source, target, weight] : random_graph.edges)
+        {
+            edges.emplace_back(weight, source, target);
+        }
+
+        // Reference forest from a plain Kruskal over the accepted edges
+        std::sort(edges.begin(), edges.end());
+        std::vector<size_t> parents(node_count);
+        for (size_t id = 0; id < node_count; id++)
+        {
+            parents[id] = id;
+        }
+        uint64_t expected_weight = 0;
+        size_t expected_edges = 0;
+        for (auto & [weight, source, target] : edges)
+        {
+            size_t source_root = find_set(parents, source);
+            size_t target_root = find_set(parents, target);
+            if (source_root != target_root)
+            {
+                parents[target_root] = source_root;
+                expected_weight += weight;
+                expected_edges++;
+            }
+        }
+
+        graph_mst_t * results[] = {
+            graph_mst_kruskal(graph, 1),
+            graph_mst_kruskal(graph, 4),
+            graph_mst_prim(graph)
+        };
+        for (graph_mst_t * mst : results)
+        {
+            ASSERT_NE(mst, nullptr);
+            EXPECT_EQ(expected_weight, mst->total_weight);
+            ASSERT_EQ(expected_edges, mst->edge_count);
+
+            // The edges belong to the graph and never close a cycle
+            for (size_t id = 0; id < node_count; id++)
+            {
+                parents[id] = id;
+            }
+            uint64_t total_weight = 0;
+            for (size_t index = 0; index < mst->edge_count; index++)
+            {
+                edge_t * edge = mst->edges[index];
+                ASSERT_TRUE(graph_edge_in_graph(graph, edge));
+                size_t source_root = find_set(parents, graph_get_node_id(edge->from_node));
+                size_t target_root = find_set(parents, graph_get_node_id(edge->to_node));
+                ASSERT_NE(source_root, target_root);
+                parents[target_root] = source_root;
+                total_weight += edge->weight;
+            }
+            EXPECT_EQ(expected_weight, total_weight);
+            graph_free_mst(mst);
+        }
+
+        graph_destroy(graph, free_payload);
+    }
+
+    graph_t * graph = graph_init(GRAPH_DIRECTED, compare_payloads, hash_callback);
+    graph_mst_t * mst = graph_mst_prim(graph);
+    ASSERT_NE(mst, nullptr);
+    EXPECT_EQ(0, mst->edge_count);
+    graph_free_mst(mst);
+    graph_destroy(graph, free_payload);
+}
+
+// Test that the PageRank of a snapshot matches a plain push based power
+// iteration and does not depend on the number of threads
+TEST(GraphBasic, TestPageRank)
+{
+    graph_mode_t modes[] = {GRAPH_DIRECTED, GRAPH_UNDIRECTED};
+    for (graph_mode_t mode : modes)
+    {
+        // Sparse enough to leave nodes without out edges
+        size_t node_count = 10000;
+        random_graph_t random_graph = create_random_graph(mode, node_count, node_count * 2, 37);
+        graph_t * graph = random_graph.graph;
+        std::vector<gnode_t *> & nodes = random_graph.nodes;
+        std::vector<std::vector<size_t>> adjacency(node_count);
+        for (auto & [source, target, weight] : random_graph.edges)
+        {
+            adjacency[source].push_back(target);
+            if ((GRAPH_DIRECTED == mode) && (source != target))
+            {
+                adjacency[target].push_back(source);
+            }
+        }
+
+        // Reference push based power iteration
+        double damping = 0.85;
+        std::vector<double> expected(node_count, 1.0 / (double)node_count);
+        for (size_t iteration = 0; iteration < 200; iteration++)
+        {
+            std::vector<double> next(node_count, 0.0);
+            double dangling = 0.0;
+            for (size_t id = 0; id < node_count; id++)
+            {
+                if (adjacency[id].empty())
+                {
+                    dangling += expected[id];
+                    continue;
+                }
+                for (size_t target : adjacency[id])
+                {
+                    next[target] += expected[id] / (double)adjacency[id].size();
+                }
+            }
+            for (size_t id = 0; id < node_count; id++)
+            {
+                next[id] = (1.0 - damping + damping * dangling) / (double)node_count
+                           + damping * next[id];
+            }
+            expected = next;
+        }
+
+        graph_csr_t * csr = graph_csr_freeze(graph);
+        ASSERT_NE(csr, nullptr);
+        graph_rank_t * serial = graph_csr_pagerank(csr, damping, 1e-12, 200, 1);
+        graph_rank_t * parallel = graph_csr_pagerank(csr, damping, 1e-12, 200, 4);
+        ASSERT_NE(serial, nullptr);
+        ASSERT_NE(parallel, nullptr);
+        EXPECT_TRUE(graph_rank_converged(serial));
+        EXPECT_EQ(graph_rank_iterations(serial), graph_rank_iterations(parallel));
+
+        double total = 0.0;
+        for (size_t id = 0; id < node_count; id++)
+        {
+            double score = graph_rank_get_score(serial, nodes[id]);
+            EXPECT_NEAR(expected[id], score, 1e-9);
+            EXPECT_EQ(score, graph_rank_get_score(parallel, nodes[id]));
+            total += score;
+        }
+        EXPECT_NEAR(1.0, total, 1e-9);
+        graph_rank_destroy(serial);
+        graph_rank_destroy(parallel);
+
+        // A single iteration stops short of the tolerance
+        graph_rank_t * rank = graph_csr_pagerank(csr, damping, 1e-12, 1, 4);
+        ASSERT_NE(rank, nullptr);
+        EXPECT_FALSE(graph_rank_converged(rank));
+        EXPECT_EQ(1, graph_rank_iterations(rank));
+        graph_rank_destroy(rank);
+        EXPECT_EQ(nullptr, graph_csr_pagerank(csr, 1.5, 1e-12, 1, 1));
+
+        graph_csr_destroy(csr);
+        graph_destroy(graph, free_payload);
+    }
+}
+
+// Test that the paths of the contraction hierarchy weigh the same as the paths
+// of graph_get_path and unpack into edges of the graph
+TEST(GraphBasic, TestContractionHierarchy)
+{
+    graph_mode_t modes[] = {GRAPH_DIRECTED, GRAPH_UNDIRECTED};
+    for (graph_mode_t mode : modes)
+    {
+        int width = 40;
+        random_graph_t random_graph = create_random_graph(mode, (size_t)(width * width + 1), 0, 0);
+        graph_t * graph = random_graph.graph;
+        std::vector<gnode_t *> & nodes = random_graph.nodes;
+
+        // Road like grid where some streets are one way, the last node is
+        // left unreachable
+        std::mt19937 rng(41);
+        for (int cell = 0; cell < width * width; cell++)
+        {
+            int neighbors[] = {cell + 1, cell + width};
+            for (int neighbor : neighbors)
+            {
+                if ((neighbor >= width * width)
+                    || ((neighbor == cell + 1) && (0 == neighbor % width)))
+                {
+                    continue;
+                }
+                graph_add_edge(graph, nodes[cell], nodes[neighbor], 1 + (uint32_t)(rng() % 20));
+                if (0 != rng() % 4)
+                {
+                    graph_add_edge(graph, nodes[neighbor], nodes[cell], 1 + (uint32_t)(rng() % 20));
+                }
+            }
+        }
+
+        graph_ch_t * ch = graph_ch_build(graph);
+        ASSERT_NE(ch, nullptr);
+        for (int query = 0; query < 300; query++)
+        {
+            gnode_t * source = nodes[rng() % nodes.size()];
+            gnode_t * target = nodes[rng() % nodes.size()];
+            path_t * expected = graph_get_path(graph, source, target);
+            path_t * path = graph_ch_get_path(ch, source, target);
+            if (nullptr == expected)
+            {
+                EXPECT_EQ(nullptr, path);
+                continue;
+            }
+            ASSERT_NE(path, nullptr);
+            EXPECT_EQ(expected->path_weight, path->path_weight);
+
+            // The shortcuts are unpacked into edges of the graph
+            uint64_t weight = 0;
+            dnode_t * link = dlist_get_head_node(path->path);
+            EXPECT_EQ(source, link->data);
+            for (; NULL != link->next; link = link->next)
+            {
+                edge_t * edge = graph_get_edge(graph, (gnode_t *)link->data, (gnode_t *)link->next->data);
+                ASSERT_NE(edge, nullptr);
+                weight += edge->weight;
+            }
+            EXPECT_EQ(target, link->data);
+            EXPECT_EQ(path->path_weight, weight);
+            graph_free_path(expected);
+            graph_free_path(path);
+        }
+        EXPECT_EQ(nullptr, graph_ch_get_path(ch, nodes[0], nodes[width * width]));
+
+        graph_ch_destroy(ch);
+        graph_destroy(graph, free_payload);
+    }
+}
+
+// Test that pooled and malloced nodes can be mixed in one graph and that
+// removed nodes and edges are handed out again by the pools
+TEST(GraphBasic, TestPooledStorage)
+{
+    graph_mode_t modes[] = {GRAPH_DIRECTED, GRAPH_UNDIRECTED};
+    for (graph_mode_t mode : modes)
+    {
+        graph_t * graph = graph_init(mode, compare_payloads, hash_callback);
+
+        // Nodes added by value come from the pool of the graph while nodes
+        // created on their own are malloced, both are freed by the graph
+        std::vector<gnode_t *> nodes;
+        for (int value = 0; value < 1000; value++)
+        {
+            if (0 == value % 2)
+            {
+                graph_add_value(graph, get_payload(value));
+            }
+            else
+            {
+                ASSERT_EQ(GRAPH_SUCCESS, graph_add_node(graph, graph_create_node(get_payload(value))));
+            }
+            nodes.push_back(graph_get_node_by_value(graph, &value));
+        }
+        for (size_t id = 0; id + 1 < nodes.size(); id++)
+        {
+            graph_add_edge(graph, nodes[id], nodes[id + 1], (uint32_t)id);
+        }
+
+        // A removed edge is handed out again by the next insert
+        edge_t * removed = graph_get_edge(graph, nodes[10], nodes[11]);
+        ASSERT_EQ(GRAPH_SUCCESS, graph_remove_edge(graph, nodes[10], nodes[11]));
+        ASSERT_EQ(GRAPH_SUCCESS, graph_add_edge(graph, nodes[10], nodes[12], 7));
+        edge_t * added = graph_get_edge(graph, nodes[10], nodes[12]);
+        ASSERT_NE(added, nullptr);
+        if (GRAPH_UNDIRECTED == mode)
+        {
+            EXPECT_EQ(removed, added);
+        }
+        EXPECT_EQ(7, added->weight);
+        EXPECT_EQ(nodes[12], added->to_node);
+
+        // Removing and adding nodes of both kinds keeps the graph consistent
+        for (size_t id = 100; id < 200; id++)
+        {
+            ASSERT_EQ(GRAPH_SUCCESS, graph_remove_node(graph, nodes[id], free_payload));
+        }
+        for (int value = 100; value < 200; value++)
+        {
+            graph_add_value(graph, get_payload(value));
+            nodes[(size_t)value] = graph_get_node_by_value(graph, &value);
+            graph_add_edge(graph, nodes[(size_t)value], nodes[0], 1);
+        }
+        EXPECT_EQ(1000, graph_node_count(graph));
+        for (int value = 100; value < 200; value++)
+        {
+            EXPECT_TRUE(graph_node_a_neighbor(nodes[(size_t)value], nodes[0]));
+        }
+        path_t * path = graph_get_path(graph, nodes[150], nodes[50]);
+        ASSERT_NE(path, nullptr);
+        graph_free_path(path);
+
+        graph_destroy(graph, free_payload);
+    }
+}
+
+// Test that a large graph whose nodes, edges and dnodes come from the pools
+// is torn down in bulk without leaking the parts that are not pooled
+TEST(GraphBasic, TestPooledDestroy)
+{
+    graph_mode_t modes[] = {GRAPH_DIRECTED, GRAPH_UNDIRECTED};
+    for (graph_mode_t mode : modes)
+    {
+        int node_count = 2000;
+        std::vector<int *> values;
+        for (int value = 0; value < node_count; value++)
+        {
+            values.push_back(get_payload(value));
+        }
+
+        // A ring so every value is in the graph, then random edges
+        std::mt19937 rng(29);
+        std::vector<graph_edge_input_t> edges;
+        for (int value = 0; value < node_count; value++)
+        {
+            edges.push_back({values[(size_t)value], values[(size_t)((value + 1) % node_count)], 1});
+        }
+        for (int index = 0; index < 200000; index++)
+        {
+            edges.push_back({values[rng() % values.size()],
+                             values[rng() % values.size()],
+                             (uint32_t)(rng() % 100)});
+        }
+
+        graph_t * graph = graph_build_from_edges(mode, edges.data(), edges.size(),
+                                                 compare_payloads, hash_callback);
+        ASSERT_NE(graph, nullptr);
+        ASSERT_EQ(node_count, graph_node_count(graph));
+
+        // Release some blocks to the free lists and take some back, and add a
+        // malloced node with edges and an edge index
+        for (int value = 0; value < 50; value++)
+        {
+            ASSERT_EQ(GRAPH_SUCCESS, graph_remove_node(graph,
+                                                       graph_get_node_by_value(graph, values[(size_t)value]),
+                                                       free_payload));
+        }
+        gnode_t * extra = graph_create_node(get_payload(node_count));
+        ASSERT_EQ(GRAPH_SUCCESS, graph_add_node(graph, extra));
+        for (int value = 50; value < 150; value++)
+        {
+            gnode_t * node = graph_get_node_by_value(graph, values[(size_t)value]);
+            graph_add_edge(graph, extra, node, 3);
+            graph_add_edge(graph, node, extra, 3);
+        }
+        EXPECT_EQ(100, graph_edge_count(extra));
+
+        graph_destroy(graph, free_payload);
+    }
+}
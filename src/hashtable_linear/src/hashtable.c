@@ -301,8 +301,11 @@ void * htable_set(htable_t * table, void * key, void * value)
     assert(value != NULL);
     assert(table);
 
-    // Expand table if we exceed the halfway mark
-    if (table->slots_used >= table->capacity / 2)
+    // Expand table if we exceed the halfway mark. Dummy keys count towards
+    // the mark since they take up a slot until the next expansion, without
+    // them a table that churns keys fills up with dummies and probing for an
+    // empty slot never ends
+    if (table->slots_filled >= table->capacity / 2)
     {
         if (!expand(table))
         {
@@ -386,7 +389,9 @@ htable_entry_t * htable_iter_get_next(htable_iter_t * iter)
 
 /*!
  * @brief Expand the array using pythons strategy of
- * (slots_used * 2) + (capacity / 2)
+ * (slots_used * 2) + (capacity / 2). When most of the filled slots are dummy
+ * keys the strategy yields a smaller array, in that case the array keeps its
+ * capacity and is only rebuilt to drop the dummy keys.
  * @param table Pointer to the table structure
  * @return True indicating that the expansion was a success
  */
@@ -396,7 +401,7 @@ static bool expand(htable_t * table)
     size_t new_capacity = (table->slots_used * 2) + (table->capacity / 2);
     if (new_capacity < table->capacity)
     {
-        return false;
+        new_capacity = table->capacity;
     }
     htable_entry_t ** new_entries =
         (htable_entry_t **)calloc(new_capacity, sizeof(htable_entry_t *));
@@ -275,6 +275,29 @@ TEST(HashtableSoloTest, TestExpansion)
     htable_destroy(dict, HT_FREE_PTR_FALSE, HT_FREE_PTR_TRUE);
 }
 
+// Test that a table that keeps adding and removing keys does not fill up with
+// dummy keys
+TEST(HashtableSoloTest, TestChurn)
+{
+    htable_t * dict = htable_create(hash_callback,
+                         compare_callback,
+                         NULL,
+                         free_payload);
+
+    for (int count = 0; count < 1000; count++)
+    {
+        std::string key = "Key" + std::to_string(count);
+        test_struct_t * payload = get_payload(key.c_str(), count);
+        htable_set(dict, payload->payload, payload);
+        EXPECT_EQ(1, htable_get_length(dict));
+        EXPECT_LT(htable_get_slots(dict), 32);
+
+        free_payload(htable_del(dict, payload->payload, HT_FREE_PTR_FALSE));
+        EXPECT_EQ(0, htable_get_length(dict));
+    }
+
+    htable_destroy(dict, HT_FREE_PTR_FALSE, HT_FREE_PTR_TRUE);
+}
 
 // frees the payload inserted into the linked list
 void free_payload_dl(void * data)
@@ -0,0 +1,39 @@
+#include <bench_alloc.h>
+#include <stdatomic.h>
+
+// glibc exports its allocator under these names which lets the benchmark
+// replace malloc for the whole process, libstdc++ included, while still
+// handing the real work to glibc
+extern void * __libc_malloc(size_t size);
+extern void * __libc_calloc(size_t count, size_t size);
+extern void * __libc_realloc(void * ptr, size_t size);
+
+static atomic_uint_fast64_t alloc_count;
+
+void * malloc(size_t size)
+{
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void * calloc(size_t count, size_t size)
+{
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void * realloc(void * ptr, size_t size)
+{
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+/*!
+ * @brief Return the number of malloc, calloc and realloc calls made by the
+ * process so far
+ * @return Allocation count
+ */
+uint64_t bench_get_alloc_count(void)
+{
+    return (uint64_t)atomic_load_explicit(&alloc_count, memory_order_relaxed);
+}
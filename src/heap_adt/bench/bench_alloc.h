@@ -0,0 +1,16 @@
+#ifndef BENCH_ALLOC_H
+#define BENCH_ALLOC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stddef.h>
+#include <stdint.h>
+
+uint64_t bench_get_alloc_count(void);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif //BENCH_ALLOC_H
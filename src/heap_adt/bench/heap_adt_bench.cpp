@@ -0,0 +1,400 @@
+#include <heap.h>
+#include <bench_alloc.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <queue>
+#include <random>
+#include <vector>
+
+/*
+ * Benchmark for the heap_adt. Every operation is run in HEAP_PTR and HEAP_MEM
+ * mode for payloads of 8 to 256 bytes and heap sizes from 1K up to
+ * --max-size, next to a std::priority_queue or std::sort baseline that works
+ * on the same data. Each row reports the average nanoseconds and the average
+ * number of allocations per item.
+ *
+ * Usage: heap_adt_bench [--max-size N] [--seed N]
+ */
+
+typedef struct bench_args_t
+{
+    size_t max_size;
+    uint64_t seed;
+} bench_args_t;
+
+/*
+ * A payload of N bytes whose first 8 bytes hold the key
+ */
+template <size_t N>
+struct record_t
+{
+    std::array<uint8_t, N> bytes;
+};
+
+static uint64_t get_key(const void * payload)
+{
+    uint64_t key;
+    memcpy(&key, payload, sizeof(uint64_t));
+    return key;
+}
+
+template <size_t N>
+struct record_greater_t
+{
+    bool operator()(const record_t<N> & left, const record_t<N> & right) const
+    {
+        return get_key(left.bytes.data()) > get_key(right.bytes.data());
+    }
+    bool operator()(const record_t<N> * left, const record_t<N> * right) const
+    {
+        return get_key(left->bytes.data()) > get_key(right->bytes.data());
+    }
+};
+
+/*
+ * Compare callback shared by both modes, in HEAP_PTR mode the payload is the
+ * pointer to the record and in HEAP_MEM mode the copy of the record
+ */
+static heap_compare_t compare_records(void * payload, void * payload2)
+{
+    uint64_t key = get_key(payload);
+    uint64_t key2 = get_key(payload2);
+    if (key > key2)
+    {
+        return HEAP_GT;
+    }
+    else if (key < key2)
+    {
+        return HEAP_LT;
+    }
+    return HEAP_EQ;
+}
+
+/*
+ * Measures a block of work and prints one row of the report
+ */
+class bench_timer_t
+{
+public:
+    bench_timer_t()
+        : start(std::chrono::steady_clock::now()),
+          start_allocs(bench_get_alloc_count())
+    {}
+
+    void report(const char * operation,
+                const char * mode,
+                size_t payload_size,
+                size_t heap_size,
+                size_t op_count) const
+    {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        uint64_t allocs = bench_get_alloc_count() - start_allocs;
+        double nanos = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        double ops = static_cast<double>((0 == op_count) ? 1 : op_count);
+
+        printf("%-16s %-4s %7zu %11zu %12.1f %10.3f\n",
+               operation,
+               mode,
+               payload_size,
+               heap_size,
+               nanos / ops,
+               static_cast<double>(allocs) / ops);
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+    uint64_t start_allocs;
+};
+
+// Keeps the compiler from dropping work whose result is not used
+static volatile uint64_t sink;
+
+static const char * get_mode_name(heap_data_mode_t data_mode)
+{
+    return (HEAP_PTR == data_mode) ? "ptr" : "mem";
+}
+
+/*
+ * Insert, peek and pop every record through a heap_t
+ */
+template <size_t N>
+static void bench_heap_ops(std::vector<record_t<N>> & records,
+                           heap_data_mode_t data_mode)
+{
+    size_t count = records.size();
+    const char * mode = get_mode_name(data_mode);
+    heap_t * heap = heap_init(MIN_HEAP, data_mode, N, nullptr, compare_records);
+    if (nullptr == heap)
+    {
+        return;
+    }
+
+    {
+        bench_timer_t timer;
+        for (auto & record : records)
+        {
+            heap_insert(heap, &record);
+        }
+        timer.report("insert", mode, N, count, count);
+    }
+
+    {
+        size_t peek_count = std::min<size_t>(count, 100000);
+        bench_timer_t timer;
+        for (size_t i = 0; i < peek_count; i++)
+        {
+            void * payload = heap_peek(heap);
+            sink = sink + get_key(payload);
+            if (HEAP_MEM == data_mode)
+            {
+                free(payload);
+            }
+        }
+        timer.report("peek", mode, N, count, peek_count);
+    }
+
+    {
+        bench_timer_t timer;
+        for (size_t i = 0; i < count; i++)
+        {
+            void * payload = heap_pop(heap);
+            sink = sink + get_key(payload);
+            if (HEAP_MEM == data_mode)
+            {
+                free(payload);
+            }
+        }
+        timer.report("pop", mode, N, count, count);
+    }
+
+    heap_destroy(heap);
+}
+
+/*
+ * Sort and select the median through heap_sort, heap_sort_parallel and
+ * heap_find_nth_item
+ */
+template <size_t N>
+static void bench_heap_sort(std::vector<record_t<N>> & records,
+                            heap_data_mode_t data_mode)
+{
+    size_t count = records.size();
+    const char * mode = get_mode_name(data_mode);
+
+    std::vector<record_t<N>> copy;
+    std::vector<record_t<N> *> pointers;
+    void * array = nullptr;
+    auto reset = [&]()
+    {
+        if (HEAP_MEM == data_mode)
+        {
+            copy = records;
+            array = copy.data();
+        }
+        else
+        {
+            pointers.clear();
+            for (auto & record : records)
+            {
+                pointers.push_back(&record);
+            }
+            array = pointers.data();
+        }
+    };
+
+    reset();
+    {
+        bench_timer_t timer;
+        heap_sort(array, count, N, data_mode, MIN_HEAP, compare_records);
+        timer.report("heap_sort", mode, N, count, count);
+    }
+
+    reset();
+    {
+        bench_timer_t timer;
+        heap_sort_parallel(array, count, N, data_mode, MIN_HEAP,
+                           compare_records, 0);
+        timer.report("heap_sort_par", mode, N, count, count);
+    }
+
+    reset();
+    {
+        bench_timer_t timer;
+        void * payload = heap_find_nth_item(array, count, N, (count / 2) + 1,
+                                            data_mode, MIN_HEAP,
+                                            compare_records);
+        sink = sink + get_key(payload);
+        if (HEAP_MEM == data_mode)
+        {
+            free(payload);
+        }
+        timer.report("find_nth_item", mode, N, count, count);
+    }
+}
+
+/*
+ * The same workloads through the standard library. The "std" rows hold the
+ * records by value like HEAP_MEM and the "std*" rows hold pointers like
+ * HEAP_PTR.
+ */
+template <size_t N>
+static void bench_std(std::vector<record_t<N>> & records)
+{
+    size_t count = records.size();
+
+    {
+        std::priority_queue<record_t<N>,
+                            std::vector<record_t<N>>,
+                            record_greater_t<N>> queue;
+        bench_timer_t timer;
+        for (auto & record : records)
+        {
+            queue.push(record);
+        }
+        timer.report("insert", "std", N, count, count);
+
+        bench_timer_t pop_timer;
+        while (!queue.empty())
+        {
+            sink = sink + get_key(queue.top().bytes.data());
+            queue.pop();
+        }
+        pop_timer.report("pop", "std", N, count, count);
+    }
+
+    {
+        std::priority_queue<record_t<N> *,
+                            std::vector<record_t<N> *>,
+                            record_greater_t<N>> queue;
+        bench_timer_t timer;
+        for (auto & record : records)
+        {
+            queue.push(&record);
+        }
+        timer.report("insert", "std*", N, count, count);
+
+        bench_timer_t pop_timer;
+        while (!queue.empty())
+        {
+            sink = sink + get_key(queue.top()->bytes.data());
+            queue.pop();
+        }
+        pop_timer.report("pop", "std*", N, count, count);
+    }
+
+    {
+        std::vector<record_t<N>> copy = records;
+        bench_timer_t timer;
+        std::sort(copy.begin(), copy.end(),
+                  [](const record_t<N> & left, const record_t<N> & right)
+                  {
+                      return get_key(left.bytes.data())
+                          < get_key(right.bytes.data());
+                  });
+        timer.report("sort", "std", N, count, count);
+    }
+
+    {
+        std::vector<record_t<N> *> pointers;
+        for (auto & record : records)
+        {
+            pointers.push_back(&record);
+        }
+        bench_timer_t timer;
+        std::sort(pointers.begin(), pointers.end(),
+                  [](const record_t<N> * left, const record_t<N> * right)
+                  {
+                      return get_key(left->bytes.data())
+                          < get_key(right->bytes.data());
+                  });
+        timer.report("sort", "std*", N, count, count);
+    }
+
+    {
+        std::vector<record_t<N>> copy = records;
+        bench_timer_t timer;
+        std::nth_element(copy.begin(), copy.begin() + (long)(count / 2),
+                         copy.end(),
+                         [](const record_t<N> & left, const record_t<N> & right)
+                         {
+                             return get_key(left.bytes.data())
+                                 < get_key(right.bytes.data());
+                         });
+        sink = sink + get_key(copy[count / 2].bytes.data());
+        timer.report("nth_element", "std", N, count, count);
+    }
+}
+
+template <size_t N>
+static void bench_payload(const bench_args_t & args)
+{
+    std::mt19937_64 rng(args.seed);
+    for (size_t count = 1000; count <= args.max_size; count *= 10)
+    {
+        std::vector<record_t<N>> records(count);
+        for (auto & record : records)
+        {
+            record.bytes.fill(0);
+            uint64_t key = rng();
+            memcpy(record.bytes.data(), &key, sizeof(uint64_t));
+        }
+
+        bench_heap_ops(records, HEAP_PTR);
+        bench_heap_ops(records, HEAP_MEM);
+        bench_heap_sort(records, HEAP_PTR);
+        bench_heap_sort(records, HEAP_MEM);
+        bench_std(records);
+    }
+}
+
+static bool parse_args(int argc, char ** argv, bench_args_t * args)
+{
+    for (int index = 1; index < argc; index++)
+    {
+        if ((index + 1) >= argc)
+        {
+            return false;
+        }
+        if (0 == strcmp(argv[index], "--max-size"))
+        {
+            args->max_size = strtoull(argv[++index], nullptr, 10);
+        }
+        else if (0 == strcmp(argv[index], "--seed"))
+        {
+            args->seed = strtoull(argv[++index], nullptr, 10);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char ** argv)
+{
+    bench_args_t args = {};
+    args.max_size = 1000000;
+    args.seed = 42;
+
+    if (!parse_args(argc, argv, &args))
+    {
+        fprintf(stderr, "usage: %s [--max-size N] [--seed N]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%-16s %-4s %7s %11s %12s %10s\n",
+           "operation", "mode", "payload", "items", "ns/op", "allocs/op");
+    bench_payload<8>(args);
+    bench_payload<32>(args);
+    bench_payload<64>(args);
+    bench_payload<128>(args);
+    bench_payload<256>(args);
+    return 0;
+}
@@ -30,6 +30,14 @@ typedef enum
     HEAP_MEM
 } heap_data_mode_t;
 
+// Policy used to release unused capacity as the heap_adt drains
+typedef enum
+{
+    HEAP_SHRINK_HALF,       // Halve the array as soon as it is half empty
+    HEAP_SHRINK_QUARTER,    // Halve the array once it is only a quarter full
+    HEAP_SHRINK_NEVER       // Never release capacity once it is acquired
+} heap_shrink_policy_t;
+
 // Mapping to internal structure that manages the heap_adt
 typedef struct heap_t heap_t;
 
@@ -42,9 +50,13 @@ heap_t * heap_init(heap_type_t type,
                    heap_compare_t (* compare)(void *, void *));
 
 void heap_destroy(heap_t * heap);
+bool heap_reserve(heap_t * heap, size_t capacity);
+void heap_set_shrink_policy(heap_t * heap, heap_shrink_policy_t policy);
+size_t heap_get_capacity(heap_t * heap);
 void heap_insert(heap_t * heap, void * payload);
 void * heap_pop(heap_t * heap);
 void * heap_peek(heap_t * heap);
+bool heap_meld(heap_t * heap, heap_t * other);
 
 void heap_sort(void * array,
                size_t item_count,
@@ -52,6 +64,13 @@ void heap_sort(void * array,
                heap_data_mode_t data_mode,
                heap_type_t type,
                heap_compare_t (* compare)(void *, void *));
+void heap_sort_parallel(void * array,
+                        size_t item_count,
+                        size_t item_size,
+                        heap_data_mode_t data_mode,
+                        heap_type_t type,
+                        heap_compare_t (* compare)(void *, void *),
+                        size_t thread_count);
 
 bool heap_in_heap(heap_t * heap, void * data);
 
@@ -68,6 +87,21 @@ void * heap_find_nth_item(void * array,
                           heap_type_t type,
                           heap_compare_t (* compare)(void *, void *));
 
+// Bounded top-K accumulator built on the heap_adt
+typedef struct heap_topk_t heap_topk_t;
+
+heap_topk_t * heap_topk_init(size_t k,
+                             heap_type_t type,
+                             heap_data_mode_t data_mode,
+                             size_t payload_size,
+                             void (* destroy)(void *),
+                             heap_compare_t (* compare)(void *, void *));
+void heap_topk_destroy(heap_topk_t * topk);
+bool heap_topk_push(heap_topk_t * topk, void * payload);
+bool heap_topk_merge(heap_topk_t * topk, heap_topk_t * other);
+size_t heap_topk_get_length(heap_topk_t * topk);
+void * heap_topk_get_sorted(heap_topk_t * topk, size_t * item_count);
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
@@ -0,0 +1,31 @@
+#ifndef HEAP_INDEXED_H
+#define HEAP_INDEXED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Mapping to internal structure that manages the indexed heap
+typedef struct heap_indexed_t heap_indexed_t;
+
+heap_indexed_t * heap_indexed_init(size_t id_count);
+
+void heap_indexed_destroy(heap_indexed_t * heap);
+void heap_indexed_clear(heap_indexed_t * heap);
+bool heap_indexed_push(heap_indexed_t * heap, size_t id, uint64_t key);
+bool heap_indexed_decrease_key(heap_indexed_t * heap, size_t id, uint64_t key);
+size_t heap_indexed_pop(heap_indexed_t * heap, uint64_t * key);
+size_t heap_indexed_peek(heap_indexed_t * heap, uint64_t * key);
+
+bool heap_indexed_contains(heap_indexed_t * heap, size_t id);
+bool heap_indexed_is_empty(heap_indexed_t * heap);
+size_t heap_indexed_get_length(heap_indexed_t * heap);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif //HEAP_INDEXED_H
@@ -0,0 +1,31 @@
+#ifndef HEAP_MQ_H
+#define HEAP_MQ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <heap.h>
+
+// Mapping to internal structure that manages the multi queue
+typedef struct heap_mq_t heap_mq_t;
+
+heap_mq_t * heap_mq_init(size_t queue_count,
+                         heap_type_t type,
+                         heap_data_mode_t data_mode,
+                         size_t payload_size,
+                         void (* destroy)(void *),
+                         heap_compare_t (* compare)(void *, void *));
+
+void heap_mq_destroy(heap_mq_t * mq);
+bool heap_mq_insert(heap_mq_t * mq, void * payload);
+void * heap_mq_pop(heap_mq_t * mq);
+
+bool heap_mq_is_empty(heap_mq_t * mq);
+size_t heap_mq_get_length(heap_mq_t * mq);
+size_t heap_mq_get_queue_count(heap_mq_t * mq);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif //HEAP_MQ_H
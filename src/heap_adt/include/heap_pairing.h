@@ -0,0 +1,31 @@
+#ifndef HEAP_PAIRING_H
+#define HEAP_PAIRING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <heap.h>
+
+// Mapping to internal structure that manages the pairing heap
+typedef struct heap_pairing_t heap_pairing_t;
+
+heap_pairing_t * heap_pairing_init(heap_type_t type,
+                                   heap_data_mode_t data_mode,
+                                   size_t payload_size,
+                                   void (* destroy)(void *),
+                                   heap_compare_t (* compare)(void *, void *));
+
+void heap_pairing_destroy(heap_pairing_t * heap);
+bool heap_pairing_insert(heap_pairing_t * heap, void * payload);
+void * heap_pairing_pop(heap_pairing_t * heap);
+void * heap_pairing_peek(heap_pairing_t * heap);
+bool heap_pairing_meld(heap_pairing_t * heap, heap_pairing_t * other);
+
+bool heap_pairing_is_empty(heap_pairing_t * heap);
+size_t heap_pairing_get_length(heap_pairing_t * heap);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif //HEAP_PAIRING_H
@@ -0,0 +1,31 @@
+#ifndef HEAP_RADIX_H
+#define HEAP_RADIX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <heap.h>
+#include <stdint.h>
+
+// Mapping to internal structure that manages the radix heap
+typedef struct heap_radix_t heap_radix_t;
+
+heap_radix_t * heap_radix_init(heap_data_mode_t data_mode,
+                               size_t payload_size,
+                               void (* destroy)(void *),
+                               uint64_t (* get_key)(void *));
+
+void heap_radix_destroy(heap_radix_t * heap);
+bool heap_radix_insert(heap_radix_t * heap, void * payload);
+void * heap_radix_pop(heap_radix_t * heap);
+void * heap_radix_peek(heap_radix_t * heap);
+
+bool heap_radix_is_empty(heap_radix_t * heap);
+size_t heap_radix_get_length(heap_radix_t * heap);
+uint64_t heap_radix_get_last_key(heap_radix_t * heap);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif //HEAP_RADIX_H
@@ -22,7 +22,9 @@ typedef struct heap_t
     size_t array_length;            // Number of active nodes in the array
     size_t array_size;              // Physical size of the array
     size_t node_size;               // Size of each node in the array
+    size_t reserved_size;           // Minimum physical size kept by shrinking
     heap_data_mode_t data_mode;     // Mode being pointer mode or data mode
+    heap_shrink_policy_t shrink_policy;
 
     heap_compare_t heap_type;
     void ** heap_array;
@@ -33,9 +35,12 @@ typedef struct heap_t
 static void ensure_space(heap_t * heap);
 static void ensure_downgrade_size(heap_t * heap);
 static void resize_heap(heap_t * heap);
+static size_t get_array_bytes(heap_t * heap, size_t array_size);
 
 static void bubble_up(heap_t * heap);
+static void bubble_up_from(heap_t * heap, size_t index);
 static void bubble_down(heap_t * heap);
+static void bubble_down_from(heap_t * heap, size_t parent_index);
 static void swap(heap_t * heap, size_t child_index, size_t parent_index);
 
 static size_t get_parent_index(size_t index);
@@ -54,6 +59,13 @@ static heap_compare_t get_comparison(heap_t * heap,
                                      size_t right_index);
 
 static heap_pointer_t verify_alloc(void * ptr);
+static void pop_into(heap_t * heap, void * destination);
+
+typedef struct heap_topk_t
+{
+    heap_t * heap;                  // Opposite type heap, root is the weakest kept
+    size_t k;                       // Maximum number of items kept
+} heap_topk_t;
 
 
 
@@ -105,6 +117,8 @@ heap_t * heap_init(heap_type_t type,
         .array_length       = 0,
         .array_size         = BASE_SIZE,
         .node_size          = payload_size,
+        .reserved_size      = BASE_SIZE,
+        .shrink_policy      = HEAP_SHRINK_QUARTER,
 
         // Set heap_adt type
         .heap_type          = type ? HEAP_LT : HEAP_GT,
@@ -165,6 +179,67 @@ void heap_destroy(heap_t * heap)
     free(heap);
 }
 
+/*!
+ * @brief Grow the heap_adt so that it can hold at least capacity items without
+ * reallocating. The capacity also becomes the floor that the shrink policy
+ * will never go below, which keeps steady state queues from thrashing.
+ *
+ * @param heap heap_adt data structure
+ * @param capacity Number of items the heap_adt must be able to hold
+ * @return True if the capacity is available, false if the allocation failed
+ */
+bool heap_reserve(heap_t * heap, size_t capacity)
+{
+    assert(heap);
+
+    if (capacity > heap->array_size)
+    {
+        void * re_alloc = realloc(heap->heap_array,
+                                  get_array_bytes(heap, capacity));
+        if (INVALID_PTR == verify_alloc(re_alloc))
+        {
+            return false;
+        }
+        heap->heap_array = re_alloc;
+        heap->array_size = capacity;
+    }
+
+    if (capacity > heap->reserved_size)
+    {
+        heap->reserved_size = capacity;
+    }
+    return true;
+}
+
+/*!
+ * @brief Set the policy used to release capacity as items are popped.
+ *
+ * HEAP_SHRINK_HALF halves the array as soon as it is half empty,
+ * HEAP_SHRINK_QUARTER waits until it is only a quarter full before halving
+ * which leaves room to grow again without a realloc, and HEAP_SHRINK_NEVER
+ * keeps all the acquired capacity until the heap_adt is destroyed.
+ *
+ * @param heap heap_adt data structure
+ * @param policy Shrink policy to apply on the next pop
+ */
+void heap_set_shrink_policy(heap_t * heap, heap_shrink_policy_t policy)
+{
+    assert(heap);
+    heap->shrink_policy = policy;
+}
+
+/*!
+ * @brief Return the number of items the heap_adt can hold before it has to
+ * grow its array
+ * @param heap heap_adt data structure
+ * @return Physical size of the array
+ */
+size_t heap_get_capacity(heap_t * heap)
+{
+    assert(heap);
+    return heap->array_size;
+}
+
 /*!
  * @brief insert payload into the heap_adt
  *
@@ -197,6 +272,96 @@ void heap_insert(heap_t * heap, void * payload)
     bubble_up(heap);
 }
 
+/*!
+ * @brief Move every item of other into heap without popping and reinserting
+ * them one by one.
+ *
+ * The array of other is appended to the array of heap with a single copy and
+ * the heap_adt property is then restored in whichever way is cheaper. When
+ * only a few items are appended they are bubbled up individually for
+ * O(k log n), otherwise the whole array is heapified bottom up in O(n + k).
+ *
+ * Both heaps must have been created with the same type, data mode, payload
+ * size and compare function. In HEAP_PTR mode heap takes ownership of the
+ * pointers. After the call other is empty but keeps its capacity so it can be
+ * refilled without reallocating.
+ *
+ * @param heap heap_adt receiving the items
+ * @param other heap_adt giving up its items
+ * @return False if the heaps are not compatible or the allocation failed
+ */
+bool heap_meld(heap_t * heap, heap_t * other)
+{
+    assert(heap);
+    assert(other);
+
+    if ((heap == other)
+        || (heap->data_mode != other->data_mode)
+        || (heap->node_size != other->node_size)
+        || (heap->heap_type != other->heap_type)
+        || (heap->compare != other->compare))
+    {
+        return false;
+    }
+
+    size_t old_length = heap->array_length;
+    size_t appended = other->array_length;
+    size_t total = old_length + appended;
+    if (0 == appended)
+    {
+        return true;
+    }
+
+    // Grow by doubling so that repeated melds keep an amortized cost
+    if (total > heap->array_size)
+    {
+        size_t array_size = heap->array_size;
+        while (array_size < total)
+        {
+            array_size *= 2;
+        }
+
+        void * re_alloc = realloc(heap->heap_array,
+                                  get_array_bytes(heap, array_size));
+        if (INVALID_PTR == verify_alloc(re_alloc))
+        {
+            return false;
+        }
+        heap->heap_array = re_alloc;
+        heap->array_size = array_size;
+    }
+
+    memcpy((uint8_t *)heap->heap_array + get_array_bytes(heap, old_length),
+           other->heap_array,
+           get_array_bytes(heap, appended));
+    heap->array_length = total;
+    other->array_length = 0;
+
+    // Bubbling up each item costs about k * log2(n + k) comparisons against
+    // the roughly 2 * (n + k) of a full heapify
+    size_t height = 0;
+    for (size_t length = total; length > 1; length /= 2)
+    {
+        height++;
+    }
+
+    if ((appended * height) < (total * 2))
+    {
+        for (size_t index = old_length; index < total; index++)
+        {
+            bubble_up_from(heap, index);
+        }
+    }
+    else
+    {
+        for (size_t index = total / 2; index > 0; index--)
+        {
+            bubble_down_from(heap, index - 1);
+        }
+    }
+    return true;
+}
+
 /*!
  * @brief Heap sort the array passed in
  *
@@ -331,6 +496,227 @@ void * heap_find_nth_item(void * array,
     return target_item;
 }
 
+/*!
+ * @brief Create a bounded top-K accumulator.
+ *
+ * The accumulator keeps the K best items seen in a stream using a K sized
+ * heap_adt of the opposite type. The root of that heap_adt is the weakest item
+ * kept, so an item that does not qualify is rejected with a single comparison
+ * against the root and an item that does qualify replaces the root with a
+ * single bubble down. Memory use is O(K) no matter how long the stream is.
+ *
+ * A MAX_HEAP type keeps the K largest items and a MIN_HEAP type keeps the K
+ * smallest items, the same way heap_find_nth_item counts.
+ *
+ * @param k Number of items to keep
+ * @param type MAX_HEAP to keep the largest items or MIN_HEAP for the smallest
+ * @param data_mode Data storage strategy
+ * @param payload_size The size of the payload. This can be 0 if using HEAP_PTR
+ * @param destroy Pointer to function that frees evicted payloads in HEAP_PTR
+ * @param compare Pointer to function that compares the nodes
+ * @return Pointer to the accumulator or NULL
+ */
+heap_topk_t * heap_topk_init(size_t k,
+                             heap_type_t type,
+                             heap_data_mode_t data_mode,
+                             size_t payload_size,
+                             void (* destroy)(void *),
+                             heap_compare_t (* compare)(void *, void *))
+{
+    heap_topk_t * topk = (heap_topk_t *)malloc(sizeof(heap_topk_t));
+    if (INVALID_PTR == verify_alloc((void *)topk))
+    {
+        return NULL;
+    }
+
+    topk->k = k;
+    topk->heap = heap_init((MAX_HEAP == type) ? MIN_HEAP : MAX_HEAP,
+                           data_mode,
+                           payload_size,
+                           destroy,
+                           compare);
+    if (NULL == topk->heap)
+    {
+        free(topk);
+        return NULL;
+    }
+
+    // The heap_adt never holds more than K items, size it once up front
+    heap_set_shrink_policy(topk->heap, HEAP_SHRINK_NEVER);
+    if (!heap_reserve(topk->heap, k))
+    {
+        heap_destroy(topk->heap);
+        free(topk);
+        return NULL;
+    }
+    return topk;
+}
+
+/*!
+ * @brief Destroy the accumulator. In HEAP_PTR mode the items still kept are
+ * freed with the destroy callback
+ * @param topk Pointer to the accumulator
+ */
+void heap_topk_destroy(heap_topk_t * topk)
+{
+    assert(topk);
+    heap_destroy(topk->heap);
+    free(topk);
+}
+
+/*!
+ * @brief Offer an item to the accumulator.
+ *
+ * If the item is kept the accumulator takes ownership of it, and in HEAP_PTR
+ * mode the item it evicted is freed with the destroy callback. If the item is
+ * rejected the caller keeps ownership. Items equal to the weakest item kept
+ * are rejected so the earliest items win ties.
+ *
+ * @param topk Pointer to the accumulator
+ * @param payload Pointer to the payload
+ * @return True if the item was kept
+ */
+bool heap_topk_push(heap_topk_t * topk, void * payload)
+{
+    assert(topk);
+    assert(payload);
+
+    heap_t * heap = topk->heap;
+    if (heap->array_length < topk->k)
+    {
+        heap_insert(heap, payload);
+        return true;
+    }
+
+    if (0 == topk->k)
+    {
+        return false;
+    }
+
+    // The item only qualifies if the weakest item kept orders before it
+    void * root = (HEAP_PTR == heap->data_mode) ? heap->heap_array[0]
+                                                : (void *)get_slice(heap, 0);
+    if (heap->heap_type != heap->compare(root, payload))
+    {
+        return false;
+    }
+
+    if (HEAP_PTR == heap->data_mode)
+    {
+        if (NULL != heap->destroy)
+        {
+            heap->destroy(root);
+        }
+        heap->heap_array[0] = payload;
+    }
+    else
+    {
+        memcpy(root, payload, heap->node_size);
+    }
+    bubble_down(heap);
+    return true;
+}
+
+/*!
+ * @brief Merge the partial result of another accumulator into this one. This
+ * is used to combine the accumulators filled by different threads. The other
+ * accumulator is left empty. Both must use the same data mode, payload size
+ * and compare function.
+ *
+ * @param topk Pointer to the accumulator receiving the items
+ * @param other Pointer to the accumulator giving up its items
+ * @return False if the accumulators are not compatible or are the same
+ * accumulator
+ */
+bool heap_topk_merge(heap_topk_t * topk, heap_topk_t * other)
+{
+    assert(topk);
+    assert(other);
+
+    heap_t * heap = other->heap;
+    if ((topk == other)
+        || (heap->data_mode != topk->heap->data_mode)
+        || (heap->node_size != topk->heap->node_size)
+        || (heap->heap_type != topk->heap->heap_type)
+        || (heap->compare != topk->heap->compare))
+    {
+        return false;
+    }
+
+    for (size_t index = 0; index < heap->array_length; index++)
+    {
+        if (HEAP_PTR == heap->data_mode)
+        {
+            void * payload = heap->heap_array[index];
+            if ((!heap_topk_push(topk, payload)) && (NULL != heap->destroy))
+            {
+                heap->destroy(payload);
+            }
+        }
+        else
+        {
+            heap_topk_push(topk, get_slice(heap, index));
+        }
+    }
+    heap->array_length = 0;
+    return true;
+}
+
+/*!
+ * @brief Return the number of items currently kept
+ * @param topk Pointer to the accumulator
+ * @return Number of items kept, never more than K
+ */
+size_t heap_topk_get_length(heap_topk_t * topk)
+{
+    assert(topk);
+    return topk->heap->array_length;
+}
+
+/*!
+ * @brief Drain the accumulator into a newly allocated array sorted from the
+ * best item to the weakest (descending for MAX_HEAP, ascending for MIN_HEAP).
+ *
+ * In HEAP_PTR mode the array holds the item pointers and the caller takes
+ * ownership of them. In HEAP_MEM mode the array is a contiguous block of
+ * payload_size items. The array must be freed and the accumulator is empty
+ * after the call.
+ *
+ * @param topk Pointer to the accumulator
+ * @param item_count Set to the number of items in the array
+ * @return Sorted array or NULL if empty or the allocation failed
+ */
+void * heap_topk_get_sorted(heap_topk_t * topk, size_t * item_count)
+{
+    assert(topk);
+    assert(item_count);
+
+    heap_t * heap = topk->heap;
+    * item_count = 0;
+    if (heap_is_empty(heap))
+    {
+        return NULL;
+    }
+
+    size_t count = heap->array_length;
+    size_t item_size = (HEAP_PTR == heap->data_mode) ? sizeof(void *)
+                                                     : heap->node_size;
+    uint8_t * array = (uint8_t *)malloc(count * item_size);
+    if (INVALID_PTR == verify_alloc(array))
+    {
+        return NULL;
+    }
+
+    // The root is the weakest item so the array is filled back to front
+    for (size_t index = count; index > 0; index--)
+    {
+        pop_into(heap, array + get_index(index - 1, item_size));
+    }
+
+    * item_count = count;
+    return array;
+}
+
 /*!
  * @brief Check to see if the data provided is already in the heap_adt
  * @param heap
@@ -393,7 +779,7 @@ void * heap_peek(heap_t * heap)
     else
     {
         // Extract the current data at index 0
-        uint8_t * temp = (uint8_t *)calloc(1, sizeof(heap->node_size));
+        uint8_t * temp = (uint8_t *)calloc(1, heap->node_size);
         uint8_t * index_0_ptr = get_slice(heap, 0);
         memcpy(temp, index_0_ptr, heap->node_size);
 
@@ -434,7 +820,7 @@ void * heap_pop(heap_t * heap)
     else
     {
         // Extract the current data at index 0
-        uint8_t * temp = (uint8_t *)calloc(1, sizeof(heap->node_size));
+        uint8_t * temp = (uint8_t *)calloc(1, heap->node_size);
         uint8_t * index_0_ptr = get_slice(heap, 0);
         memcpy(temp, index_0_ptr, heap->node_size);
 
@@ -483,17 +869,41 @@ static void ensure_space(heap_t * heap)
 }
 
 /*!
- * Change the size of the data array if the length of the array can fit
- * within the size/2 of the array. Unless, the size becomes less than the
- * base size
+ * Change the size of the data array based on the shrink policy. The array is
+ * halved once the length falls to the policies threshold but it is never
+ * made smaller than the reserved size of the heap_adt.
  * @param heap
  */
 static void ensure_downgrade_size(heap_t * heap)
 {
-    if ((heap->array_length == (heap->array_size / 2))
-        & (heap->array_size > BASE_SIZE))
+    size_t divisor = 0;
+    switch (heap->shrink_policy)
+    {
+        case HEAP_SHRINK_HALF:
+            divisor = 2;
+            break;
+        case HEAP_SHRINK_QUARTER:
+            divisor = 4;
+            break;
+        case HEAP_SHRINK_NEVER:
+        default:
+            return;
+    }
+
+    size_t new_size = heap->array_size;
+    while ((heap->array_length <= (new_size / divisor))
+        && (new_size > heap->reserved_size))
     {
-        heap->array_size = heap->array_size / 2;
+        new_size = new_size / 2;
+        if (new_size < heap->reserved_size)
+        {
+            new_size = heap->reserved_size;
+        }
+    }
+
+    if (new_size != heap->array_size)
+    {
+        heap->array_size = new_size;
         resize_heap(heap);
     }
 }
@@ -504,18 +914,8 @@ static void ensure_downgrade_size(heap_t * heap)
  */
 static void resize_heap(heap_t * heap)
 {
-    void * re_alloc = NULL;
-    if (HEAP_PTR == heap->data_mode)
-    {
-        re_alloc = realloc(heap->heap_array, sizeof(void * ) *
-        heap->array_size);
-    }
-    else
-    {
-        re_alloc = realloc(heap->heap_array, heap->node_size *
-        heap->array_size);
-
-    }
+    void * re_alloc = realloc(heap->heap_array,
+                              get_array_bytes(heap, heap->array_size));
     if (INVALID_PTR == verify_alloc(re_alloc))
     {
         fprintf(stderr, "[!] Could not reallocate memory for heap_adt!\n");
@@ -525,6 +925,21 @@ static void resize_heap(heap_t * heap)
     heap->heap_array = re_alloc;
 }
 
+/*!
+ * Number of bytes required to hold array_size nodes in the current data mode
+ * @param heap
+ * @param array_size Number of nodes
+ * @return Size in bytes
+ */
+static size_t get_array_bytes(heap_t * heap, size_t array_size)
+{
+    if (HEAP_PTR == heap->data_mode)
+    {
+        return sizeof(void *) * array_size;
+    }
+    return heap->node_size * array_size;
+}
+
 /*!
  * @brief Bubble up operations are performed on nodes that are of greater
  * value than their parents. The operation is performed until the node
@@ -537,8 +952,16 @@ static void resize_heap(heap_t * heap)
 static void bubble_up(heap_t * heap)
 {
     // get the last index
-    size_t index = heap->array_length - 1;
+    bubble_up_from(heap, heap->array_length - 1);
+}
 
+/*!
+ * @brief Bubble up the node at the index passed in
+ * @param heap
+ * @param index Index of the node to bubble up
+ */
+static void bubble_up_from(heap_t * heap, size_t index)
+{
     while ((index > 0) &&
         (heap->heap_type
             == get_comparison(heap, index, get_parent_index(index))))
@@ -560,7 +983,17 @@ static void bubble_up(heap_t * heap)
  */
 static void bubble_down(heap_t * heap)
 {
-    size_t parent_index = 0;
+    bubble_down_from(heap, 0);
+}
+
+/*!
+ * @brief Bubble down the node at the index passed in. This is what heapify
+ * runs on every parent from the bottom of the tree up.
+ * @param heap
+ * @param parent_index Index of the node to bubble down
+ */
+static void bubble_down_from(heap_t * heap, size_t parent_index)
+{
     size_t target_index = 0;
     while ((parent_index < heap->array_length) && (!(is_valid_parent(heap, parent_index))))
     {
@@ -772,6 +1205,34 @@ static heap_pointer_t verify_alloc(void * ptr)
     return VALID_PTR;
 }
 
+/*!
+ * @brief Remove the root and copy it to destination without allocating. In
+ * HEAP_PTR mode the pointer itself is written to destination.
+ * @param heap
+ * @param destination Buffer large enough to hold one node
+ */
+static void pop_into(heap_t * heap, void * destination)
+{
+    heap->array_length--;
+    if (HEAP_PTR == heap->data_mode)
+    {
+        memcpy(destination, &heap->heap_array[0], sizeof(void *));
+        heap->heap_array[0] = heap->heap_array[heap->array_length];
+    }
+    else
+    {
+        memcpy(destination, get_slice(heap, 0), heap->node_size);
+        memcpy(get_slice(heap, 0),
+               get_slice(heap, heap->array_length),
+               heap->node_size);
+    }
+
+    if (heap->array_length)
+    {
+        bubble_down(heap);
+    }
+}
+
 /*!
  * @brief performs the pointer arithmetic for indexing the correct location
  * of the array.
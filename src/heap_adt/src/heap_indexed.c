@@ -0,0 +1,344 @@
+#include <heap_indexed.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum
+{
+    INDEXED_ARITY = 4,              // Children per item
+    INDEXED_BASE_SIZE = 16,         // Initial number of items
+    INDEXED_CACHE_LINE = 64,        // Alignment of the item storage
+    INDEXED_ROOT_PAD = INDEXED_ARITY - 1,   // Unused items in front of the root
+} heap_indexed_default_t;
+
+// Position of an id that is not in the heap
+#define INDEXED_ABSENT SIZE_MAX
+
+typedef struct indexed_item_t
+{
+    uint64_t key;
+    size_t id;
+} indexed_item_t;
+
+typedef struct heap_indexed_t
+{
+    indexed_item_t * storage;       // Cache line aligned block holding the items
+    indexed_item_t * items;         // 4-ary min heap of keys, INDEXED_ROOT_PAD into storage
+    size_t length;                  // Number of items in the heap
+    size_t size;                    // Physical size of the items array
+    size_t * positions;             // Id to its index in items or INDEXED_ABSENT
+    size_t id_count;
+} heap_indexed_t;
+
+static void sift_up(heap_indexed_t * heap, size_t index);
+static void sift_down(heap_indexed_t * heap, size_t index);
+static indexed_item_t * alloc_items(size_t size);
+
+/*!
+ * @brief Create a min heap of integer keys that supports decrease key.
+ *
+ * Every item is an id in the range [0, id_count) with a uint64_t key. The heap
+ * keeps the position of every id so that the key of an item can be lowered in
+ * O(log n), which is what Dijkstra like searches need to keep a single entry
+ * per node. The items are kept in a 4-ary array heap, which is shallower than
+ * a binary heap. The children of item i are items 4i + 1 to 4i + 4, so the
+ * root is placed INDEXED_ROOT_PAD items into a cache line aligned block. With
+ * 16 byte items every group of siblings then fills exactly one cache line.
+ *
+ * @param id_count Number of distinct ids the heap can hold
+ * @return Pointer to the indexed heap or NULL
+ */
+heap_indexed_t * heap_indexed_init(size_t id_count)
+{
+    heap_indexed_t * heap = (heap_indexed_t *)calloc(1, sizeof(heap_indexed_t));
+    if (NULL == heap)
+    {
+        fprintf(stderr, "[!] Could not allocate memory!\n");
+        return NULL;
+    }
+
+    size_t size = INDEXED_BASE_SIZE;
+    heap->storage = alloc_items(size);
+    heap->positions = (size_t *)malloc(sizeof(size_t) * (id_count + 1));
+    if ((NULL == heap->storage) || (NULL == heap->positions))
+    {
+        fprintf(stderr, "[!] Could not allocate memory!\n");
+        heap_indexed_destroy(heap);
+        return NULL;
+    }
+    heap->items = heap->storage + INDEXED_ROOT_PAD;
+
+    for (size_t id = 0; id < id_count; id++)
+    {
+        heap->positions[id] = INDEXED_ABSENT;
+    }
+    heap->size = size;
+    heap->id_count = id_count;
+    return heap;
+}
+
+/*!
+ * @brief Destroy the indexed heap
+ * @param heap Pointer to the indexed heap
+ */
+void heap_indexed_destroy(heap_indexed_t * heap)
+{
+    assert(heap);
+    free(heap->storage);
+    free(heap->positions);
+    free(heap);
+}
+
+/*!
+ * @brief Remove every item from the heap. The cost is the number of items in
+ * the heap and not the number of ids, which allows the heap to be reused for
+ * many small searches.
+ * @param heap Pointer to the indexed heap
+ */
+void heap_indexed_clear(heap_indexed_t * heap)
+{
+    assert(heap);
+    for (size_t index = 0; index < heap->length; index++)
+    {
+        heap->positions[heap->items[index].id] = INDEXED_ABSENT;
+    }
+    heap->length = 0;
+}
+
+/*!
+ * @brief Insert an id that is not in the heap yet
+ * @param heap Pointer to the indexed heap
+ * @param id Id of the item
+ * @param key Priority of the item
+ * @return False if the id is already in the heap or memory ran out
+ */
+bool heap_indexed_push(heap_indexed_t * heap, size_t id, uint64_t key)
+{
+    assert(heap);
+    assert(id < heap->id_count);
+
+    if (INDEXED_ABSENT != heap->positions[id])
+    {
+        return false;
+    }
+
+    if (heap->length == heap->size)
+    {
+        // realloc does not keep the alignment so the items are moved by hand
+        size_t size = heap->size * 2;
+        indexed_item_t * storage = alloc_items(size);
+        if (NULL == storage)
+        {
+            fprintf(stderr, "[!] Could not reallocate memory for indexed heap!\n");
+            return false;
+        }
+        memcpy(storage + INDEXED_ROOT_PAD, heap->items, sizeof(indexed_item_t) * heap->length);
+        free(heap->storage);
+        heap->storage = storage;
+        heap->items = storage + INDEXED_ROOT_PAD;
+        heap->size = size;
+    }
+
+    heap->items[heap->length] = (indexed_item_t){
+        .key    = key,
+        .id     = id
+    };
+    heap->positions[id] = heap->length;
+    heap->length++;
+    sift_up(heap, heap->length - 1);
+    return true;
+}
+
+/*!
+ * @brief Lower the key of an id that is in the heap
+ * @param heap Pointer to the indexed heap
+ * @param id Id of the item
+ * @param key New priority of the item
+ * @return False if the id is not in the heap or the key is not lower
+ */
+bool heap_indexed_decrease_key(heap_indexed_t * heap, size_t id, uint64_t key)
+{
+    assert(heap);
+    assert(id < heap->id_count);
+
+    size_t index = heap->positions[id];
+    if ((INDEXED_ABSENT == index) || (key >= heap->items[index].key))
+    {
+        return false;
+    }
+
+    heap->items[index].key = key;
+    sift_up(heap, index);
+    return true;
+}
+
+/*!
+ * @brief Pop the id with the smallest key
+ * @param heap Pointer to the indexed heap
+ * @param key Set to the key of the id popped, may be NULL
+ * @return Id popped or SIZE_MAX if the heap is empty
+ */
+size_t heap_indexed_pop(heap_indexed_t * heap, uint64_t * key)
+{
+    assert(heap);
+
+    if (0 == heap->length)
+    {
+        return SIZE_MAX;
+    }
+
+    indexed_item_t top = heap->items[0];
+    heap->positions[top.id] = INDEXED_ABSENT;
+    heap->length--;
+    if (0 != heap->length)
+    {
+        heap->items[0] = heap->items[heap->length];
+        heap->positions[heap->items[0].id] = 0;
+        sift_down(heap, 0);
+    }
+
+    if (NULL != key)
+    {
+        * key = top.key;
+    }
+    return top.id;
+}
+
+/*!
+ * @brief Return the id with the smallest key without removing it
+ * @param heap Pointer to the indexed heap
+ * @param key Set to the key of the id, may be NULL
+ * @return Id or SIZE_MAX if the heap is empty
+ */
+size_t heap_indexed_peek(heap_indexed_t * heap, uint64_t * key)
+{
+    assert(heap);
+
+    if (0 == heap->length)
+    {
+        return SIZE_MAX;
+    }
+
+    if (NULL != key)
+    {
+        * key = heap->items[0].key;
+    }
+    return heap->items[0].id;
+}
+
+/*!
+ * @brief Check if the id is currently in the heap
+ * @param heap Pointer to the indexed heap
+ * @param id Id to check
+ * @return bool
+ */
+bool heap_indexed_contains(heap_indexed_t * heap, size_t id)
+{
+    assert(heap);
+    return (id < heap->id_count) && (INDEXED_ABSENT != heap->positions[id]);
+}
+
+/*!
+ * @brief Check if the indexed heap is currently empty
+ * @param heap Pointer to the indexed heap
+ * @return bool
+ */
+bool heap_indexed_is_empty(heap_indexed_t * heap)
+{
+    assert(heap);
+    return (0 == heap->length);
+}
+
+/*!
+ * @brief Return the number of items in the indexed heap
+ * @param heap Pointer to the indexed heap
+ * @return Number of items
+ */
+size_t heap_indexed_get_length(heap_indexed_t * heap)
+{
+    assert(heap);
+    return heap->length;
+}
+
+/*!
+ * @brief Move the item up until its parent has a smaller or equal key. The
+ * item is held aside and the parents are shifted down into the hole, which
+ * writes every slot once instead of swapping.
+ * @param heap Pointer to the indexed heap
+ * @param index Index of the item to move
+ */
+static void sift_up(heap_indexed_t * heap, size_t index)
+{
+    indexed_item_t item = heap->items[index];
+    while (0 != index)
+    {
+        size_t parent = (index - 1) / INDEXED_ARITY;
+        if (heap->items[parent].key <= item.key)
+        {
+            break;
+        }
+        heap->items[index] = heap->items[parent];
+        heap->positions[heap->items[index].id] = index;
+        index = parent;
+    }
+    heap->items[index] = item;
+    heap->positions[item.id] = index;
+}
+
+/*!
+ * @brief Move the item down until all its children have a greater or equal
+ * key
+ * @param heap Pointer to the indexed heap
+ * @param index Index of the item to move
+ */
+static void sift_down(heap_indexed_t * heap, size_t index)
+{
+    indexed_item_t item = heap->items[index];
+    while (true)
+    {
+        size_t first = (index * INDEXED_ARITY) + 1;
+        if (first >= heap->length)
+        {
+            break;
+        }
+
+        size_t last = first + INDEXED_ARITY;
+        if (last > heap->length)
+        {
+            last = heap->length;
+        }
+
+        size_t smallest = first;
+        for (size_t child = first + 1; child < last; child++)
+        {
+            if (heap->items[child].key < heap->items[smallest].key)
+            {
+                smallest = child;
+            }
+        }
+
+        if (heap->items[smallest].key >= item.key)
+        {
+            break;
+        }
+        heap->items[index] = heap->items[smallest];
+        heap->positions[heap->items[index].id] = index;
+        index = smallest;
+    }
+    heap->items[index] = item;
+    heap->positions[item.id] = index;
+}
+
+/*!
+ * @brief Allocate a cache line aligned block for size items plus the padding
+ * in front of the root
+ * @param size Number of items the heap can hold
+ * @return Block or NULL if memory ran out
+ */
+static indexed_item_t * alloc_items(size_t size)
+{
+    size_t bytes = sizeof(indexed_item_t) * (size + INDEXED_ROOT_PAD);
+    bytes = (bytes + INDEXED_CACHE_LINE - 1) & ~((size_t)INDEXED_CACHE_LINE - 1);
+    return (indexed_item_t *)aligned_alloc(INDEXED_CACHE_LINE, bytes);
+}
@@ -0,0 +1,414 @@
+#include <heap_mq.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef enum
+{
+    MQ_QUEUES_PER_THREAD = 2,       // Queues created per cpu when count is 0
+    MQ_CACHE_LINE = 64,             // Alignment used to avoid false sharing
+    MQ_LOCK_ATTEMPTS = 8,           // Random attempts before the slow path
+} heap_mq_default_t;
+
+// Each queue sits on its own cache line so that the lock and length of one
+// queue do not bounce between cores that are working on another queue
+typedef struct heap_mq_queue_t
+{
+    _Alignas(MQ_CACHE_LINE) pthread_mutex_t lock;
+    heap_t * heap;
+    atomic_size_t length;           // Mirror of the heap length for lock free reads
+} heap_mq_queue_t;
+
+typedef struct heap_mq_t
+{
+    heap_mq_queue_t * queues;
+    size_t queue_count;
+    size_t payload_size;
+    heap_data_mode_t data_mode;
+
+    heap_compare_t heap_type;
+    heap_compare_t (* compare)(void * payload, void * payload2);
+} heap_mq_t;
+
+static _Thread_local uint64_t rng_state = 0;
+
+static size_t get_random_index(size_t bound);
+static heap_mq_queue_t * lock_random_queue(heap_mq_t * mq);
+static heap_mq_queue_t * lock_best_queue(heap_mq_t * mq,
+                                         size_t left_index,
+                                         size_t right_index);
+static void * pop_locked(heap_mq_queue_t * queue);
+static void destroy_queues(heap_mq_t * mq, size_t queue_count);
+
+/*!
+ * @brief Create a concurrent priority queue using the MultiQueue design.
+ *
+ * The structure is a collection of independent heap_t instances, each
+ * protected by its own lock. Inserts go to a random queue and pops sample two
+ * random queues and take the better of the two roots. This relaxes the strict
+ * ordering of a single heap_adt (a pop returns an item that is close to the
+ * root but not necessarily the root) in exchange for throughput that scales
+ * with the number of threads instead of serializing on one lock.
+ *
+ * Using a queue_count of 1 gives an exact, but fully serialized, priority
+ * queue. A queue_count of 0 creates two queues per online cpu.
+ *
+ * @param queue_count Number of internal heaps, 0 to size it by the cpu count
+ * @param type Heap type, max heap_adt or min heap_adt
+ * @param data_mode Data storage strategy
+ * @param payload_size The size of the payload. This can be 0 if using HEAP_PTR
+ * @param destroy Pointer to function that frees the block of memory
+ * @param compare Pointer to function that compares the nodes
+ * @return Pointer to the multi queue or NULL
+ */
+heap_mq_t * heap_mq_init(size_t queue_count,
+                         heap_type_t type,
+                         heap_data_mode_t data_mode,
+                         size_t payload_size,
+                         void (* destroy)(void *),
+                         heap_compare_t (* compare)(void *, void *))
+{
+    assert(compare);
+
+    if (0 == queue_count)
+    {
+        long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+        queue_count = MQ_QUEUES_PER_THREAD
+            * ((cpu_count > 0) ? (size_t)cpu_count : 1);
+    }
+
+    heap_mq_t * mq = (heap_mq_t *)malloc(sizeof(heap_mq_t));
+    if (NULL == mq)
+    {
+        fprintf(stderr, "[!] Could not allocate memory!\n");
+        return NULL;
+    }
+
+    * mq = (heap_mq_t){
+        .queue_count    = queue_count,
+        .payload_size   = payload_size,
+        .data_mode      = data_mode,
+        .heap_type      = type ? HEAP_LT : HEAP_GT,
+        .compare        = compare
+    };
+
+    mq->queues = (heap_mq_queue_t *)aligned_alloc(
+        MQ_CACHE_LINE, sizeof(heap_mq_queue_t) * queue_count);
+    if (NULL == mq->queues)
+    {
+        fprintf(stderr, "[!] Could not allocate memory!\n");
+        free(mq);
+        return NULL;
+    }
+
+    // The internal heaps always store pointers. In HEAP_MEM mode the payload
+    // is copied into its own block on insert which is handed back on pop,
+    // this keeps the root comparisons free of any allocations.
+    void (* free_func)(void *) = (HEAP_MEM == data_mode) ? free : destroy;
+    for (size_t index = 0; index < queue_count; index++)
+    {
+        heap_mq_queue_t * queue = &mq->queues[index];
+        queue->heap = heap_init(type, HEAP_PTR, 0, free_func, compare);
+        if (NULL == queue->heap)
+        {
+            destroy_queues(mq, index);
+            free(mq);
+            return NULL;
+        }
+        pthread_mutex_init(&queue->lock, NULL);
+        atomic_init(&queue->length, 0);
+    }
+
+    return mq;
+}
+
+/*!
+ * @brief Destroy the multi queue. Any items still queued are freed with the
+ * destroy callback in HEAP_PTR mode. Must not be called while other threads
+ * are still using the queue.
+ * @param mq Pointer to the multi queue
+ */
+void heap_mq_destroy(heap_mq_t * mq)
+{
+    assert(mq);
+    destroy_queues(mq, mq->queue_count);
+    free(mq);
+}
+
+/*!
+ * @brief Insert the payload into one of the internal heaps. Safe to call
+ * from any number of threads.
+ * @param mq Pointer to the multi queue
+ * @param payload Pointer to the payload passed in
+ * @return False if the copy of the payload could not be allocated in
+ * HEAP_MEM mode, the payload is then not queued
+ */
+bool heap_mq_insert(heap_mq_t * mq, void * payload)
+{
+    assert(mq);
+    assert(payload);
+
+    void * item = payload;
+    if (HEAP_MEM == mq->data_mode)
+    {
+        item = malloc(mq->payload_size);
+        if (NULL == item)
+        {
+            fprintf(stderr, "[!] Could not allocate memory!\n");
+            return false;
+        }
+        memcpy(item, payload, mq->payload_size);
+    }
+
+    heap_mq_queue_t * queue = lock_random_queue(mq);
+    heap_insert(queue->heap, item);
+    atomic_fetch_add_explicit(&queue->length, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&queue->lock);
+    return true;
+}
+
+/*!
+ * @brief Pop an item close to the root of the multi queue. Safe to call from
+ * any number of threads. The returned pointer must be freed in HEAP_MEM mode
+ * just like heap_pop.
+ *
+ * NULL is only returned after every internal heap was observed to be empty.
+ *
+ * @param mq Pointer to the multi queue
+ * @return Pointer to the payload or NULL if the queue is empty
+ */
+void * heap_mq_pop(heap_mq_t * mq)
+{
+    assert(mq);
+
+    void * payload = NULL;
+    for (size_t attempt = 0; attempt < MQ_LOCK_ATTEMPTS; attempt++)
+    {
+        heap_mq_queue_t * queue = lock_best_queue(
+            mq,
+            get_random_index(mq->queue_count),
+            get_random_index(mq->queue_count));
+
+        if (NULL != queue)
+        {
+            payload = pop_locked(queue);
+            pthread_mutex_unlock(&queue->lock);
+            if (NULL != payload)
+            {
+                return payload;
+            }
+        }
+    }
+
+    // The random samples kept hitting empty or contended queues, sweep all
+    // of them so that an item is never missed
+    for (size_t index = 0; index < mq->queue_count; index++)
+    {
+        heap_mq_queue_t * queue = &mq->queues[index];
+        if (0 == atomic_load_explicit(&queue->length, memory_order_relaxed))
+        {
+            continue;
+        }
+
+        pthread_mutex_lock(&queue->lock);
+        payload = pop_locked(queue);
+        pthread_mutex_unlock(&queue->lock);
+        if (NULL != payload)
+        {
+            return payload;
+        }
+    }
+    return NULL;
+}
+
+/*!
+ * @brief Check if all the internal heaps are empty. With concurrent writers
+ * the answer is only a snapshot.
+ * @param mq Pointer to the multi queue
+ * @return bool
+ */
+bool heap_mq_is_empty(heap_mq_t * mq)
+{
+    return (0 == heap_mq_get_length(mq));
+}
+
+/*!
+ * @brief Return the number of items stored across all the internal heaps.
+ * With concurrent writers the answer is only a snapshot.
+ * @param mq Pointer to the multi queue
+ * @return Number of queued items
+ */
+size_t heap_mq_get_length(heap_mq_t * mq)
+{
+    assert(mq);
+
+    size_t length = 0;
+    for (size_t index = 0; index < mq->queue_count; index++)
+    {
+        length += atomic_load_explicit(&mq->queues[index].length,
+                                       memory_order_relaxed);
+    }
+    return length;
+}
+
+/*!
+ * @brief Return the number of internal heaps
+ * @param mq Pointer to the multi queue
+ * @return Number of internal heaps
+ */
+size_t heap_mq_get_queue_count(heap_mq_t * mq)
+{
+    assert(mq);
+    return mq->queue_count;
+}
+
+/*!
+ * @brief Lock a random queue. A few non blocking attempts are made so that
+ * contended queues are skipped before falling back to a blocking lock.
+ * @param mq Pointer to the multi queue
+ * @return Locked queue
+ */
+static heap_mq_queue_t * lock_random_queue(heap_mq_t * mq)
+{
+    heap_mq_queue_t * queue = NULL;
+    for (size_t attempt = 0; attempt < MQ_LOCK_ATTEMPTS; attempt++)
+    {
+        queue = &mq->queues[get_random_index(mq->queue_count)];
+        if (0 == pthread_mutex_trylock(&queue->lock))
+        {
+            return queue;
+        }
+    }
+
+    queue = &mq->queues[get_random_index(mq->queue_count)];
+    pthread_mutex_lock(&queue->lock);
+    return queue;
+}
+
+/*!
+ * @brief Lock the queue out of the two sampled queues that has the better
+ * root. Locks are only attempted with trylock and are always taken in index
+ * order so that two poppers can never deadlock.
+ *
+ * @param mq Pointer to the multi queue
+ * @param left_index Index of the first sampled queue
+ * @param right_index Index of the second sampled queue
+ * @return Locked queue or NULL if both are empty or contended
+ */
+static heap_mq_queue_t * lock_best_queue(heap_mq_t * mq,
+                                         size_t left_index,
+                                         size_t right_index)
+{
+    if (left_index > right_index)
+    {
+        size_t temp = left_index;
+        left_index = right_index;
+        right_index = temp;
+    }
+
+    heap_mq_queue_t * left = &mq->queues[left_index];
+    heap_mq_queue_t * right = &mq->queues[right_index];
+    bool left_empty =
+        (0 == atomic_load_explicit(&left->length, memory_order_relaxed));
+    bool right_empty =
+        (0 == atomic_load_explicit(&right->length, memory_order_relaxed));
+
+    if (left_empty && right_empty)
+    {
+        return NULL;
+    }
+
+    // Only one candidate, no comparison is needed
+    if ((left_index == right_index) || left_empty || right_empty)
+    {
+        heap_mq_queue_t * queue = left_empty ? right : left;
+        return (0 == pthread_mutex_trylock(&queue->lock)) ? queue : NULL;
+    }
+
+    if (0 != pthread_mutex_trylock(&left->lock))
+    {
+        return NULL;
+    }
+
+    // If the second queue is busy just settle for the first one
+    if (0 != pthread_mutex_trylock(&right->lock))
+    {
+        return left;
+    }
+
+    if (heap_is_empty(right->heap))
+    {
+        pthread_mutex_unlock(&right->lock);
+        return left;
+    }
+    if (heap_is_empty(left->heap))
+    {
+        pthread_mutex_unlock(&left->lock);
+        return right;
+    }
+
+    // Keep the queue whose root should come out first and release the other
+    if (mq->heap_type == mq->compare(heap_peek(left->heap),
+                                     heap_peek(right->heap)))
+    {
+        pthread_mutex_unlock(&right->lock);
+        return left;
+    }
+    pthread_mutex_unlock(&left->lock);
+    return right;
+}
+
+/*!
+ * @brief Pop the root of a queue that the caller already holds the lock for
+ * @param queue Locked queue
+ * @return Payload or NULL if the queue is empty
+ */
+static void * pop_locked(heap_mq_queue_t * queue)
+{
+    void * payload = heap_pop(queue->heap);
+    if (NULL != payload)
+    {
+        atomic_fetch_sub_explicit(&queue->length, 1, memory_order_relaxed);
+    }
+    return payload;
+}
+
+/*!
+ * @brief Destroy the first queue_count queues of the multi queue
+ * @param mq Pointer to the multi queue
+ * @param queue_count Number of queues that were initialized
+ */
+static void destroy_queues(heap_mq_t * mq, size_t queue_count)
+{
+    for (size_t index = 0; index < queue_count; index++)
+    {
+        heap_destroy(mq->queues[index].heap);
+        pthread_mutex_destroy(&mq->queues[index].lock);
+    }
+    free(mq->queues);
+}
+
+/*!
+ * @brief Thread local xorshift generator used to sample the queues. Each
+ * thread seeds itself with the address of its own state so that threads
+ * spread over different queues without sharing any state.
+ * @param bound Exclusive upper bound
+ * @return Random index in [0, bound)
+ */
+static size_t get_random_index(size_t bound)
+{
+    if (0 == rng_state)
+    {
+        rng_state = (uint64_t)(uintptr_t)& rng_state ^ 0x9E3779B97F4A7C15ULL;
+    }
+
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (size_t)(rng_state % bound);
+}
@@ -0,0 +1,347 @@
+#include <heap_pairing.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct pairing_node_t pairing_node_t;
+typedef struct pairing_node_t
+{
+    pairing_node_t * child;         // Left most child
+    pairing_node_t * sibling;       // Next sibling to the right
+    void * payload;                 // User pointer or pointer to data below
+    uint8_t data[];                 // Payload storage in HEAP_MEM mode
+} pairing_node_t;
+
+typedef struct heap_pairing_t
+{
+    pairing_node_t * root;
+    size_t length;
+    size_t node_size;
+    heap_data_mode_t data_mode;
+
+    heap_compare_t heap_type;
+    heap_compare_t (* compare)(void * payload, void * payload2);
+    void (* destroy)(void * payload);
+} heap_pairing_t;
+
+static pairing_node_t * link_nodes(heap_pairing_t * heap,
+                                   pairing_node_t * left,
+                                   pairing_node_t * right);
+static pairing_node_t * merge_pairs(heap_pairing_t * heap,
+                                    pairing_node_t * first);
+static void * copy_payload(heap_pairing_t * heap, pairing_node_t * node);
+
+/*!
+ * @brief Create a pairing heap.
+ *
+ * A pairing heap is a heap ordered multi way tree. Insert, peek and meld are
+ * O(1) and pop is amortized O(log n). Unlike the array based heap_t, two
+ * pairing heaps can be melded in constant time which makes it the better
+ * choice when heaps built by different workers need to be combined.
+ *
+ * @param type Heap type, max heap_adt or min heap_adt
+ * @param data_mode Data storage strategy
+ * @param payload_size The size of the payload. This can be 0 if using HEAP_PTR
+ * @param destroy Pointer to function that frees the block of memory
+ * @param compare Pointer to function that compares the nodes
+ * @return Pointer to the pairing heap or NULL
+ */
+heap_pairing_t * heap_pairing_init(heap_type_t type,
+                                   heap_data_mode_t data_mode,
+                                   size_t payload_size,
+                                   void (* destroy)(void *),
+                                   heap_compare_t (* compare)(void *, void *))
+{
+    assert(compare);
+
+    heap_pairing_t * heap = (heap_pairing_t *)malloc(sizeof(heap_pairing_t));
+    if (NULL == heap)
+    {
+        fprintf(stderr, "[!] Could not allocate memory!\n");
+        return NULL;
+    }
+
+    * heap = (heap_pairing_t){
+        .root       = NULL,
+        .length     = 0,
+        .node_size  = (HEAP_PTR == data_mode) ? 0 : payload_size,
+        .data_mode  = data_mode,
+        .heap_type  = type ? HEAP_LT : HEAP_GT,
+        .compare    = compare,
+        .destroy    = destroy
+    };
+    return heap;
+}
+
+/*!
+ * @brief Destroy the pairing heap. If in PTR mode then the remaining
+ * payloads are freed with the destroy callback as well
+ * @param heap Pointer to the pairing heap
+ */
+void heap_pairing_destroy(heap_pairing_t * heap)
+{
+    assert(heap);
+
+    // Walk the tree without recursion by rotating children into the sibling
+    // chain, a deep tree can not overflow the stack this way
+    pairing_node_t * node = heap->root;
+    while (NULL != node)
+    {
+        if (NULL != node->child)
+        {
+            pairing_node_t * child = node->child;
+            node->child = child->sibling;
+            child->sibling = node;
+            node = child;
+            continue;
+        }
+
+        pairing_node_t * next = node->sibling;
+        if ((HEAP_PTR == heap->data_mode) && (NULL != heap->destroy))
+        {
+            heap->destroy(node->payload);
+        }
+        free(node);
+        node = next;
+    }
+    free(heap);
+}
+
+/*!
+ * @brief Insert the payload into the pairing heap
+ * @param heap Pointer to the pairing heap
+ * @param payload Pointer to the payload passed in
+ * @return False if the node could not be allocated, the payload is then not
+ * inserted
+ */
+bool heap_pairing_insert(heap_pairing_t * heap, void * payload)
+{
+    assert(heap);
+    assert(payload);
+
+    pairing_node_t * node =
+        (pairing_node_t *)malloc(sizeof(pairing_node_t) + heap->node_size);
+    if (NULL == node)
+    {
+        fprintf(stderr, "[!] Could not allocate memory!\n");
+        return false;
+    }
+
+    node->child = NULL;
+    node->sibling = NULL;
+    if (HEAP_PTR == heap->data_mode)
+    {
+        node->payload = payload;
+    }
+    else
+    {
+        memcpy(node->data, payload, heap->node_size);
+        node->payload = node->data;
+    }
+
+    heap->root = link_nodes(heap, heap->root, node);
+    heap->length++;
+    return true;
+}
+
+/*!
+ * @brief Pop the root value of the pairing heap. In HEAP_MEM mode the
+ * pointer returned must be freed.
+ * @param heap Pointer to the pairing heap
+ * @return Payload or NULL if the heap is empty or the copy could not be
+ * allocated in HEAP_MEM mode, in which case the root stays in the heap
+ */
+void * heap_pairing_pop(heap_pairing_t * heap)
+{
+    assert(heap);
+
+    if (NULL == heap->root)
+    {
+        return NULL;
+    }
+
+    pairing_node_t * root = heap->root;
+    void * payload = copy_payload(heap, root);
+    if (NULL == payload)
+    {
+        return NULL;
+    }
+
+    heap->root = merge_pairs(heap, root->child);
+    heap->length--;
+    free(root);
+    return payload;
+}
+
+/*!
+ * @brief Return the root value of the pairing heap without removing it. In
+ * HEAP_MEM mode the pointer returned is a copy that must be freed.
+ * @param heap Pointer to the pairing heap
+ * @return Payload or NULL if the heap is empty
+ */
+void * heap_pairing_peek(heap_pairing_t * heap)
+{
+    assert(heap);
+
+    if (NULL == heap->root)
+    {
+        return NULL;
+    }
+    return copy_payload(heap, heap->root);
+}
+
+/*!
+ * @brief Move every item of other into heap in O(1). After the call other is
+ * empty and can be reused or destroyed. Both heaps must have been created with
+ * the same type, data mode, payload size and compare function.
+ *
+ * @param heap Pointer to the pairing heap receiving the items
+ * @param other Pointer to the pairing heap giving up its items
+ * @return False if the heaps are not compatible or are the same heap
+ */
+bool heap_pairing_meld(heap_pairing_t * heap, heap_pairing_t * other)
+{
+    assert(heap);
+    assert(other);
+
+    if ((heap == other)
+        || (heap->data_mode != other->data_mode)
+        || (heap->node_size != other->node_size)
+        || (heap->heap_type != other->heap_type)
+        || (heap->compare != other->compare))
+    {
+        return false;
+    }
+
+    heap->root = link_nodes(heap, heap->root, other->root);
+    heap->length += other->length;
+
+    other->root = NULL;
+    other->length = 0;
+    return true;
+}
+
+/*!
+ * @brief Check if the pairing heap is currently empty
+ * @param heap Pointer to the pairing heap
+ * @return bool
+ */
+bool heap_pairing_is_empty(heap_pairing_t * heap)
+{
+    assert(heap);
+    return (NULL == heap->root);
+}
+
+/*!
+ * @brief Return the number of items in the pairing heap
+ * @param heap Pointer to the pairing heap
+ * @return Number of items
+ */
+size_t heap_pairing_get_length(heap_pairing_t * heap)
+{
+    assert(heap);
+    return heap->length;
+}
+
+/*!
+ * @brief Link two trees by making the root that loses the comparison the
+ * left most child of the root that wins it
+ * @param heap Pointer to the pairing heap
+ * @param left Root of the first tree, can be NULL
+ * @param right Root of the second tree, can be NULL
+ * @return Root of the linked tree
+ */
+static pairing_node_t * link_nodes(heap_pairing_t * heap,
+                                   pairing_node_t * left,
+                                   pairing_node_t * right)
+{
+    if (NULL == left)
+    {
+        return right;
+    }
+    if (NULL == right)
+    {
+        return left;
+    }
+
+    if (heap->heap_type == heap->compare(right->payload, left->payload))
+    {
+        pairing_node_t * temp = left;
+        left = right;
+        right = temp;
+    }
+
+    right->sibling = left->child;
+    left->child = right;
+    left->sibling = NULL;
+    return left;
+}
+
+/*!
+ * @brief Standard two pass merge of the children of a removed root. The first
+ * pass links the children in pairs from left to right and the second pass
+ * links the pairs together from right to left. Both passes are iterative.
+ * @param heap Pointer to the pairing heap
+ * @param first Left most child of the removed root
+ * @return New root
+ */
+static pairing_node_t * merge_pairs(heap_pairing_t * heap,
+                                    pairing_node_t * first)
+{
+    // First pass, the linked pairs are pushed onto a stack through the
+    // sibling pointer so the second pass can walk them right to left
+    pairing_node_t * pairs = NULL;
+    while (NULL != first)
+    {
+        pairing_node_t * second = first->sibling;
+        pairing_node_t * next = (NULL != second) ? second->sibling : NULL;
+
+        first->sibling = NULL;
+        if (NULL != second)
+        {
+            second->sibling = NULL;
+        }
+
+        pairing_node_t * pair = link_nodes(heap, first, second);
+        pair->sibling = pairs;
+        pairs = pair;
+        first = next;
+    }
+
+    // Second pass
+    pairing_node_t * root = NULL;
+    while (NULL != pairs)
+    {
+        pairing_node_t * next = pairs->sibling;
+        pairs->sibling = NULL;
+        root = link_nodes(heap, root, pairs);
+        pairs = next;
+    }
+    return root;
+}
+
+/*!
+ * @brief Return the payload of a node in the form handed to the user. In
+ * HEAP_MEM mode this is a newly allocated copy.
+ * @param heap Pointer to the pairing heap
+ * @param node Node to read
+ * @return Payload pointer
+ */
+static void * copy_payload(heap_pairing_t * heap, pairing_node_t * node)
+{
+    if (HEAP_PTR == heap->data_mode)
+    {
+        return node->payload;
+    }
+
+    void * payload = malloc(heap->node_size);
+    if (NULL == payload)
+    {
+        fprintf(stderr, "[!] Could not allocate memory!\n");
+        return NULL;
+    }
+    memcpy(payload, node->data, heap->node_size);
+    return payload;
+}
@@ -0,0 +1,479 @@
+#include <heap_radix.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum
+{
+    RADIX_BUCKETS = 65,             // One bucket per differing bit plus equal
+    RADIX_BASE_SIZE = 4,            // Initial number of entries in a bucket
+} heap_radix_default_t;
+
+// Each bucket is an unordered array of entries. An entry is the cached key
+// followed by the payload (a pointer in HEAP_PTR mode or the data itself)
+typedef struct radix_bucket_t
+{
+    uint8_t * entries;
+    size_t length;
+    size_t size;
+} radix_bucket_t;
+
+typedef struct heap_radix_t
+{
+    radix_bucket_t buckets[RADIX_BUCKETS];
+    size_t length;                  // Number of items across all buckets
+    size_t node_size;               // Size of the payload stored per entry
+    size_t entry_size;              // Size of a key plus payload entry
+    uint64_t last_key;              // Key of the last item popped
+    heap_data_mode_t data_mode;
+
+    uint64_t (* get_key)(void * payload);
+    void (* destroy)(void * payload);
+} heap_radix_t;
+
+static size_t get_bucket_index(uint64_t last_key, uint64_t key);
+static bool push_entry(heap_radix_t * heap,
+                       size_t bucket_index,
+                       uint64_t key,
+                       void * payload);
+static bool reserve_entries(heap_radix_t * heap,
+                            radix_bucket_t * bucket,
+                            size_t count);
+static uint8_t * get_entry(heap_radix_t * heap,
+                           radix_bucket_t * bucket,
+                           size_t index);
+static bool settle_min_bucket(heap_radix_t * heap);
+static size_t find_min_entry(heap_radix_t * heap, uint8_t ** min_entry);
+static void * get_payload(heap_radix_t * heap, uint8_t * entry);
+static void * copy_payload(heap_radix_t * heap, uint8_t * entry);
+
+/*!
+ * @brief Create a radix heap for monotone integer priorities.
+ *
+ * A radix heap is a min heap that only supports keys that are greater or
+ * equal to the key of the last item popped. That is the case for Dijkstra
+ * like searches and discrete event simulations. Items are kept in 65 buckets
+ * based on the highest bit that differs from the last popped key, which gives
+ * an amortized O(log C) cost per item where C is the key range, and in
+ * practice close to O(1) per operation.
+ *
+ * The key of a payload is read with the get_key callback when the payload
+ * is inserted. In HEAP_PTR mode the pointer is stored while in HEAP_MEM mode
+ * payload_size bytes are copied into the heap.
+ *
+ * @param data_mode Data storage strategy
+ * @param payload_size The size of the payload. This can be 0 if using HEAP_PTR
+ * @param destroy Pointer to function that frees the block of memory
+ * @param get_key Pointer to function that returns the priority of a payload
+ * @return Pointer to the radix heap or NULL
+ */
+heap_radix_t * heap_radix_init(heap_data_mode_t data_mode,
+                               size_t payload_size,
+                               void (* destroy)(void *),
+                               uint64_t (* get_key)(void *))
+{
+    assert(get_key);
+
+    heap_radix_t * heap = (heap_radix_t *)calloc(1, sizeof(heap_radix_t));
+    if (NULL == heap)
+    {
+        fprintf(stderr, "[!] Could not allocate memory!\n");
+        return NULL;
+    }
+
+    size_t node_size = (HEAP_PTR == data_mode) ? sizeof(void *) : payload_size;
+
+    // Round the entries up to the key alignment so the keys can be read
+    // directly out of the bucket arrays
+    size_t entry_size = sizeof(uint64_t) + node_size;
+    entry_size = (entry_size + sizeof(uint64_t) - 1)
+        & ~(sizeof(uint64_t) - 1);
+
+    heap->node_size     = node_size;
+    heap->entry_size    = entry_size;
+    heap->data_mode     = data_mode;
+    heap->get_key       = get_key;
+    heap->destroy       = destroy;
+    return heap;
+}
+
+/*!
+ * @brief Destroy the radix heap. If in PTR mode then the remaining payloads
+ * are freed with the destroy callback as well
+ * @param heap Pointer to the radix heap
+ */
+void heap_radix_destroy(heap_radix_t * heap)
+{
+    assert(heap);
+
+    for (size_t index = 0; index < RADIX_BUCKETS; index++)
+    {
+        radix_bucket_t * bucket = &heap->buckets[index];
+        if ((HEAP_PTR == heap->data_mode) && (NULL != heap->destroy))
+        {
+            for (size_t entry = 0; entry < bucket->length; entry++)
+            {
+                heap->destroy(get_payload(heap,
+                                          get_entry(heap, bucket, entry)));
+            }
+        }
+        free(bucket->entries);
+    }
+    free(heap);
+}
+
+/*!
+ * @brief Insert the payload into the radix heap. The key of the payload must
+ * not be smaller than the key of the last popped item.
+ *
+ * @param heap Pointer to the radix heap
+ * @param payload Pointer to the payload passed in
+ * @return False if the key breaks the monotone rule or memory ran out
+ */
+bool heap_radix_insert(heap_radix_t * heap, void * payload)
+{
+    assert(heap);
+    assert(payload);
+
+    uint64_t key = heap->get_key(payload);
+    if (key < heap->last_key)
+    {
+        return false;
+    }
+
+    if (!push_entry(heap, get_bucket_index(heap->last_key, key), key, payload))
+    {
+        return false;
+    }
+    heap->length++;
+    return true;
+}
+
+/*!
+ * @brief Pop the item with the smallest key. Items with equal keys are
+ * returned in no particular order. In HEAP_MEM mode the pointer returned must
+ * be freed.
+ *
+ * @param heap Pointer to the radix heap
+ * @return Payload or NULL if the heap is empty, the buckets could not grow or
+ * the copy could not be allocated in HEAP_MEM mode. The item then stays in the
+ * heap
+ */
+void * heap_radix_pop(heap_radix_t * heap)
+{
+    assert(heap);
+
+    if (!settle_min_bucket(heap))
+    {
+        return NULL;
+    }
+
+    // Copy before shrinking the bucket so a failed copy keeps the entry
+    radix_bucket_t * bucket = &heap->buckets[0];
+    void * payload = copy_payload(heap, get_entry(heap, bucket, bucket->length - 1));
+    if (NULL == payload)
+    {
+        return NULL;
+    }
+    bucket->length--;
+    heap->length--;
+    return payload;
+}
+
+/*!
+ * @brief Return the item with the smallest key without removing it. In
+ * HEAP_MEM mode the pointer returned is a copy that must be freed.
+ *
+ * The buckets are not settled, so the last key stays the key of the last
+ * popped item and any key between it and the peeked key can still be
+ * inserted. The cost is the size of the first non empty bucket.
+ *
+ * @param heap Pointer to the radix heap
+ * @return Payload or NULL if the heap is empty
+ */
+void * heap_radix_peek(heap_radix_t * heap)
+{
+    assert(heap);
+
+    if (0 == heap->length)
+    {
+        return NULL;
+    }
+
+    uint8_t * min_entry;
+    find_min_entry(heap, &min_entry);
+    return copy_payload(heap, min_entry);
+}
+
+/*!
+ * @brief Check if the radix heap is currently empty
+ * @param heap Pointer to the radix heap
+ * @return bool
+ */
+bool heap_radix_is_empty(heap_radix_t * heap)
+{
+    assert(heap);
+    return (0 == heap->length);
+}
+
+/*!
+ * @brief Return the number of items in the radix heap
+ * @param heap Pointer to the radix heap
+ * @return Number of items
+ */
+size_t heap_radix_get_length(heap_radix_t * heap)
+{
+    assert(heap);
+    return heap->length;
+}
+
+/*!
+ * @brief Return the key of the last popped item. This is the smallest key
+ * that may still be inserted.
+ * @param heap Pointer to the radix heap
+ * @return Last popped key, 0 if nothing was popped yet
+ */
+uint64_t heap_radix_get_last_key(heap_radix_t * heap)
+{
+    assert(heap);
+    return heap->last_key;
+}
+
+/*!
+ * @brief Make sure bucket 0 holds the smallest keys.
+ *
+ * If bucket 0 is empty, the first non empty bucket is located and its
+ * smallest key becomes the new last key. Every entry of that bucket is then
+ * redistributed relative to the new last key, which always moves it to a
+ * lower bucket. This is what gives the radix heap its amortized cost since an
+ * entry can only move down 64 times.
+ *
+ * The lower buckets are grown to fit their new entries before anything is
+ * moved, so a failed allocation leaves the heap as it was.
+ *
+ * @param heap Pointer to the radix heap
+ * @return False if the heap is empty or a bucket could not grow
+ */
+static bool settle_min_bucket(heap_radix_t * heap)
+{
+    if (0 == heap->length)
+    {
+        return false;
+    }
+
+    if (0 != heap->buckets[0].length)
+    {
+        return true;
+    }
+
+    uint8_t * min_entry;
+    size_t index = find_min_entry(heap, &min_entry);
+    radix_bucket_t * bucket = &heap->buckets[index];
+    uint64_t min_key;
+    memcpy(&min_key, min_entry, sizeof(uint64_t));
+
+    size_t counts[RADIX_BUCKETS] = {0};
+    for (size_t entry = 0; entry < bucket->length; entry++)
+    {
+        uint64_t key;
+        memcpy(&key, get_entry(heap, bucket, entry), sizeof(uint64_t));
+        counts[get_bucket_index(min_key, key)]++;
+    }
+    for (size_t target = 0; target < index; target++)
+    {
+        if ((0 != counts[target])
+            && !reserve_entries(heap, &heap->buckets[target], counts[target]))
+        {
+            return false;
+        }
+    }
+    heap->last_key = min_key;
+
+    // Redistribute. Entries only move to lower buckets so the bucket being
+    // drained is never written to while it is read, and the room reserved
+    // above means the pushes can not fail
+    for (size_t entry = 0; entry < bucket->length; entry++)
+    {
+        uint8_t * slice = get_entry(heap, bucket, entry);
+        uint64_t key;
+        memcpy(&key, slice, sizeof(uint64_t));
+        push_entry(heap,
+                   get_bucket_index(min_key, key),
+                   key,
+                   get_payload(heap, slice));
+    }
+    bucket->length = 0;
+    return true;
+}
+
+/*!
+ * @brief Locate the entry with the smallest key, which is in the first non
+ * empty bucket. Any entry of bucket 0 will do since they all hold the last key
+ * @param heap Pointer to a radix heap that is not empty
+ * @param min_entry Set to the entry with the smallest key
+ * @return Index of the first non empty bucket
+ */
+static size_t find_min_entry(heap_radix_t * heap, uint8_t ** min_entry)
+{
+    size_t index = 0;
+    while (0 == heap->buckets[index].length)
+    {
+        index++;
+    }
+
+    radix_bucket_t * bucket = &heap->buckets[index];
+    uint8_t * best = get_entry(heap, bucket, bucket->length - 1);
+    uint64_t min_key;
+    memcpy(&min_key, best, sizeof(uint64_t));
+    for (size_t entry = 0; (0 != index) && (entry < bucket->length); entry++)
+    {
+        uint8_t * slice = get_entry(heap, bucket, entry);
+        uint64_t key;
+        memcpy(&key, slice, sizeof(uint64_t));
+        if (key < min_key)
+        {
+            min_key = key;
+            best = slice;
+        }
+    }
+    * min_entry = best;
+    return index;
+}
+
+/*!
+ * @brief Append an entry to the bucket, growing the bucket if needed
+ * @param heap Pointer to the radix heap
+ * @param bucket_index Index of the bucket to append to
+ * @param key Cached key of the payload
+ * @param payload Pointer to the payload
+ * @return False if the bucket could not grow
+ */
+static bool push_entry(heap_radix_t * heap,
+                       size_t bucket_index,
+                       uint64_t key,
+                       void * payload)
+{
+    radix_bucket_t * bucket = &heap->buckets[bucket_index];
+    if (!reserve_entries(heap, bucket, 1))
+    {
+        return false;
+    }
+
+    uint8_t * slice = get_entry(heap, bucket, bucket->length);
+    memcpy(slice, &key, sizeof(uint64_t));
+    if (HEAP_PTR == heap->data_mode)
+    {
+        memcpy(slice + sizeof(uint64_t), &payload, sizeof(void *));
+    }
+    else
+    {
+        memcpy(slice + sizeof(uint64_t), payload, heap->node_size);
+    }
+    bucket->length++;
+    return true;
+}
+
+/*!
+ * @brief Grow the bucket, doubling its size, until count more entries fit
+ * @param heap Pointer to the radix heap
+ * @param bucket Bucket to grow
+ * @param count Number of entries about to be appended
+ * @return False if the bucket could not grow
+ */
+static bool reserve_entries(heap_radix_t * heap,
+                            radix_bucket_t * bucket,
+                            size_t count)
+{
+    if (bucket->length + count <= bucket->size)
+    {
+        return true;
+    }
+
+    size_t size = (0 == bucket->size) ? RADIX_BASE_SIZE : bucket->size;
+    while (size < bucket->length + count)
+    {
+        size *= 2;
+    }
+    uint8_t * re_alloc = realloc(bucket->entries, size * heap->entry_size);
+    if (NULL == re_alloc)
+    {
+        fprintf(stderr, "[!] Could not reallocate memory for radix heap!\n");
+        return false;
+    }
+    bucket->entries = re_alloc;
+    bucket->size = size;
+    return true;
+}
+
+/*!
+ * @brief The bucket of a key is the position of the highest bit that differs
+ * from the last popped key. Keys equal to the last key go to bucket 0.
+ * @param last_key Key of the last popped item
+ * @param key Key to place
+ * @return Bucket index
+ */
+static size_t get_bucket_index(uint64_t last_key, uint64_t key)
+{
+    if (key == last_key)
+    {
+        return 0;
+    }
+    return (size_t)(64 - __builtin_clzll(key ^ last_key));
+}
+
+/*!
+ * @brief Performs the pointer arithmetic for indexing a bucket
+ * @param heap Pointer to the radix heap
+ * @param bucket Bucket to index
+ * @param index Index of the entry
+ * @return Pointer to the start of the entry
+ */
+static uint8_t * get_entry(heap_radix_t * heap,
+                           radix_bucket_t * bucket,
+                           size_t index)
+{
+    return bucket->entries + (index * heap->entry_size);
+}
+
+/*!
+ * @brief Return the payload stored in an entry. This is the stored pointer in
+ * HEAP_PTR mode or a pointer to the stored data in HEAP_MEM mode
+ * @param heap Pointer to the radix heap
+ * @param entry Pointer to the entry
+ * @return Payload pointer
+ */
+static void * get_payload(heap_radix_t * heap, uint8_t * entry)
+{
+    if (HEAP_PTR == heap->data_mode)
+    {
+        void * payload;
+        memcpy(&payload, entry + sizeof(uint64_t), sizeof(void *));
+        return payload;
+    }
+    return entry + sizeof(uint64_t);
+}
+
+/*!
+ * @brief Return the payload of an entry in the form handed to the user. In
+ * HEAP_MEM mode this is a newly allocated copy.
+ * @param heap Pointer to the radix heap
+ * @param entry Pointer to the entry
+ * @return Payload pointer
+ */
+static void * copy_payload(heap_radix_t * heap, uint8_t * entry)
+{
+    if (HEAP_PTR == heap->data_mode)
+    {
+        return get_payload(heap, entry);
+    }
+
+    void * payload = malloc(heap->node_size);
+    if (NULL == payload)
+    {
+        fprintf(stderr, "[!] Could not allocate memory!\n");
+        return NULL;
+    }
+    memcpy(payload, entry + sizeof(uint64_t), heap->node_size);
+    return payload;
+}
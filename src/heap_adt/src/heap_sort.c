@@ -0,0 +1,401 @@
+#include <heap.h>
+#include <thread_pool.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum
+{
+    SORT_SERIAL_CUTOFF = 1 << 15,   // Inputs smaller than this are sorted in place
+} heap_sort_default_t;
+
+// State shared by every task of the parallel sort
+typedef struct sort_context_t
+{
+    uint8_t * source;               // Runs being read by the current pass
+    uint8_t * target;               // Runs being written by the current pass
+    size_t item_count;
+    size_t width;                   // Bytes per item, a pointer in HEAP_PTR mode
+    size_t run_length;              // Length of the sorted runs in source
+    size_t segments;                // Tasks that share one pair of runs
+    size_t copy_tasks;              // Tasks used to copy the result back
+    heap_data_mode_t data_mode;
+
+    heap_compare_t order;           // HEAP_LT for ascending, HEAP_GT descending
+    heap_compare_t (* compare)(void *, void *);
+} sort_context_t;
+
+static void sort_in_place(sort_context_t * context,
+                          uint8_t * base,
+                          size_t count,
+                          uint8_t * temp);
+static void sift_down(sort_context_t * context,
+                      uint8_t * base,
+                      size_t root,
+                      size_t end,
+                      uint8_t * temp);
+static size_t co_rank(sort_context_t * context,
+                      uint8_t * left,
+                      size_t left_count,
+                      uint8_t * right,
+                      size_t right_count,
+                      size_t rank);
+static void sort_chunk_task(void * context, size_t task_index, size_t thread_index);
+static void merge_task(void * context, size_t task_index, size_t thread_index);
+static void copy_task(void * context, size_t task_index, size_t thread_index);
+static bool comes_before(sort_context_t * context, uint8_t * left, uint8_t * right);
+static void * get_payload(sort_context_t * context, uint8_t * slot);
+
+/*!
+ * @brief Sort the array passed in using a pool of threads.
+ *
+ * The array is split into one chunk per thread (rounded up to a power of two)
+ * and each chunk is heap sorted in place in parallel. The sorted chunks are
+ * then merged pairwise into a scratch buffer. Every merge is further split
+ * with a binary search on the merge path so that all threads stay busy even in
+ * the last passes where only one or two pairs are left.
+ *
+ * Inputs smaller than a few ten thousand items, a thread_count of 1, or a
+ * failure to allocate the O(n) scratch buffer fall back to a serial in place
+ * heap sort. The arguments and resulting order match heap_sort: MIN_HEAP
+ * sorts in ascending order and MAX_HEAP in descending order. The sort is not
+ * stable.
+ *
+ * @param array Array of pointers (HEAP_PTR) or of items (HEAP_MEM)
+ * @param item_count Number of items in the array
+ * @param item_size Size of an item, ignored in HEAP_PTR mode
+ * @param data_mode Data storage strategy of the array
+ * @param type MIN_HEAP for ascending order or MAX_HEAP for descending order
+ * @param compare Pointer to function that compares the items
+ * @param thread_count Number of threads to use, 0 for one per online cpu
+ */
+void heap_sort_parallel(void * array,
+                        size_t item_count,
+                        size_t item_size,
+                        heap_data_mode_t data_mode,
+                        heap_type_t type,
+                        heap_compare_t (* compare)(void *, void *),
+                        size_t thread_count)
+{
+    assert(array);
+    assert(compare);
+
+    sort_context_t context = {
+        .source     = (uint8_t *)array,
+        .item_count = item_count,
+        .width      = (HEAP_PTR == data_mode) ? sizeof(void *) : item_size,
+        .data_mode  = data_mode,
+        .order      = (MIN_HEAP == type) ? HEAP_LT : HEAP_GT,
+        .compare    = compare
+    };
+
+    if (0 == thread_count)
+    {
+        thread_count = thread_pool_get_cpu_count();
+    }
+
+    uint8_t * temp = (uint8_t *)malloc(context.width);
+    if (NULL == temp)
+    {
+        fprintf(stderr, "[!] Could not allocate memory!\n");
+        return;
+    }
+
+    uint8_t * buffer = NULL;
+    thread_pool_t * pool = NULL;
+    if ((item_count >= SORT_SERIAL_CUTOFF) && (thread_count > 1))
+    {
+        buffer = (uint8_t *)malloc(item_count * context.width);
+        pool = (NULL != buffer) ? thread_pool_init(thread_count) : NULL;
+    }
+
+    if (NULL == pool)
+    {
+        sort_in_place(&context, context.source, item_count, temp);
+        free(buffer);
+        free(temp);
+        return;
+    }
+    free(temp);
+
+    // Sort the chunks in place, one chunk per task. A power of two count
+    // keeps every merge pass pairing up runs of equal length.
+    size_t chunk_count = 1;
+    while (chunk_count < thread_count)
+    {
+        chunk_count *= 2;
+    }
+    context.run_length = (item_count + chunk_count - 1) / chunk_count;
+    thread_pool_run(pool, chunk_count, sort_chunk_task, &context);
+
+    // Merge runs pairwise, swapping the source and target every pass
+    context.target = buffer;
+    while (context.run_length < item_count)
+    {
+        size_t pair_length = context.run_length * 2;
+        size_t pair_count = (item_count + pair_length - 1) / pair_length;
+        context.segments = (thread_count + pair_count - 1) / pair_count;
+
+        thread_pool_run(pool, pair_count * context.segments, merge_task, &context);
+
+        uint8_t * swap = context.source;
+        context.source = context.target;
+        context.target = swap;
+        context.run_length = pair_length;
+    }
+
+    // The result may have ended in the scratch buffer
+    if (context.source != (uint8_t *)array)
+    {
+        context.target = (uint8_t *)array;
+        context.copy_tasks = thread_count;
+        thread_pool_run(pool, context.copy_tasks, copy_task, &context);
+    }
+
+    thread_pool_destroy(pool);
+    free(buffer);
+}
+
+/*!
+ * @brief Task that heap sorts one chunk of the array in place
+ */
+static void sort_chunk_task(void * context, size_t task_index, size_t thread_index)
+{
+    (void)thread_index;
+    sort_context_t * sort = (sort_context_t *)context;
+
+    size_t start = task_index * sort->run_length;
+    if (start >= sort->item_count)
+    {
+        return;
+    }
+    size_t count = sort->item_count - start;
+    if (count > sort->run_length)
+    {
+        count = sort->run_length;
+    }
+
+    uint8_t * temp = (uint8_t *)malloc(sort->width);
+    if (NULL == temp)
+    {
+        fprintf(stderr, "[!] Could not allocate memory!\n");
+        abort();
+    }
+    sort_in_place(sort, sort->source + (start * sort->width), count, temp);
+    free(temp);
+}
+
+/*!
+ * @brief Task that merges one segment of a pair of runs. The segment is a
+ * slice of the merged output whose matching input ranges are located with the
+ * co_rank binary search.
+ */
+static void merge_task(void * context, size_t task_index, size_t thread_index)
+{
+    (void)thread_index;
+    sort_context_t * sort = (sort_context_t *)context;
+
+    size_t pair = task_index / sort->segments;
+    size_t segment = task_index % sort->segments;
+
+    size_t low = pair * sort->run_length * 2;
+    size_t mid = low + sort->run_length;
+    size_t high = mid + sort->run_length;
+    mid = (mid > sort->item_count) ? sort->item_count : mid;
+    high = (high > sort->item_count) ? sort->item_count : high;
+
+    uint8_t * left = sort->source + (low * sort->width);
+    uint8_t * right = sort->source + (mid * sort->width);
+    size_t left_count = mid - low;
+    size_t right_count = high - mid;
+    size_t total = high - low;
+
+    size_t first = (total * segment) / sort->segments;
+    size_t last = (total * (segment + 1)) / sort->segments;
+
+    size_t left_index = co_rank(sort, left, left_count, right, right_count, first);
+    size_t right_index = first - left_index;
+    size_t left_end = co_rank(sort, left, left_count, right, right_count, last);
+    size_t right_end = last - left_end;
+
+    uint8_t * out = sort->target + ((low + first) * sort->width);
+    while ((left_index < left_end) || (right_index < right_end))
+    {
+        uint8_t * left_slot = left + (left_index * sort->width);
+        uint8_t * right_slot = right + (right_index * sort->width);
+
+        // Prefer the left run on ties
+        bool take_right = (left_index == left_end)
+            || ((right_index < right_end)
+                && comes_before(sort, right_slot, left_slot));
+        if (take_right)
+        {
+            memcpy(out, right_slot, sort->width);
+            right_index++;
+        }
+        else
+        {
+            memcpy(out, left_slot, sort->width);
+            left_index++;
+        }
+        out += sort->width;
+    }
+}
+
+/*!
+ * @brief Task that copies one slice of the result back into the user array
+ */
+static void copy_task(void * context, size_t task_index, size_t thread_index)
+{
+    (void)thread_index;
+    sort_context_t * sort = (sort_context_t *)context;
+
+    size_t first = (sort->item_count * task_index) / sort->copy_tasks;
+    size_t last = (sort->item_count * (task_index + 1)) / sort->copy_tasks;
+    memcpy(sort->target + (first * sort->width),
+           sort->source + (first * sort->width),
+           (last - first) * sort->width);
+}
+
+/*!
+ * @brief Return how many items of the left run are among the first rank items
+ * of the merged output. With ties the left run goes first which keeps the
+ * segments of a merge consistent with each other.
+ *
+ * @param context Sort context
+ * @param left First sorted run
+ * @param left_count Number of items in the left run
+ * @param right Second sorted run
+ * @param right_count Number of items in the right run
+ * @param rank Number of items of the merged output
+ * @return Number of items taken from the left run
+ */
+static size_t co_rank(sort_context_t * context,
+                      uint8_t * left,
+                      size_t left_count,
+                      uint8_t * right,
+                      size_t right_count,
+                      size_t rank)
+{
+    size_t low = (rank > right_count) ? rank - right_count : 0;
+    size_t high = (rank < left_count) ? rank : left_count;
+
+    while (low < high)
+    {
+        size_t index = low + ((high - low) / 2);
+        size_t other = rank - index;
+
+        // If left[index] is not after right[other - 1] it belongs to the
+        // output prefix, so more items must come from the left run
+        if (!comes_before(context,
+                          right + ((other - 1) * context->width),
+                          left + (index * context->width)))
+        {
+            low = index + 1;
+        }
+        else
+        {
+            high = index;
+        }
+    }
+    return low;
+}
+
+/*!
+ * @brief Classic in place heap sort. The heap keeps the item that belongs
+ * last at the root, which is then swapped to the end of the range.
+ * @param context Sort context
+ * @param base Start of the range
+ * @param count Number of items in the range
+ * @param temp Scratch space for one item
+ */
+static void sort_in_place(sort_context_t * context,
+                          uint8_t * base,
+                          size_t count,
+                          uint8_t * temp)
+{
+    if (count < 2)
+    {
+        return;
+    }
+
+    for (size_t index = count / 2; index > 0; index--)
+    {
+        sift_down(context, base, index - 1, count, temp);
+    }
+
+    for (size_t end = count - 1; end > 0; end--)
+    {
+        memcpy(temp, base, context->width);
+        memcpy(base, base + (end * context->width), context->width);
+        memcpy(base + (end * context->width), temp, context->width);
+        sift_down(context, base, 0, end, temp);
+    }
+}
+
+/*!
+ * @brief Move the item at root down until both children come before it
+ * @param context Sort context
+ * @param base Start of the range
+ * @param root Index of the item to move
+ * @param end Number of items in the heap
+ * @param temp Scratch space for one item
+ */
+static void sift_down(sort_context_t * context,
+                      uint8_t * base,
+                      size_t root,
+                      size_t end,
+                      uint8_t * temp)
+{
+    size_t width = context->width;
+    size_t child = (root * 2) + 1;
+    while (child < end)
+    {
+        // Pick the child that belongs later in the output
+        if (((child + 1) < end)
+            && comes_before(context,
+                            base + (child * width),
+                            base + ((child + 1) * width)))
+        {
+            child++;
+        }
+
+        if (!comes_before(context, base + (root * width), base + (child * width)))
+        {
+            return;
+        }
+
+        memcpy(temp, base + (root * width), width);
+        memcpy(base + (root * width), base + (child * width), width);
+        memcpy(base + (child * width), temp, width);
+
+        root = child;
+        child = (root * 2) + 1;
+    }
+}
+
+/*!
+ * @brief Return true if the left slot strictly belongs before the right slot
+ */
+static bool comes_before(sort_context_t * context, uint8_t * left, uint8_t * right)
+{
+    return (context->order == context->compare(get_payload(context, left),
+                                               get_payload(context, right)));
+}
+
+/*!
+ * @brief Return the value handed to the compare callback for a slot. This is
+ * the stored pointer in HEAP_PTR mode or the slot itself in HEAP_MEM mode.
+ */
+static void * get_payload(sort_context_t * context, uint8_t * slot)
+{
+    if (HEAP_PTR == context->data_mode)
+    {
+        void * payload;
+        memcpy(&payload, slot, sizeof(void *));
+        return payload;
+    }
+    return slot;
+}
@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 #include <heap.h>
+#include <algorithm>
+#include <random>
+#include <vector>
 
 /*
  * Heap structure supports printing your data by passing a callback to a
@@ -296,6 +299,70 @@ TEST(HeapSort, HeapSortTestPtrModeMax)
     free(int_ptr_array);
 }
 
+// Large enough to take the parallel path with an uneven tail so the last
+// chunk and the last merge pair are shorter than the others
+TEST(HeapSortParallel, MemModeMatchesStdSort)
+{
+    const size_t array_length = 200003;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int32_t> dist(-5000, 5000);
+    std::vector<int32_t> values(array_length);
+    for (size_t i = 0; i < array_length; i++)
+    {
+        values[i] = dist(rng);
+    }
+    std::vector<int32_t> expected = values;
+    std::sort(expected.begin(), expected.end());
+
+    heap_sort_parallel(values.data(), array_length, sizeof(int32_t), HEAP_MEM,
+                       MIN_HEAP, heap_data_cmp, 4);
+    EXPECT_EQ(values, expected);
+
+    // Sort descending with a thread count that is not a power of two
+    heap_sort_parallel(values.data(), array_length, sizeof(int32_t), HEAP_MEM,
+                       MAX_HEAP, heap_data_cmp, 3);
+    std::reverse(expected.begin(), expected.end());
+    EXPECT_EQ(values, expected);
+}
+
+TEST(HeapSortParallel, PtrModeMatchesStdSort)
+{
+    const size_t array_length = 100000;
+    std::mt19937 rng(11);
+    std::vector<int *> pointers(array_length);
+    std::vector<int> expected(array_length);
+    for (size_t i = 0; i < array_length; i++)
+    {
+        expected[i] = (int)(rng() % 100000);
+        pointers[i] = create_heap_payload(expected[i]);
+    }
+    std::sort(expected.begin(), expected.end());
+
+    heap_sort_parallel(pointers.data(), array_length, 0, HEAP_PTR, MIN_HEAP,
+                       heap_ptr_cmp, 0);
+
+    for (size_t i = 0; i < array_length; i++)
+    {
+        EXPECT_EQ(*pointers[i], expected[i]);
+        free(pointers[i]);
+    }
+}
+
+// Small inputs fall back to the serial in place sort
+TEST(HeapSortParallel, SmallInputFallback)
+{
+    int array_length = 10;
+    int my_array[] = {5, 8, 2, 8, 9, 2, 3, 40, 1, 78};
+    int my_array_order[] = {1, 2, 2, 3, 5, 8, 8, 9, 40, 78};
+    heap_sort_parallel(&my_array, array_length, sizeof(int), HEAP_MEM,
+                       MIN_HEAP, heap_ptr_cmp, 8);
+
+    for (int i = 0; i < array_length; i++)
+    {
+        EXPECT_EQ(my_array[i], my_array_order[i]);
+    }
+}
+
 /*
  * Test the ability to find the nth item in the heap_adt. The array passed in is
  * first heapafied
@@ -334,3 +401,290 @@ TEST_F(HeapTestFixture, TestFindValue)
     EXPECT_EQ(heap_in_heap(max_heap_data, (void*)&val), true);
 
 }
+
+/*
+ * Reserving capacity up front should prevent any reallocation while the heap
+ * stays below the reserved size and the reserve becomes the shrink floor
+ */
+TEST(HeapCapacity, ReserveKeepsCapacity)
+{
+    heap_t * heap = heap_init(MIN_HEAP, HEAP_MEM, sizeof(int32_t), nullptr,
+                              heap_data_cmp);
+    ASSERT_NE(heap, nullptr);
+    ASSERT_TRUE(heap_reserve(heap, 100));
+    EXPECT_EQ(heap_get_capacity(heap), 100);
+
+    for (int32_t i = 0; i < 100; i++)
+    {
+        heap_insert(heap, &i);
+    }
+    EXPECT_EQ(heap_get_capacity(heap), 100);
+
+    while (!heap_is_empty(heap))
+    {
+        free(heap_pop(heap));
+    }
+    EXPECT_EQ(heap_get_capacity(heap), 100);
+    heap_destroy(heap);
+}
+
+/*
+ * A heap that oscillates around a power of two boundary must not resize on
+ * every push/pop pair with the default hysteresis policy
+ */
+TEST(HeapCapacity, HysteresisAvoidsThrash)
+{
+    heap_t * heap = heap_init(MIN_HEAP, HEAP_MEM, sizeof(int32_t), nullptr,
+                              heap_data_cmp);
+    ASSERT_NE(heap, nullptr);
+
+    // Fill to the point where the array just doubled
+    int32_t value = 0;
+    for (; value < 11; value++)
+    {
+        heap_insert(heap, &value);
+    }
+    size_t capacity = heap_get_capacity(heap);
+
+    for (int round = 0; round < 10; round++)
+    {
+        free(heap_pop(heap));
+        EXPECT_EQ(heap_get_capacity(heap), capacity);
+        heap_insert(heap, &value);
+        EXPECT_EQ(heap_get_capacity(heap), capacity);
+    }
+
+    // Draining the heap releases the capacity back to the base size
+    while (!heap_is_empty(heap))
+    {
+        free(heap_pop(heap));
+    }
+    EXPECT_LT(heap_get_capacity(heap), capacity);
+    heap_destroy(heap);
+}
+
+// Never shrinking keeps the high water mark of the heap
+TEST(HeapCapacity, ShrinkNever)
+{
+    heap_t * heap = heap_init(MAX_HEAP, HEAP_MEM, sizeof(int32_t), nullptr,
+                              heap_data_cmp);
+    ASSERT_NE(heap, nullptr);
+    heap_set_shrink_policy(heap, HEAP_SHRINK_NEVER);
+
+    for (int32_t i = 0; i < 64; i++)
+    {
+        heap_insert(heap, &i);
+    }
+    size_t capacity = heap_get_capacity(heap);
+    while (!heap_is_empty(heap))
+    {
+        free(heap_pop(heap));
+    }
+    EXPECT_EQ(heap_get_capacity(heap), capacity);
+    heap_destroy(heap);
+}
+
+/*
+ * The top-K accumulator keeps only the K best items of a stream and hands
+ * them back sorted from best to weakest
+ */
+TEST(HeapTopK, KeepLargestMemMode)
+{
+    heap_topk_t * topk = heap_topk_init(10, MAX_HEAP, HEAP_MEM,
+                                        sizeof(int32_t), nullptr,
+                                        heap_data_cmp);
+    ASSERT_NE(topk, nullptr);
+
+    // Stream the values 0..999 in a scrambled order
+    for (int32_t i = 0; i < 1000; i++)
+    {
+        int32_t value = (i * 389) % 1000;
+        heap_topk_push(topk, &value);
+    }
+    EXPECT_EQ(heap_topk_get_length(topk), 10);
+
+    size_t count = 0;
+    int32_t * sorted = (int32_t *)heap_topk_get_sorted(topk, &count);
+    ASSERT_EQ(count, 10);
+    for (size_t i = 0; i < count; i++)
+    {
+        EXPECT_EQ(sorted[i], 999 - (int32_t)i);
+    }
+    free(sorted);
+    EXPECT_EQ(heap_topk_get_length(topk), 0);
+    heap_topk_destroy(topk);
+}
+
+// Partial results from two accumulators merge into the global top-K
+TEST(HeapTopK, MergeSmallestPtrMode)
+{
+    heap_topk_t * left = heap_topk_init(5, MIN_HEAP, HEAP_PTR, 0,
+                                        payload_destroy, heap_ptr_cmp);
+    heap_topk_t * right = heap_topk_init(5, MIN_HEAP, HEAP_PTR, 0,
+                                         payload_destroy, heap_ptr_cmp);
+    ASSERT_NE(left, nullptr);
+    ASSERT_NE(right, nullptr);
+
+    for (int i = 0; i < 100; i++)
+    {
+        heap_topk_t * target = (i % 2) ? left : right;
+        int * payload = create_heap_payload(100 - i);
+        if (!heap_topk_push(target, payload))
+        {
+            payload_destroy(payload);
+        }
+    }
+
+    // An accumulator can not be merged into itself
+    EXPECT_FALSE(heap_topk_merge(left, left));
+    EXPECT_EQ(heap_topk_get_length(left), 5);
+
+    ASSERT_TRUE(heap_topk_merge(left, right));
+    EXPECT_EQ(heap_topk_get_length(right), 0);
+
+    size_t count = 0;
+    int ** sorted = (int **)heap_topk_get_sorted(left, &count);
+    ASSERT_EQ(count, 5);
+    for (size_t i = 0; i < count; i++)
+    {
+        EXPECT_EQ(* sorted[i], (int)i + 1);
+        payload_destroy(sorted[i]);
+    }
+    free(sorted);
+
+    heap_topk_destroy(left);
+    heap_topk_destroy(right);
+}
+
+// Records larger than a pointer must survive a round trip in HEAP_MEM mode
+TEST(HeapTopK, LargeRecords)
+{
+    typedef struct
+    {
+        int32_t score;
+        char name[28];
+    } record_t;
+
+    heap_topk_t * topk = heap_topk_init(3, MAX_HEAP, HEAP_MEM,
+                                        sizeof(record_t), nullptr,
+                                        heap_data_cmp);
+    ASSERT_NE(topk, nullptr);
+    for (int32_t i = 0; i < 20; i++)
+    {
+        record_t record = {};
+        record.score = i;
+        snprintf(record.name, sizeof(record.name), "record-%d", i);
+        heap_topk_push(topk, &record);
+    }
+
+    size_t count = 0;
+    record_t * sorted = (record_t *)heap_topk_get_sorted(topk, &count);
+    ASSERT_EQ(count, 3);
+    EXPECT_EQ(sorted[0].score, 19);
+    EXPECT_STREQ(sorted[0].name, "record-19");
+    EXPECT_STREQ(sorted[2].name, "record-17");
+
+    // The same records popped straight from a heap_adt
+    heap_t * heap = heap_init(MAX_HEAP, HEAP_MEM, sizeof(record_t), nullptr,
+                              heap_data_cmp);
+    for (size_t i = 0; i < count; i++)
+    {
+        heap_insert(heap, &sorted[i]);
+    }
+    record_t * top = (record_t *)heap_pop(heap);
+    EXPECT_STREQ(top->name, "record-19");
+    free(top);
+    heap_destroy(heap);
+
+    free(sorted);
+    heap_topk_destroy(topk);
+}
+
+/*
+ * Meld a handful of items into a large heap_adt, which bubbles up each item,
+ * and a large heap_adt into a small one, which heapifies the whole array. Both
+ * must pop in order.
+ */
+TEST(HeapMeld, MemModeBothStrategies)
+{
+    std::mt19937 rng(3);
+    for (size_t small_count : {3, 2000})
+    {
+        heap_t * heap = heap_init(MIN_HEAP, HEAP_MEM, sizeof(int32_t), nullptr,
+                                  heap_data_cmp);
+        heap_t * other = heap_init(MIN_HEAP, HEAP_MEM, sizeof(int32_t), nullptr,
+                                   heap_data_cmp);
+        std::vector<int32_t> expected;
+        for (size_t i = 0; i < 1000; i++)
+        {
+            int32_t value = (int32_t)(rng() % 10000);
+            heap_insert(heap, &value);
+            expected.push_back(value);
+        }
+        for (size_t i = 0; i < small_count; i++)
+        {
+            int32_t value = (int32_t)(rng() % 10000);
+            heap_insert(other, &value);
+            expected.push_back(value);
+        }
+        std::sort(expected.begin(), expected.end());
+
+        ASSERT_TRUE(heap_meld(heap, other));
+        EXPECT_TRUE(heap_is_empty(other));
+
+        for (int32_t value : expected)
+        {
+            int32_t * top = (int32_t *)heap_pop(heap);
+            ASSERT_EQ(*top, value);
+            free(top);
+        }
+        EXPECT_TRUE(heap_is_empty(heap));
+
+        // The emptied heap_adt can be filled again
+        int32_t value = 7;
+        heap_insert(other, &value);
+        int32_t * top = (int32_t *)heap_peek(other);
+        EXPECT_EQ(*top, 7);
+        free(top);
+
+        heap_destroy(heap);
+        heap_destroy(other);
+    }
+}
+
+// In PTR mode the receiving heap_adt takes ownership of the pointers
+TEST(HeapMeld, PtrModeOwnership)
+{
+    heap_t * heap = heap_init(MAX_HEAP, HEAP_PTR, 0, free, heap_ptr_cmp);
+    heap_t * other = heap_init(MAX_HEAP, HEAP_PTR, 0, free, heap_ptr_cmp);
+    for (int i = 0; i < 10; i++)
+    {
+        heap_insert((i % 2) ? heap : other, create_heap_payload(i));
+    }
+
+    ASSERT_TRUE(heap_meld(heap, other));
+    int * top = (int *)heap_pop(heap);
+    EXPECT_EQ(*top, 9);
+    free(top);
+
+    heap_destroy(other);
+    heap_destroy(heap);
+}
+
+TEST(HeapMeld, RejectIncompatible)
+{
+    heap_t * heap = heap_init(MAX_HEAP, HEAP_MEM, sizeof(int32_t), nullptr,
+                              heap_data_cmp);
+    heap_t * other = heap_init(MIN_HEAP, HEAP_MEM, sizeof(int32_t), nullptr,
+                               heap_data_cmp);
+    int32_t value = 1;
+    heap_insert(other, &value);
+
+    EXPECT_FALSE(heap_meld(heap, other));
+    EXPECT_FALSE(heap_meld(heap, heap));
+    EXPECT_TRUE(heap_is_empty(heap));
+    EXPECT_FALSE(heap_is_empty(other));
+
+    heap_destroy(heap);
+    heap_destroy(other);
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <heap_indexed.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// Test that ids come out in key order
+TEST(HeapIndexed, PopOrder)
+{
+    size_t id_count = 1000;
+    heap_indexed_t * heap = heap_indexed_init(id_count);
+    ASSERT_NE(heap, nullptr);
+
+    std::mt19937_64 rng(7);
+    std::vector<uint64_t> keys(id_count);
+    for (size_t id = 0; id < id_count; id++)
+    {
+        keys[id] = rng() % 500;
+        EXPECT_TRUE(heap_indexed_push(heap, id, keys[id]));
+    }
+    EXPECT_FALSE(heap_indexed_push(heap, 0, 0));
+    EXPECT_EQ(id_count, heap_indexed_get_length(heap));
+
+    std::vector<uint64_t> sorted = keys;
+    std::sort(sorted.begin(), sorted.end());
+    for (size_t index = 0; index < id_count; index++)
+    {
+        uint64_t key = 0;
+        size_t id = heap_indexed_pop(heap, &key);
+        EXPECT_EQ(sorted[index], key);
+        EXPECT_EQ(keys[id], key);
+        EXPECT_FALSE(heap_indexed_contains(heap, id));
+    }
+    EXPECT_TRUE(heap_indexed_is_empty(heap));
+    EXPECT_EQ(SIZE_MAX, heap_indexed_pop(heap, nullptr));
+
+    heap_indexed_destroy(heap);
+}
+
+// Test that lowering a key moves the id ahead and that higher keys are ignored
+TEST(HeapIndexed, DecreaseKey)
+{
+    heap_indexed_t * heap = heap_indexed_init(10);
+    ASSERT_NE(heap, nullptr);
+
+    for (size_t id = 0; id < 10; id++)
+    {
+        heap_indexed_push(heap, id, 100 + id);
+    }
+
+    EXPECT_TRUE(heap_indexed_decrease_key(heap, 7, 5));
+    EXPECT_FALSE(heap_indexed_decrease_key(heap, 3, 200));
+    EXPECT_TRUE(heap_indexed_decrease_key(heap, 9, 50));
+
+    uint64_t key = 0;
+    EXPECT_EQ(7, heap_indexed_peek(heap, &key));
+    EXPECT_EQ(5, key);
+    EXPECT_EQ(7, heap_indexed_pop(heap, &key));
+    EXPECT_EQ(9, heap_indexed_pop(heap, &key));
+    EXPECT_EQ(50, key);
+    EXPECT_EQ(0, heap_indexed_pop(heap, &key));
+    EXPECT_FALSE(heap_indexed_decrease_key(heap, 0, 1));
+
+    // A cleared heap accepts the same ids again
+    heap_indexed_clear(heap);
+    EXPECT_TRUE(heap_indexed_is_empty(heap));
+    for (size_t id = 0; id < 10; id++)
+    {
+        EXPECT_FALSE(heap_indexed_contains(heap, id));
+        EXPECT_TRUE(heap_indexed_push(heap, id, 10 - id));
+    }
+    EXPECT_EQ(9, heap_indexed_pop(heap, &key));
+
+    heap_indexed_destroy(heap);
+}
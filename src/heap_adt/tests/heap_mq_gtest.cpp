@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <heap_mq.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/*
+ * Compare function shared by both data modes since both hand the compare
+ * function a pointer to the int
+ */
+static heap_compare_t mq_int_cmp(void * payload, void * payload2)
+{
+    int val1 = * (int *)payload;
+    int val2 = * (int *)payload2;
+
+    if (val1 > val2)
+    {
+        return HEAP_GT;
+    }
+    else if (val1 < val2)
+    {
+        return HEAP_LT;
+    }
+    return HEAP_EQ;
+}
+
+// With a single queue the multi queue is an exact priority queue
+TEST(HeapMultiQueue, SingleQueueIsExact)
+{
+    heap_mq_t * mq = heap_mq_init(1, MIN_HEAP, HEAP_MEM, sizeof(int),
+                                  nullptr, mq_int_cmp);
+    ASSERT_NE(mq, nullptr);
+
+    std::vector<int> values = {9, 4, 7, 1, 8, 2, 6, 3, 5, 0};
+    for (int value: values)
+    {
+        EXPECT_TRUE(heap_mq_insert(mq, &value));
+    }
+    EXPECT_EQ(heap_mq_get_length(mq), values.size());
+
+    for (int expected = 0; expected < 10; expected++)
+    {
+        int * payload = (int *)heap_mq_pop(mq);
+        ASSERT_NE(payload, nullptr);
+        EXPECT_EQ(* payload, expected);
+        free(payload);
+    }
+    EXPECT_TRUE(heap_mq_is_empty(mq));
+    EXPECT_EQ(heap_mq_pop(mq), nullptr);
+    heap_mq_destroy(mq);
+}
+
+// Items left in the queue are released by the destroy callback
+TEST(HeapMultiQueue, DestroyFreesItems)
+{
+    heap_mq_t * mq = heap_mq_init(4, MAX_HEAP, HEAP_PTR, 0, free, mq_int_cmp);
+    ASSERT_NE(mq, nullptr);
+    EXPECT_EQ(heap_mq_get_queue_count(mq), 4);
+
+    for (int i = 0; i < 32; i++)
+    {
+        int * payload = (int *)malloc(sizeof(int));
+        * payload = i;
+        heap_mq_insert(mq, payload);
+    }
+    EXPECT_EQ(heap_mq_get_length(mq), 32);
+    heap_mq_destroy(mq);
+}
+
+// Producers and consumers running at the same time must see every item
+// exactly once
+TEST(HeapMultiQueue, ConcurrentProducersConsumers)
+{
+    const int thread_count = 4;
+    const int items_per_thread = 5000;
+    const int total = thread_count * items_per_thread;
+
+    heap_mq_t * mq = heap_mq_init(0, MIN_HEAP, HEAP_PTR, 0, free, mq_int_cmp);
+    ASSERT_NE(mq, nullptr);
+
+    std::vector<std::atomic<int>> seen(total);
+    std::atomic<int> popped{0};
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < thread_count; t++)
+    {
+        threads.emplace_back([mq, t, items_per_thread]() {
+            for (int i = 0; i < items_per_thread; i++)
+            {
+                int * payload = (int *)malloc(sizeof(int));
+                * payload = t * items_per_thread + i;
+                heap_mq_insert(mq, payload);
+            }
+        });
+        threads.emplace_back([mq, &seen, &popped, total]() {
+            while (popped.load() < total)
+            {
+                int * payload = (int *)heap_mq_pop(mq);
+                if (nullptr == payload)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                seen[(size_t)* payload]++;
+                popped++;
+                free(payload);
+            }
+        });
+    }
+    for (auto & thread: threads)
+    {
+        thread.join();
+    }
+
+    for (int i = 0; i < total; i++)
+    {
+        EXPECT_EQ(seen[(size_t)i].load(), 1);
+    }
+    EXPECT_TRUE(heap_mq_is_empty(mq));
+    heap_mq_destroy(mq);
+}
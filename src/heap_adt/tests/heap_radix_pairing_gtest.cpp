@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+#include <heap_radix.h>
+#include <heap_pairing.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// Event used by the radix heap tests, the time is the priority
+typedef struct
+{
+    uint64_t time;
+    int id;
+} event_t;
+
+static uint64_t event_key(void * payload)
+{
+    return ((event_t *)payload)->time;
+}
+
+static heap_compare_t int_cmp(void * payload, void * payload2)
+{
+    int val1 = * (int *)payload;
+    int val2 = * (int *)payload2;
+
+    if (val1 > val2)
+    {
+        return HEAP_GT;
+    }
+    else if (val1 < val2)
+    {
+        return HEAP_LT;
+    }
+    return HEAP_EQ;
+}
+
+static int * create_int(int value)
+{
+    int * payload = (int *)malloc(sizeof(int));
+    * payload = value;
+    return payload;
+}
+
+// Simulate an event loop where popped events schedule new events in the
+// future. The pop order must never go back in time.
+TEST(HeapRadix, MonotoneEventLoop)
+{
+    heap_radix_t * heap = heap_radix_init(HEAP_MEM, sizeof(event_t), nullptr,
+                                          event_key);
+    ASSERT_NE(heap, nullptr);
+
+    std::mt19937_64 rng(7);
+    for (int i = 0; i < 100; i++)
+    {
+        event_t event = {rng() % 1000, i};
+        ASSERT_TRUE(heap_radix_insert(heap, &event));
+    }
+
+    uint64_t last = 0;
+    int popped = 0;
+    while (!heap_radix_is_empty(heap))
+    {
+        event_t * peek = (event_t *)heap_radix_peek(heap);
+        event_t * event = (event_t *)heap_radix_pop(heap);
+        ASSERT_NE(event, nullptr);
+        EXPECT_EQ(peek->time, event->time);
+        EXPECT_GE(event->time, last);
+        last = event->time;
+        EXPECT_EQ(heap_radix_get_last_key(heap), last);
+
+        if (popped < 500)
+        {
+            event_t next = {event->time + (rng() % 50), popped};
+            EXPECT_TRUE(heap_radix_insert(heap, &next));
+        }
+        popped++;
+        free(peek);
+        free(event);
+    }
+    EXPECT_EQ(popped, 600);
+    heap_radix_destroy(heap);
+}
+
+// Keys smaller than the last popped key are rejected
+TEST(HeapRadix, RejectNonMonotone)
+{
+    heap_radix_t * heap = heap_radix_init(HEAP_MEM, sizeof(event_t), nullptr,
+                                          event_key);
+    ASSERT_NE(heap, nullptr);
+
+    event_t event = {10, 0};
+    heap_radix_insert(heap, &event);
+    free(heap_radix_pop(heap));
+
+    event_t early = {9, 1};
+    EXPECT_FALSE(heap_radix_insert(heap, &early));
+    EXPECT_TRUE(heap_radix_is_empty(heap));
+    EXPECT_EQ(heap_radix_pop(heap), nullptr);
+    heap_radix_destroy(heap);
+}
+
+// Peeking does not move the last key, so a key between the last popped key
+// and the peeked key can still be inserted and is popped first
+TEST(HeapRadix, PeekKeepsLastKey)
+{
+    heap_radix_t * heap = heap_radix_init(HEAP_MEM, sizeof(event_t), nullptr,
+                                          event_key);
+    ASSERT_NE(heap, nullptr);
+
+    event_t first = {3, 0};
+    ASSERT_TRUE(heap_radix_insert(heap, &first));
+    free(heap_radix_pop(heap));
+
+    event_t late = {10, 1};
+    ASSERT_TRUE(heap_radix_insert(heap, &late));
+    event_t * peek = (event_t *)heap_radix_peek(heap);
+    EXPECT_EQ(peek->time, 10);
+    free(peek);
+    EXPECT_EQ(heap_radix_get_last_key(heap), 3);
+
+    event_t between = {7, 2};
+    EXPECT_TRUE(heap_radix_insert(heap, &between));
+    event_t * event = (event_t *)heap_radix_pop(heap);
+    EXPECT_EQ(event->time, 7);
+    free(event);
+    event = (event_t *)heap_radix_pop(heap);
+    EXPECT_EQ(event->time, 10);
+    free(event);
+    heap_radix_destroy(heap);
+}
+
+// Items still in the heap are freed by the destroy callback in PTR mode
+TEST(HeapRadix, PtrModeDestroy)
+{
+    heap_radix_t * heap = heap_radix_init(HEAP_PTR, 0, free, event_key);
+    ASSERT_NE(heap, nullptr);
+    for (int i = 0; i < 20; i++)
+    {
+        event_t * event = (event_t *)malloc(sizeof(event_t));
+        event->time = (uint64_t)(20 - i);
+        event->id = i;
+        heap_radix_insert(heap, event);
+    }
+    event_t * event = (event_t *)heap_radix_pop(heap);
+    EXPECT_EQ(event->time, 1);
+    free(event);
+    EXPECT_EQ(heap_radix_get_length(heap), 19);
+    heap_radix_destroy(heap);
+}
+
+// Pop order of the pairing heap must match a sorted array for both types
+TEST(HeapPairing, PopOrder)
+{
+    std::vector<int> values(200);
+    std::iota(values.begin(), values.end(), 0);
+    std::shuffle(values.begin(), values.end(), std::mt19937(3));
+
+    heap_pairing_t * min_heap = heap_pairing_init(MIN_HEAP, HEAP_MEM,
+                                                  sizeof(int), nullptr,
+                                                  int_cmp);
+    heap_pairing_t * max_heap = heap_pairing_init(MAX_HEAP, HEAP_PTR, 0,
+                                                  free, int_cmp);
+    ASSERT_NE(min_heap, nullptr);
+    ASSERT_NE(max_heap, nullptr);
+
+    for (int value: values)
+    {
+        EXPECT_TRUE(heap_pairing_insert(min_heap, &value));
+        EXPECT_TRUE(heap_pairing_insert(max_heap, create_int(value)));
+    }
+    EXPECT_EQ(heap_pairing_get_length(min_heap), values.size());
+
+    for (int i = 0; i < 200; i++)
+    {
+        int * low = (int *)heap_pairing_pop(min_heap);
+        int * high = (int *)heap_pairing_pop(max_heap);
+        EXPECT_EQ(* low, i);
+        EXPECT_EQ(* high, 199 - i);
+        free(low);
+        free(high);
+    }
+    EXPECT_TRUE(heap_pairing_is_empty(min_heap));
+    EXPECT_EQ(heap_pairing_pop(min_heap), nullptr);
+
+    heap_pairing_destroy(min_heap);
+    heap_pairing_destroy(max_heap);
+}
+
+// Melding moves every item and empties the donor heap
+TEST(HeapPairing, Meld)
+{
+    heap_pairing_t * left = heap_pairing_init(MIN_HEAP, HEAP_PTR, 0, free,
+                                              int_cmp);
+    heap_pairing_t * right = heap_pairing_init(MIN_HEAP, HEAP_PTR, 0, free,
+                                               int_cmp);
+    for (int i = 0; i < 50; i++)
+    {
+        heap_pairing_insert(left, create_int(i * 2));
+        heap_pairing_insert(right, create_int(i * 2 + 1));
+    }
+
+    // A heap can not be melded into itself
+    EXPECT_FALSE(heap_pairing_meld(left, left));
+    EXPECT_EQ(heap_pairing_get_length(left), 50);
+
+    ASSERT_TRUE(heap_pairing_meld(left, right));
+    EXPECT_TRUE(heap_pairing_is_empty(right));
+    EXPECT_EQ(heap_pairing_get_length(left), 100);
+
+    int * peek = (int *)heap_pairing_peek(left);
+    EXPECT_EQ(* peek, 0);
+    for (int i = 0; i < 60; i++)
+    {
+        int * value = (int *)heap_pairing_pop(left);
+        EXPECT_EQ(* value, i);
+        free(value);
+    }
+
+    // Leave items behind so that destroy has to release them
+    heap_pairing_destroy(left);
+    heap_pairing_destroy(right);
+}
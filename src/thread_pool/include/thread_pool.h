@@ -0,0 +1,34 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stddef.h>
+
+// Mapping to internal structure that manages the worker threads
+typedef struct thread_pool_t thread_pool_t;
+
+// Signature of the work executed by the pool. The task index identifies the
+// piece of work and the thread index is in [0, thread_count) so it can be used
+// to address per thread scratch space.
+typedef void (* thread_pool_task_t)(void * context,
+                                    size_t task_index,
+                                    size_t thread_index);
+
+thread_pool_t * thread_pool_init(size_t thread_count);
+void thread_pool_destroy(thread_pool_t * pool);
+
+void thread_pool_run(thread_pool_t * pool,
+                     size_t task_count,
+                     thread_pool_task_t task,
+                     void * context);
+
+size_t thread_pool_get_thread_count(thread_pool_t * pool);
+size_t thread_pool_get_cpu_count(void);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif //THREAD_POOL_H
@@ -0,0 +1,258 @@
+#include <thread_pool.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct thread_pool_t thread_pool_t;
+
+typedef struct worker_t
+{
+    thread_pool_t * pool;
+    size_t thread_index;
+} worker_t;
+
+typedef struct thread_pool_t
+{
+    pthread_t * threads;
+    worker_t * workers;
+    size_t worker_count;            // Threads created, the caller is the extra one
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;      // Signaled when a new job is published
+    pthread_cond_t work_done;       // Signaled when the last worker finishes
+    uint64_t generation;            // Incremented for every job
+    size_t workers_busy;            // Workers that have not finished the job
+    bool shutdown;
+
+    thread_pool_task_t task;
+    void * context;
+    size_t task_count;
+    atomic_size_t next_task;        // Next task index to hand out
+} thread_pool_t;
+
+static void * worker_loop(void * arg);
+static void run_tasks(thread_pool_t * pool, size_t thread_index);
+
+/*!
+ * @brief Create a pool of worker threads.
+ *
+ * The thread calling thread_pool_run also executes tasks, so a pool with a
+ * thread_count of N creates N - 1 threads. A thread_count of 0 uses the
+ * number of online cpus and a thread_count of 1 runs every task on the
+ * calling thread.
+ *
+ * @param thread_count Total number of threads that execute tasks
+ * @return Pointer to the pool or NULL
+ */
+thread_pool_t * thread_pool_init(size_t thread_count)
+{
+    if (0 == thread_count)
+    {
+        thread_count = thread_pool_get_cpu_count();
+    }
+
+    thread_pool_t * pool = (thread_pool_t *)calloc(1, sizeof(thread_pool_t));
+    if (NULL == pool)
+    {
+        fprintf(stderr, "[!] Could not allocate memory!\n");
+        return NULL;
+    }
+
+    pool->worker_count = thread_count - 1;
+    pool->threads = (pthread_t *)calloc(thread_count, sizeof(pthread_t));
+    pool->workers = (worker_t *)calloc(thread_count, sizeof(worker_t));
+    if ((NULL == pool->threads) || (NULL == pool->workers))
+    {
+        fprintf(stderr, "[!] Could not allocate memory!\n");
+        free(pool->threads);
+        free(pool->workers);
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+    atomic_init(&pool->next_task, 0);
+
+    for (size_t index = 0; index < pool->worker_count; index++)
+    {
+        pool->workers[index] = (worker_t){
+            .pool           = pool,
+            .thread_index   = index + 1
+        };
+        if (0 != pthread_create(&pool->threads[index],
+                                NULL,
+                                worker_loop,
+                                &pool->workers[index]))
+        {
+            // Keep the threads that did start, the pool still works with
+            // fewer workers
+            fprintf(stderr, "[!] Could not create worker thread!\n");
+            pool->worker_count = index;
+            break;
+        }
+    }
+
+    return pool;
+}
+
+/*!
+ * @brief Stop and join the worker threads and free the pool. Must not be
+ * called while a job is running.
+ * @param pool Pointer to the pool
+ */
+void thread_pool_destroy(thread_pool_t * pool)
+{
+    assert(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t index = 0; index < pool->worker_count; index++)
+    {
+        pthread_join(pool->threads[index], NULL);
+    }
+
+    pthread_cond_destroy(&pool->work_done);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool->workers);
+    free(pool);
+}
+
+/*!
+ * @brief Execute task for every index in [0, task_count) across the pool and
+ * wait for all of them to finish. Tasks are handed out dynamically so uneven
+ * tasks balance themselves. The pool runs one job at a time, it must not be
+ * called concurrently or from inside a task.
+ *
+ * @param pool Pointer to the pool
+ * @param task_count Number of tasks to execute
+ * @param task Function executed once per task index
+ * @param context Pointer passed to every task
+ */
+void thread_pool_run(thread_pool_t * pool,
+                     size_t task_count,
+                     thread_pool_task_t task,
+                     void * context)
+{
+    assert(pool);
+    assert(task);
+
+    if (0 == task_count)
+    {
+        return;
+    }
+
+    pool->task = task;
+    pool->context = context;
+    pool->task_count = task_count;
+    atomic_store(&pool->next_task, 0);
+
+    // Nothing to share, skip waking the workers
+    if ((0 == pool->worker_count) || (1 == task_count))
+    {
+        run_tasks(pool, 0);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->workers_busy = pool->worker_count;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_tasks(pool, 0);
+
+    // Wait for every worker to leave the job before the job state is reused
+    pthread_mutex_lock(&pool->lock);
+    while (0 != pool->workers_busy)
+    {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/*!
+ * @brief Return the number of threads that execute tasks, the caller included
+ * @param pool Pointer to the pool
+ * @return Number of threads
+ */
+size_t thread_pool_get_thread_count(thread_pool_t * pool)
+{
+    assert(pool);
+    return pool->worker_count + 1;
+}
+
+/*!
+ * @brief Return the number of online cpus, never less than 1
+ * @return Number of cpus
+ */
+size_t thread_pool_get_cpu_count(void)
+{
+    long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cpu_count > 0) ? (size_t)cpu_count : 1;
+}
+
+/*!
+ * @brief Body of each worker thread. Workers sleep until a new generation is
+ * published, run tasks until none are left and report back.
+ * @param arg Pointer to the worker_t of the thread
+ * @return NULL
+ */
+static void * worker_loop(void * arg)
+{
+    worker_t * worker = (worker_t *)arg;
+    thread_pool_t * pool = worker->pool;
+    uint64_t seen_generation = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (true)
+    {
+        while ((!pool->shutdown) && (seen_generation == pool->generation))
+        {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        if (pool->shutdown)
+        {
+            break;
+        }
+        seen_generation = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_tasks(pool, worker->thread_index);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->workers_busy--;
+        if (0 == pool->workers_busy)
+        {
+            pthread_cond_signal(&pool->work_done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/*!
+ * @brief Claim and run tasks until every task index has been handed out
+ * @param pool Pointer to the pool
+ * @param thread_index Index of the thread running the tasks
+ */
+static void run_tasks(thread_pool_t * pool, size_t thread_index)
+{
+    size_t task_index = atomic_fetch_add(&pool->next_task, 1);
+    while (task_index < pool->task_count)
+    {
+        pool->task(pool->context, task_index, thread_index);
+        task_index = atomic_fetch_add(&pool->next_task, 1);
+    }
+}
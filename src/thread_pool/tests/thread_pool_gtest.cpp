@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <thread_pool.h>
+#include <atomic>
+#include <vector>
+
+typedef struct
+{
+    std::vector<std::atomic<int>> * hits;
+    std::atomic<size_t> * max_thread;
+} hit_context_t;
+
+// Count how often each task index was executed
+static void hit_task(void * context, size_t task_index, size_t thread_index)
+{
+    hit_context_t * hit = (hit_context_t *)context;
+    (* hit->hits)[task_index]++;
+
+    size_t seen = hit->max_thread->load();
+    while ((thread_index > seen)
+        && !hit->max_thread->compare_exchange_weak(seen, thread_index))
+    {
+    }
+}
+
+// Every task index runs exactly once and thread indexes stay in range
+TEST(ThreadPool, EveryTaskRunsOnce)
+{
+    thread_pool_t * pool = thread_pool_init(4);
+    ASSERT_NE(pool, nullptr);
+    EXPECT_EQ(thread_pool_get_thread_count(pool), 4);
+
+    for (size_t round = 0; round < 20; round++)
+    {
+        std::vector<std::atomic<int>> hits(1000);
+        std::atomic<size_t> max_thread{0};
+        hit_context_t context = {&hits, &max_thread};
+
+        thread_pool_run(pool, hits.size(), hit_task, &context);
+
+        for (auto & hit: hits)
+        {
+            EXPECT_EQ(hit.load(), 1);
+        }
+        EXPECT_LT(max_thread.load(), 4);
+    }
+    thread_pool_destroy(pool);
+}
+
+// A single thread pool runs everything on the caller
+TEST(ThreadPool, SingleThread)
+{
+    thread_pool_t * pool = thread_pool_init(1);
+    ASSERT_NE(pool, nullptr);
+
+    std::vector<std::atomic<int>> hits(10);
+    std::atomic<size_t> max_thread{0};
+    hit_context_t context = {&hits, &max_thread};
+    thread_pool_run(pool, hits.size(), hit_task, &context);
+
+    for (auto & hit: hits)
+    {
+        EXPECT_EQ(hit.load(), 1);
+    }
+    EXPECT_EQ(max_thread.load(), 0);
+    thread_pool_destroy(pool);
+}
+
+// Zero threads sizes the pool by the cpu count
+TEST(ThreadPool, DefaultSize)
+{
+    thread_pool_t * pool = thread_pool_init(0);
+    ASSERT_NE(pool, nullptr);
+    EXPECT_EQ(thread_pool_get_thread_count(pool), thread_pool_get_cpu_count());
+    thread_pool_destroy(pool);
+}